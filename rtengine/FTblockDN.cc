@@ -31,6 +31,7 @@
 #include "cplx_wavelet_dec.h"
 #include "color.h"
 #include "curves.h"
+#include "fftwplancache.h"
 #include "iccmatrices.h"
 #include "iccstore.h"
 #include "imagefloat.h"
@@ -77,9 +78,6 @@ namespace rtengine
  */
 
 
-extern MyMutex *fftwMutex;
-
-
 namespace
 {
 
@@ -500,8 +498,6 @@ BENCHFUN
         return;
     }
 
-    MyMutex::MyLock lock(*fftwMutex);
-
     const nrquality nrQuality = (dnparams.smethod == "shal") ? QUALITY_STANDARD : QUALITY_HIGH;//shrink method
     const float qhighFactor = (nrQuality == QUALITY_HIGH) ? 1.f / static_cast<float>(settings->nrhigh) : 1.0f;
     const bool useNoiseCCurve = (noiseCCurve && noiseCCurve.getSum() > 5.f);
@@ -754,27 +750,16 @@ BENCHFUN
             // calculate min size of numblox_W.
             int min_numblox_W = ceil((static_cast<float>((MIN(imwidth, ((numtiles_W - 1) * tileWskip) + tilewidth)) - ((numtiles_W - 1) * tileWskip))) / (offset)) + 2 * blkrad;
 
-            // these are needed only for creation of the plans and will be freed before entering the parallel loop
-            fftwf_plan plan_forward_blox[2] = {};
-            fftwf_plan plan_backward_blox[2] = {};
+            FftwPlanCache::Plan plan_forward_blox[2];
+            FftwPlanCache::Plan plan_backward_blox[2];
 
             if (denoiseLuminance) {
-                float *Lbloxtmp  = reinterpret_cast<float*>(fftwf_malloc(max_numblox_W * TS * TS * sizeof(float)));
-                float *fLbloxtmp = reinterpret_cast<float*>(fftwf_malloc(max_numblox_W * TS * TS * sizeof(float)));
-
-                int nfwd[2] = {TS, TS};
-
-                //for DCT:
-                fftw_r2r_kind fwdkind[2] = {FFTW_REDFT10, FFTW_REDFT10};
-                fftw_r2r_kind bwdkind[2] = {FFTW_REDFT01, FFTW_REDFT01};
-
-                // Creating the plans with FFTW_MEASURE instead of FFTW_ESTIMATE speeds up the execute a bit
-                plan_forward_blox[0]  = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, Lbloxtmp, nullptr, 1, TS * TS, fLbloxtmp, nullptr, 1, TS * TS, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-                plan_backward_blox[0] = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, fLbloxtmp, nullptr, 1, TS * TS, Lbloxtmp, nullptr, 1, TS * TS, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-                plan_forward_blox[1]  = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, Lbloxtmp, nullptr, 1, TS * TS, fLbloxtmp, nullptr, 1, TS * TS, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-                plan_backward_blox[1] = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, fLbloxtmp, nullptr, 1, TS * TS, Lbloxtmp, nullptr, 1, TS * TS, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-                fftwf_free(Lbloxtmp);
-                fftwf_free(fLbloxtmp);
+                // Creating the plans with FFTW_MEASURE instead of FFTW_ESTIMATE speeds up the execute a bit.
+                // The plans are cached and their measurement is kept in the FFTW wisdom, so this is only paid once
+                plan_forward_blox[0]  = FftwPlanCache::r2r2dMany(TS, TS, max_numblox_W, FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+                plan_backward_blox[0] = FftwPlanCache::r2r2dMany(TS, TS, max_numblox_W, FFTW_REDFT01, FFTW_REDFT01, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+                plan_forward_blox[1]  = FftwPlanCache::r2r2dMany(TS, TS, min_numblox_W, FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+                plan_backward_blox[1] = FftwPlanCache::r2r2dMany(TS, TS, min_numblox_W, FFTW_REDFT01, FFTW_REDFT01, FFTW_MEASURE | FFTW_DESTROY_INPUT);
             }
 
 #ifndef _OPENMP
@@ -872,6 +857,10 @@ BENCHFUN
                 for (int tiletop = 0; tiletop < imheight; tiletop += tileHskip) {
                     for (int tileleft = 0; tileleft < imwidth ; tileleft += tileWskip) {
                         //printf("titop=%d tileft=%d\n",tiletop/tileHskip, tileleft/tileWskip);
+                        if (isCancelled()) {
+                            continue;
+                        }
+
                         pos = (tiletop / tileHskip) * numtiles_W + tileleft / tileWskip ;
                         int tileright = MIN(imwidth, tileleft + tilewidth);
                         int tilebottom = MIN(imheight, tiletop + tileheight);
@@ -1350,6 +1339,10 @@ BENCHFUN
 #endif
 
                                     for (int vblk = 0; vblk < numblox_H; ++vblk) {
+                                        if (isCancelled()) {
+                                            continue;
+                                        }
+
 
                                         int top = (vblk - blkrad) * offset;
                                         float * datarow = pBuf + blkrad * offset;
@@ -1756,14 +1749,6 @@ BENCHFUN
                     }
                 }
             }
-
-            if (denoiseLuminance) {
-                // destroy the plans
-                fftwf_destroy_plan(plan_forward_blox[0]);
-                fftwf_destroy_plan(plan_backward_blox[0]);
-                fftwf_destroy_plan(plan_forward_blox[1]);
-                fftwf_destroy_plan(plan_backward_blox[1]);
-            }
         } while (memoryAllocationFailed && numTries < 2 && (options.rgbDenoiseThreadLimit == 0) && !ponder);
 
         if (memoryAllocationFailed) {
@@ -22,6 +22,8 @@
 #include <cstdlib>
 #include <utility>
 
+#include "bufferpool.h"
+
 inline size_t padToAlignment(size_t size, size_t align = 16) {
     return align * ((size + align - 1) / align);
 }
@@ -32,6 +34,7 @@ template <class T> class AlignedBuffer
 
 private:
     void* real ;
+    size_t realSize;
     char alignment;
     size_t allocatedSize;
     int unitSize;
@@ -44,7 +47,7 @@ public:
     * @param size Number of elements of size T to allocate, i.e. allocated size will be sizeof(T)*size ; set it to 0 if you want to defer the allocation
     * @param align Expressed in bytes; SSE instructions need 128 bits alignment, which mean 16 bytes, which is the default value
     */
-    AlignedBuffer (size_t size = 0, size_t align = 16) : real(nullptr), alignment(align), allocatedSize(0), unitSize(0), data(nullptr), inUse(false)
+    AlignedBuffer (size_t size = 0, size_t align = 16) : real(nullptr), realSize(0), alignment(align), allocatedSize(0), unitSize(0), data(nullptr), inUse(false)
     {
         if (size) {
             resize(size);
@@ -53,9 +56,7 @@ public:
 
     ~AlignedBuffer ()
     {
-        if (real) {
-            free(real);
-        }
+        rtengine::BufferPool::deallocate(real, realSize);
     }
 
     /** @brief Return true if there's no memory allocated
@@ -75,46 +76,33 @@ public:
         if (allocatedSize != size) {
             if (!size) {
                 // The user want to free the memory
-                if (real) {
-                    free(real);
-                }
+                rtengine::BufferPool::deallocate(real, realSize);
 
                 real = nullptr;
+                realSize = 0;
                 data = nullptr;
                 inUse = false;
                 allocatedSize = 0;
                 unitSize = 0;
             } else {
                 unitSize = structSize ? structSize : sizeof(T);
-                size_t oldAllocatedSize = allocatedSize;
                 allocatedSize = size * unitSize;
 
-                // realloc were used here to limit memory fragmentation, specially when the size was smaller than the previous one.
-                // But realloc copies the content to the eventually new location, which is unnecessary. To avoid this performance penalty,
-                // we're freeing the memory and allocate it again if the new size is bigger.
-
-                if (allocatedSize < oldAllocatedSize) {
-                    void *temp = realloc(real, allocatedSize + alignment);
-                    if (temp) { // realloc succeeded
-                        real = temp;
-                    } else { // realloc failed => free old buffer and allocate new one
-                        if (real) {
-                            free (real);
-                        }
-                        real = malloc(allocatedSize + alignment);
-                    }
-                } else {
-                    if (real) {
-                        free (real);
-                    }
+                // The memory comes from the buffer pool, which limits the fragmentation and hands out already mapped
+                // pages. The block is kept when the new size is smaller but not less than half of it, otherwise it is
+                // given back to the pool: its content doesn't need to be preserved.
 
-                    real = malloc(allocatedSize + alignment);
+                if (!real || allocatedSize + alignment > realSize || 2 * (allocatedSize + alignment) < realSize) {
+                    rtengine::BufferPool::deallocate(real, realSize);
+                    realSize = allocatedSize + alignment;
+                    real = rtengine::BufferPool::allocate(realSize);
                 }
 
                 if (real) {
                     data = (T*)( ( uintptr_t(real) + uintptr_t(alignment - 1)) / alignment * alignment);
                     inUse = true;
                 } else {
+                    realSize = 0;
                     allocatedSize = 0;
                     unitSize = 0;
                     data = nullptr;
@@ -130,6 +118,7 @@ public:
     void swap(AlignedBuffer<T> &other)
     {
         std::swap(real, other.real);
+        std::swap(realSize, other.realSize);
         std::swap(alignment, other.alignment);
         std::swap(allocatedSize, other.allocatedSize);
         std::swap(data, other.data);
@@ -0,0 +1,182 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "bufferpool.h"
+#include "rtgui/threadutils.h"
+
+namespace
+{
+
+struct Pool {
+    MyMutex mutex;
+    std::map<std::size_t, std::vector<void*>> freeBlocks; // by bucket size
+    std::size_t capacity = 0;
+    std::size_t cachedBytes = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+};
+
+// never destroyed, as image buffers of static objects may be released after the end of main()
+Pool& pool()
+{
+    static Pool* const instance = new Pool;
+    return *instance;
+}
+
+// 8 buckets per power of two, so at most 12.5% of a block is wasted
+std::size_t bucketSize(std::size_t size)
+{
+    int log2 = 0;
+
+    while ((size >> log2) > 1) {
+        ++log2;
+    }
+
+    const std::size_t granularity = std::size_t(1) << (log2 - 3);
+    return (size + granularity - 1) & ~(granularity - 1);
+}
+
+// releases cached blocks until bytes more can be cached, the caller holds the mutex
+void makeRoom(Pool& p, std::size_t bytes)
+{
+    auto it = p.freeBlocks.begin();
+
+    while (p.cachedBytes + bytes > p.capacity && it != p.freeBlocks.end()) {
+        while (!it->second.empty() && p.cachedBytes + bytes > p.capacity) {
+            std::free(it->second.back());
+            it->second.pop_back();
+            p.cachedBytes -= it->first;
+        }
+
+        it = it->second.empty() ? p.freeBlocks.erase(it) : std::next(it);
+    }
+}
+
+}
+
+namespace rtengine
+{
+
+void* BufferPool::allocate(std::size_t size)
+{
+    if (size < minPooledSize) {
+        return std::malloc(size);
+    }
+
+    // always the bucket size, so that any block can be cached when it is released
+    const std::size_t bucket = bucketSize(size);
+    Pool& p = pool();
+
+    {
+        MyMutex::MyLock lock(p.mutex);
+
+        if (p.capacity != 0) {
+            const auto it = p.freeBlocks.find(bucket);
+
+            if (it != p.freeBlocks.end() && !it->second.empty()) {
+                void* const ptr = it->second.back();
+                it->second.pop_back();
+                p.cachedBytes -= bucket;
+                ++p.hits;
+                return ptr;
+            }
+
+            ++p.misses;
+        }
+    }
+
+    void* ptr = std::malloc(bucket);
+
+    if (!ptr) {
+        // the cached blocks may be what is missing
+        trim();
+        ptr = std::malloc(bucket);
+    }
+
+    return ptr;
+}
+
+void BufferPool::deallocate(void* ptr, std::size_t size)
+{
+    if (!ptr) {
+        return;
+    }
+
+    if (size >= minPooledSize) {
+        const std::size_t bucket = bucketSize(size);
+        Pool& p = pool();
+        MyMutex::MyLock lock(p.mutex);
+
+        if (bucket <= p.capacity) {
+            makeRoom(p, bucket);
+            p.freeBlocks[bucket].push_back(ptr);
+            p.cachedBytes += bucket;
+            return;
+        }
+    }
+
+    std::free(ptr);
+}
+
+void BufferPool::setCapacity(std::size_t bytes)
+{
+    Pool& p = pool();
+    MyMutex::MyLock lock(p.mutex);
+    p.capacity = bytes;
+    makeRoom(p, 0);
+}
+
+void BufferPool::trim()
+{
+    Pool& p = pool();
+    MyMutex::MyLock lock(p.mutex);
+
+    for (auto& bucket : p.freeBlocks) {
+        for (auto ptr : bucket.second) {
+            std::free(ptr);
+        }
+    }
+
+    p.freeBlocks.clear();
+    p.cachedBytes = 0;
+}
+
+BufferPool::Stats BufferPool::getStats()
+{
+    Pool& p = pool();
+    MyMutex::MyLock lock(p.mutex);
+    return {p.hits, p.misses, p.cachedBytes};
+}
+
+void BufferPool::printStats()
+{
+    const Stats stats = getStats();
+    const std::uint64_t requests = stats.hits + stats.misses;
+
+    printf("Buffer pool: %llu hits, %llu misses (%.1f%% hit rate), %zu MiB cached\n",
+           static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+           requests ? 100.0 * stats.hits / requests : 0.0, stats.cachedBytes >> 20);
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace rtengine
+{
+
+/**
+ * Thread-safe pool of the large memory blocks of the image buffers: AlignedBuffer (hence Imagefloat and the other
+ * planar images), LabImage and array2D.
+ *
+ * Released blocks are kept in buckets of similar sizes, up to the capacity set with setCapacity(), and handed out
+ * again to the next request of the same bucket. In a batch or while editing, the buffers of a job reuse the pages
+ * already mapped by the previous one instead of going through mmap/munmap and page faults again.
+ * Blocks smaller than minPooledSize, and all blocks while the capacity is 0, go straight to malloc/free.
+ */
+class BufferPool
+{
+public:
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::size_t cachedBytes;
+    };
+
+    static constexpr std::size_t minPooledSize = 1 << 20;
+
+    /** @return a block of at least size bytes with the alignment of malloc, or nullptr */
+    static void* allocate(std::size_t size);
+    /** Gives back a block returned by allocate(), size being the one given to allocate() */
+    static void deallocate(void* ptr, std::size_t size);
+
+    /** Sets the maximum amount of memory kept for reuse, releasing the blocks above it */
+    static void setCapacity(std::size_t bytes);
+    /** Releases all the blocks kept for reuse */
+    static void trim();
+
+    static Stats getStats();
+    /** Prints the hit rate of the pool on stdout */
+    static void printStats();
+};
+
+/** Allocator drawing the storage of the standard containers from the BufferPool */
+template<typename T>
+class PooledAllocator
+{
+public:
+    using value_type = T;
+
+    PooledAllocator() = default;
+
+    template<typename U>
+    PooledAllocator(const PooledAllocator<U>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        void* const ptr = BufferPool::allocate(n * sizeof(T));
+
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, std::size_t n)
+    {
+        BufferPool::deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+bool operator ==(const PooledAllocator<T>&, const PooledAllocator<U>&)
+{
+    return true;
+}
+
+template<typename T, typename U>
+bool operator !=(const PooledAllocator<T>&, const PooledAllocator<U>&)
+{
+    return false;
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+
+#include "noncopyable.h"
+
+namespace rtengine
+{
+
+/**
+ * @brief Flag asking the long running kernels to stop early.
+ *
+ * The kernels poll it between tiles or rows and skip the remaining work once it is set, leaving their output
+ * buffers in an undefined state: whoever cancels has to recompute what the cancelled run was computing.
+ */
+class CancellationToken :
+    public NonCopyable
+{
+public:
+    CancellationToken() : cancelled(false) {}
+
+    void cancel()
+    {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        cancelled.store(false, std::memory_order_relaxed);
+    }
+
+    bool isCancelled() const
+    {
+        return cancelled.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<bool> cancelled;
+};
+
+}
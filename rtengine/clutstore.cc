@@ -18,10 +18,13 @@
 namespace
 {
 
+// Level of the CLUTs stored as float, bigger ones are kept in 16 bit to halve their memory use
+constexpr unsigned int MAX_FLOAT_CLUT_LEVEL = 64;
+
 bool loadFile(
     const Glib::ustring& filename,
     const Glib::ustring& working_color_space,
-    AlignedBuffer<std::uint16_t>& clut_image,
+    std::unique_ptr<rtengine::Imagefloat>& clut_image,
     unsigned int& clut_level
 )
 {
@@ -51,67 +54,173 @@ bool loadFile(
 
     if (res) {
         rtengine::ColorTemp curr_wb = img_src.getWB();
-        std::unique_ptr<rtengine::Imagefloat> img_float = std::unique_ptr<rtengine::Imagefloat>(new rtengine::Imagefloat(fw, fh));
+        clut_image.reset(new rtengine::Imagefloat(fw, fh));
         const PreviewProps pp(0, 0, fw, fh, 1);
 
         rtengine::procparams::ColorManagementParams icm;
         icm.workingProfile = working_color_space;
 
-        img_src.getImage(curr_wb, TR_NONE, img_float.get(), pp, rtengine::procparams::ToneCurveParams(), rtengine::procparams::RAWParams());
+        img_src.getImage(curr_wb, TR_NONE, clut_image.get(), pp, rtengine::procparams::ToneCurveParams(), rtengine::procparams::RAWParams());
 
         if (!working_color_space.empty()) {
-            img_src.convertColorSpace(img_float.get(), icm, curr_wb);
+            img_src.convertColorSpace(clut_image.get(), icm, curr_wb);
         }
+    }
 
-        AlignedBuffer<std::uint16_t> image(fw * fh * 4 + 4); // getClutValues() loads one pixel in advance
-
-        std::size_t index = 0;
+    return res;
+}
 
-        for (int y = 0; y < fh; ++y) {
-            for (int x = 0; x < fw; ++x) {
-                image.data[index] = img_float->r(y, x);
-                ++index;
-                image.data[index] = img_float->g(y, x);
-                ++index;
-                image.data[index] = img_float->b(y, x);
-                index += 2;
-            }
+// Copies the nodes of the Hald image as RGBX, so that a node is a single aligned load
+template<typename T>
+void storeNodes(const rtengine::Imagefloat& image, AlignedBuffer<T>& nodes)
+{
+    const int width = image.getWidth();
+    const int height = image.getHeight();
+
+    AlignedBuffer<T> buffer(static_cast<std::size_t>(width) * height * 4);
+
+    std::size_t index = 0;
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            buffer.data[index] = image.r(y, x);
+            ++index;
+            buffer.data[index] = image.g(y, x);
+            ++index;
+            buffer.data[index] = image.b(y, x);
+            ++index;
+            buffer.data[index] = 0;
+            ++index;
         }
-
-        clut_image.swap(image);
     }
 
-    return res;
+    nodes.swap(buffer);
 }
 
 #ifdef __SSE2__
-vfloat2 getClutValues(const AlignedBuffer<std::uint16_t>& clut_image, size_t index)
+inline vfloat getClutNode(const float* clut, std::size_t index)
+{
+    return LVF(clut[index]);
+}
+
+inline vfloat getClutNode(const std::uint16_t* clut, std::size_t index)
 {
-    const vint v_values = _mm_loadu_si128(reinterpret_cast<const vint*>(clut_image.data + index));
-#ifdef __SSE4_1__
-    return {
-        _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v_values)),
-        _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v_values, 8)))
-    };
+    const vint v_values = _mm_loadl_epi64(reinterpret_cast<const vint*>(clut + index));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v_values, _mm_setzero_si128()));
+}
+#endif
+
+// Tetrahedral interpolation: the cube around the color is split in 6 tetrahedra along its neutral diagonal, and the
+// color is interpolated from the 4 vertices of the one containing it, instead of the 8 vertices of the cube
+template<typename T>
+void interpolateTetrahedral(
+    const T* clut,
+    unsigned int level,
+    float flevel_minus_one,
+    float flevel_minus_two,
+    float strength,
+    std::size_t line_size,
+    const float* r,
+    const float* g,
+    const float* b,
+    float* out_rgbx
+)
+{
+    const std::size_t red_step = 4;
+    const std::size_t green_step = 4 * level;
+    const std::size_t blue_step = 4 * level * level;
+
+#ifdef __SSE2__
+    const vfloat v_strength = F2V(strength);
+#endif
+
+    for (std::size_t column = 0; column < line_size; ++column, ++r, ++g, ++b, out_rgbx += 4) {
+        const float fred = *r * flevel_minus_one;
+        const float fgreen = *g * flevel_minus_one;
+        const float fblue = *b * flevel_minus_one;
+
+        const unsigned int red = std::min(flevel_minus_two, fred);
+        const unsigned int green = std::min(flevel_minus_two, fgreen);
+        const unsigned int blue = std::min(flevel_minus_two, fblue);
+
+        const float re = fred - red;
+        const float gr = fgreen - green;
+        const float bl = fblue - blue;
+
+        // Offsets of the second and third vertices, weights of the last three ones
+        std::size_t first;
+        std::size_t second;
+        float w1;
+        float w2;
+        float w3;
+
+        if (re > gr) {
+            if (gr > bl) {
+                first = red_step;
+                second = red_step + green_step;
+                w1 = re;
+                w2 = gr;
+                w3 = bl;
+            } else if (re > bl) {
+                first = red_step;
+                second = red_step + blue_step;
+                w1 = re;
+                w2 = bl;
+                w3 = gr;
+            } else {
+                first = blue_step;
+                second = blue_step + red_step;
+                w1 = bl;
+                w2 = re;
+                w3 = gr;
+            }
+        } else if (bl > gr) {
+            first = blue_step;
+            second = blue_step + green_step;
+            w1 = bl;
+            w2 = gr;
+            w3 = re;
+        } else if (bl > re) {
+            first = green_step;
+            second = green_step + blue_step;
+            w1 = gr;
+            w2 = bl;
+            w3 = re;
+        } else {
+            first = green_step;
+            second = green_step + red_step;
+            w1 = gr;
+            w2 = re;
+            w3 = bl;
+        }
+
+        const std::size_t index = (red + green * level + blue * level * level) * 4;
+        const std::size_t last = red_step + green_step + blue_step;
+
+#ifdef __SSE2__
+        const vfloat v_c0 = getClutNode(clut, index);
+        const vfloat v_c1 = getClutNode(clut, index + first);
+        const vfloat v_c2 = getClutNode(clut, index + second);
+        const vfloat v_c3 = getClutNode(clut, index + last);
+
+        const vfloat v_out = v_c0 + F2V(w1) * (v_c1 - v_c0) + F2V(w2) * (v_c2 - v_c1) + F2V(w3) * (v_c3 - v_c2);
+        const vfloat v_in = _mm_set_ps(0.0f, *b, *g, *r);
+
+        STVF(*out_rgbx, vintpf(v_strength, v_out, v_in));
 #else
-    const vint v_mask = _mm_set1_epi32(0x0000FFFF);
-
-    vint v_low = _mm_shuffle_epi32(v_values, _MM_SHUFFLE(1, 0, 1, 0));
-    vint v_high = _mm_shuffle_epi32(v_values, _MM_SHUFFLE(3, 2, 3, 2));
-    v_low = _mm_shufflelo_epi16(v_low, _MM_SHUFFLE(1, 1, 0, 0));
-    v_high = _mm_shufflelo_epi16(v_high, _MM_SHUFFLE(1, 1, 0, 0));
-    v_low = _mm_shufflehi_epi16(v_low, _MM_SHUFFLE(3, 3, 2, 2));
-    v_high = _mm_shufflehi_epi16(v_high, _MM_SHUFFLE(3, 3, 2, 2));
-    v_low = vandm(v_low, v_mask);
-    v_high = vandm(v_high, v_mask);
-
-    return {
-        _mm_cvtepi32_ps(v_low),
-        _mm_cvtepi32_ps(v_high)
-    };
+        const float in[3] = {*r, *g, *b};
+
+        for (int c = 0; c < 3; ++c) {
+            const float c0 = clut[index + c];
+            const float c1 = clut[index + first + c];
+            const float c2 = clut[index + second + c];
+            const float c3 = clut[index + last + c];
+
+            out_rgbx[c] = rtengine::intp<float>(strength, c0 + w1 * (c1 - c0) + w2 * (c2 - c1) + w3 * (c3 - c2), in[c]);
+        }
 #endif
+    }
 }
-#endif
 
 }
 
@@ -129,12 +238,21 @@ rtengine::HaldCLUT::~HaldCLUT()
 
 bool rtengine::HaldCLUT::load(const Glib::ustring& filename)
 {
-    if (loadFile(filename, "", clut_image, clut_level)) {
+    std::unique_ptr<Imagefloat> image;
+
+    if (loadFile(filename, "", image, clut_level)) {
         Glib::ustring name, ext;
         splitClutFilename(filename, name, ext, clut_profile);
 
         clut_filename = filename;
         clut_level *= clut_level;
+
+        if (clut_level <= MAX_FLOAT_CLUT_LEVEL) {
+            storeNodes(*image, clut_image_float);
+        } else {
+            storeNodes(*image, clut_image);
+        }
+
         flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
         flevel_minus_two = static_cast<float>(clut_level - 2);
         return true;
@@ -145,7 +263,7 @@ bool rtengine::HaldCLUT::load(const Glib::ustring& filename)
 
 rtengine::HaldCLUT::operator bool() const
 {
-    return !clut_image.isEmpty();
+    return !clut_image.isEmpty() || !clut_image_float.isEmpty();
 }
 
 Glib::ustring rtengine::HaldCLUT::getFilename() const
@@ -167,106 +285,10 @@ void rtengine::HaldCLUT::getRGB(
     float* out_rgbx
 ) const
 {
-    const unsigned int level = clut_level; // This is important
-
-    const unsigned int level_square = level * level;
-
-#ifdef __SSE2__
-    const vfloat v_strength = F2V(strength);
-#endif
-
-    for (std::size_t column = 0; column < line_size; ++column, ++r, ++g, ++b, out_rgbx += 4) {
-        const unsigned int red = std::min(flevel_minus_two, *r * flevel_minus_one);
-        const unsigned int green = std::min(flevel_minus_two, *g * flevel_minus_one);
-        const unsigned int blue = std::min(flevel_minus_two, *b * flevel_minus_one);
-
-        const unsigned int color = red + green * level + blue * level_square;
-
-#ifndef __SSE2__
-        const float re = *r * flevel_minus_one - red;
-        const float gr = *g * flevel_minus_one - green;
-        const float bl = *b * flevel_minus_one - blue;
-
-        size_t index = color * 4;
-
-        float tmp1[4] ALIGNED16;
-        tmp1[0] = intp<float>(re, clut_image.data[index + 4], clut_image.data[index]);
-        tmp1[1] = intp<float>(re, clut_image.data[index + 5], clut_image.data[index + 1]);
-        tmp1[2] = intp<float>(re, clut_image.data[index + 6], clut_image.data[index + 2]);
-
-        index = (color + level) * 4;
-
-        float tmp2[4] ALIGNED16;
-        tmp2[0] = intp<float>(re, clut_image.data[index + 4], clut_image.data[index]);
-        tmp2[1] = intp<float>(re, clut_image.data[index + 5], clut_image.data[index + 1]);
-        tmp2[2] = intp<float>(re, clut_image.data[index + 6], clut_image.data[index + 2]);
-
-        out_rgbx[0] = intp<float>(gr, tmp2[0], tmp1[0]);
-        out_rgbx[1] = intp<float>(gr, tmp2[1], tmp1[1]);
-        out_rgbx[2] = intp<float>(gr, tmp2[2], tmp1[2]);
-
-        index = (color + level_square) * 4;
-
-        tmp1[0] = intp<float>(re, clut_image.data[index + 4], clut_image.data[index]);
-        tmp1[1] = intp<float>(re, clut_image.data[index + 5], clut_image.data[index + 1]);
-        tmp1[2] = intp<float>(re, clut_image.data[index + 6], clut_image.data[index + 2]);
-
-        index = (color + level + level_square) * 4;
-
-        tmp2[0] = intp<float>(re, clut_image.data[index + 4], clut_image.data[index]);
-        tmp2[1] = intp<float>(re, clut_image.data[index + 5], clut_image.data[index + 1]);
-        tmp2[2] = intp<float>(re, clut_image.data[index + 6], clut_image.data[index + 2]);
-
-        tmp1[0] = intp<float>(gr, tmp2[0], tmp1[0]);
-        tmp1[1] = intp<float>(gr, tmp2[1], tmp1[1]);
-        tmp1[2] = intp<float>(gr, tmp2[2], tmp1[2]);
-
-        out_rgbx[0] = intp<float>(bl, tmp1[0], out_rgbx[0]);
-        out_rgbx[1] = intp<float>(bl, tmp1[1], out_rgbx[1]);
-        out_rgbx[2] = intp<float>(bl, tmp1[2], out_rgbx[2]);
-
-        out_rgbx[0] = intp<float>(strength, out_rgbx[0], *r);
-        out_rgbx[1] = intp<float>(strength, out_rgbx[1], *g);
-        out_rgbx[2] = intp<float>(strength, out_rgbx[2], *b);
-#else
-        const vfloat v_in = _mm_set_ps(0.0f, *b, *g, *r);
-        const vfloat v_tmp = v_in * F2V(flevel_minus_one);
-        const vfloat v_rgb = v_tmp - _mm_cvtepi32_ps(_mm_cvttps_epi32(vminf(v_tmp, F2V(flevel_minus_two))));
-
-        size_t index = color * 4;
-
-        const vfloat v_r = PERMUTEPS(v_rgb, _MM_SHUFFLE(0, 0, 0, 0));
-
-        vfloat2 v_clut_values = getClutValues(clut_image, index);
-        vfloat v_tmp1 = vintpf(v_r, v_clut_values.y, v_clut_values.x);
-
-        index = (color + level) * 4;
-
-        v_clut_values = getClutValues(clut_image, index);
-        vfloat v_tmp2 = vintpf(v_r, v_clut_values.y, v_clut_values.x);
-
-        const vfloat v_g = PERMUTEPS(v_rgb, _MM_SHUFFLE(1, 1, 1, 1));
-
-        vfloat v_out = vintpf(v_g, v_tmp2, v_tmp1);
-
-        index = (color + level_square) * 4;
-
-        v_clut_values = getClutValues(clut_image, index);
-        v_tmp1 = vintpf(v_r, v_clut_values.y, v_clut_values.x);
-
-        index = (color + level + level_square) * 4;
-
-        v_clut_values = getClutValues(clut_image, index);
-        v_tmp2 = vintpf(v_r, v_clut_values.y, v_clut_values.x);
-
-        v_tmp1 = vintpf(v_g, v_tmp2, v_tmp1);
-
-        const vfloat v_b = PERMUTEPS(v_rgb, _MM_SHUFFLE(2, 2, 2, 2));
-
-        v_out = vintpf(v_b, v_tmp1, v_out);
-
-        STVF(*out_rgbx, vintpf(v_strength, v_out, v_in));
-#endif
+    if (!clut_image_float.isEmpty()) {
+        interpolateTetrahedral(clut_image_float.data, clut_level, flevel_minus_one, flevel_minus_two, strength, line_size, r, g, b, out_rgbx);
+    } else {
+        interpolateTetrahedral(clut_image.data, clut_level, flevel_minus_one, flevel_minus_two, strength, line_size, r, g, b, out_rgbx);
     }
 }
 
@@ -317,10 +339,17 @@ std::shared_ptr<rtengine::HaldCLUT> rtengine::CLUTStore::getClut(const Glib::ust
 {
     std::shared_ptr<rtengine::HaldCLUT> result;
 
-    const Glib::ustring full_filename =
-        !Glib::path_is_absolute(filename)
-            ? Glib::ustring(Glib::build_filename(options.clutsDir, filename))
-            : filename;
+    const Glib::ustring full_filename = getFullFilename(filename);
+
+    {
+        MyMutex::MyLock lock(preloadedMutex);
+
+        const auto iterator = preloaded.find(full_filename);
+
+        if (iterator != preloaded.end() && iterator->second.clut) {
+            return iterator->second.clut;
+        }
+    }
 
     if (!cache.get(full_filename, result)) {
         std::unique_ptr<rtengine::HaldCLUT> clut(new rtengine::HaldCLUT);
@@ -331,14 +360,64 @@ std::shared_ptr<rtengine::HaldCLUT> rtengine::CLUTStore::getClut(const Glib::ust
         }
     }
 
+    if (result) {
+        MyMutex::MyLock lock(preloadedMutex);
+
+        const auto iterator = preloaded.find(full_filename);
+
+        if (iterator != preloaded.end() && !iterator->second.clut) {
+            iterator->second.clut = result;
+        }
+    }
+
     return result;
 }
 
+void rtengine::CLUTStore::preload(const Glib::ustring& filename)
+{
+    {
+        MyMutex::MyLock lock(preloadedMutex);
+
+        ++preloaded[getFullFilename(filename)].count;
+    }
+
+    // Decoded here rather than by the first job using it, getClut() keeps it in the preloaded entry
+    getClut(filename);
+}
+
+void rtengine::CLUTStore::release(const Glib::ustring& filename)
+{
+    MyMutex::MyLock lock(preloadedMutex);
+
+    const auto iterator = preloaded.find(getFullFilename(filename));
+
+    if (iterator != preloaded.end() && --iterator->second.count == 0) {
+        preloaded.erase(iterator);
+    }
+}
+
+bool rtengine::CLUTStore::isPreloaded(const Glib::ustring& filename) const
+{
+    const Glib::ustring full_filename = getFullFilename(filename);
+
+    MyMutex::MyLock lock(preloadedMutex);
+
+    return preloaded.find(full_filename) != preloaded.end();
+}
+
 void rtengine::CLUTStore::clearCache()
 {
     cache.clear();
 }
 
+Glib::ustring rtengine::CLUTStore::getFullFilename(const Glib::ustring& filename) const
+{
+    return
+        !Glib::path_is_absolute(filename)
+            ? Glib::ustring(Glib::build_filename(options.clutsDir, filename))
+            : filename;
+}
+
 rtengine::CLUTStore::CLUTStore() :
     cache(options.clutCacheSize)
 {
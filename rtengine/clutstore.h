@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <memory>
 #include <cstdint>
 
@@ -42,7 +43,8 @@ public:
     );
 
 private:
-    AlignedBuffer<std::uint16_t> clut_image;
+    AlignedBuffer<std::uint16_t> clut_image; // RGBX nodes of the big CLUTs
+    AlignedBuffer<float> clut_image_float; // RGBX nodes of the CLUTs up to level 64
     unsigned int clut_level;
     float flevel_minus_one;
     float flevel_minus_two;
@@ -58,12 +60,28 @@ public:
 
     std::shared_ptr<HaldCLUT> getClut(const Glib::ustring& filename) const;
 
+    /** Keeps the CLUT loaded until release() whatever the cache size, so that the jobs of a batch using it share one
+      * decoded copy. Calls are counted. The CLUT is decoded right away if it isn't in the cache yet. */
+    void preload(const Glib::ustring& filename);
+    void release(const Glib::ustring& filename);
+    bool isPreloaded(const Glib::ustring& filename) const;
+
+    /** Empties the cache, the preloaded CLUTs are kept */
     void clearCache();
 
 private:
+    struct Preloaded {
+        std::shared_ptr<HaldCLUT> clut;
+        unsigned int count;
+    };
+
     CLUTStore();
 
+    Glib::ustring getFullFilename(const Glib::ustring& filename) const;
+
     mutable Cache<Glib::ustring, std::shared_ptr<HaldCLUT>> cache;
+    mutable std::map<Glib::ustring, Preloaded> preloaded;
+    mutable MyMutex preloadedMutex;
 };
 
 }
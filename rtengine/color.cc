@@ -1787,6 +1787,92 @@ void Color::RGB2Lab(float *R, float *G, float *B, float *L, float *a, float *b,
     }
 }
 
+void Color::XYZ2Lab(const float *X, const float *Y, const float *Z, float *L, float *a, float *b, int width)
+{
+
+    int i = 0;
+
+#ifdef __SSE2__
+    const vfloat maxvalfv = F2V(MAXVALF);
+    const vfloat c500v = F2V(500.f);
+    const vfloat c200v = F2V(200.f);
+    const vfloat D50xv = F2V(D50x);
+    const vfloat D50zv = F2V(D50z);
+
+    for(; i < width - 3; i += 4) {
+        const vfloat xv = LVFU(X[i]) / D50xv;
+        const vfloat yv = LVFU(Y[i]);
+        const vfloat zv = LVFU(Z[i]) / D50zv;
+
+        if (_mm_movemask_ps((vfloat)vorm(vmaskf_gt(vmaxf(xv, vmaxf(yv, zv)), maxvalfv), vmaskf_lt(vminf(xv, vminf(yv, zv)), ZEROV)))) {
+            // take slower code path for all 4 pixels if one of the values is out of the lut range
+            for(int k = 0; k < 4; ++k) {
+                XYZ2Lab(X[i + k], Y[i + k], Z[i + k], L[i + k], a[i + k], b[i + k]);
+            }
+        } else {
+            const vfloat fx = cachef[xv];
+            const vfloat fy = cachef[yv];
+            const vfloat fz = cachef[zv];
+
+            STVFU(L[i], cachefy[yv]);
+            STVFU(a[i], c500v * (fx - fy));
+            STVFU(b[i], c200v * (fy - fz));
+        }
+    }
+#endif
+    for(; i < width; ++i) {
+        XYZ2Lab(X[i], Y[i], Z[i], L[i], a[i], b[i]);
+    }
+}
+
+void Color::Lab2XYZ(const float *L, const float *a, const float *b, float *X, float *Y, float *Z, int width)
+{
+
+    int i = 0;
+
+#ifdef __SSE2__
+    for(; i < width - 3; i += 4) {
+        vfloat Xv, Yv, Zv;
+        Lab2XYZ(LVFU(L[i]), LVFU(a[i]), LVFU(b[i]), Xv, Yv, Zv);
+        STVFU(X[i], Xv);
+        STVFU(Y[i], Yv);
+        STVFU(Z[i], Zv);
+    }
+#endif
+    for(; i < width; ++i) {
+        Lab2XYZ(L[i], a[i], b[i], X[i], Y[i], Z[i]);
+    }
+}
+
+void Color::Lab2RGB(const float *L, const float *a, const float *b, float *R, float *G, float *B, const float wip[3][3], int width)
+{
+
+    int i = 0;
+
+#ifdef __SSE2__
+    const vfloat wipv[3][3] = {
+                               {F2V(wip[0][0]), F2V(wip[0][1]), F2V(wip[0][2])},
+                               {F2V(wip[1][0]), F2V(wip[1][1]), F2V(wip[1][2])},
+                               {F2V(wip[2][0]), F2V(wip[2][1]), F2V(wip[2][2])}
+                              };
+
+    for(; i < width - 3; i += 4) {
+        vfloat Xv, Yv, Zv;
+        Lab2XYZ(LVFU(L[i]), LVFU(a[i]), LVFU(b[i]), Xv, Yv, Zv);
+        vfloat Rv, Gv, Bv;
+        xyz2rgb(Xv, Yv, Zv, Rv, Gv, Bv, wipv);
+        STVFU(R[i], Rv);
+        STVFU(G[i], Gv);
+        STVFU(B[i], Bv);
+    }
+#endif
+    for(; i < width; ++i) {
+        float X, Y, Z;
+        Lab2XYZ(L[i], a[i], b[i], X, Y, Z);
+        xyz2rgb(X, Y, Z, R[i], G[i], B[i], wip);
+    }
+}
+
 void Color::RGB2L(const float *R, const float *G, const float *B, float *L, const float wp[3][3], int width)
 {
 
@@ -669,7 +669,16 @@ static inline void Lab2XYZ(vfloat L, vfloat a, vfloat b, vfloat &x, vfloat &y, v
     * @param b channel [-42000 ; +42000] ; can be more than 42000 (return value)
     */
     static void XYZ2Lab(float x, float y, float z, float &L, float &a, float &b);
+
+    /**
+    * @brief Row versions of the conversions, vectorized when possible. Output and input rows may be the same.
+    * RGB2Lab and RGB2L expect the rows of the working space matrix wp already divided by D50x, 1 and D50z,
+    * Lab2RGB the inverse working space matrix.
+    */
+    static void XYZ2Lab(const float *X, const float *Y, const float *Z, float *L, float *a, float *b, int width);
+    static void Lab2XYZ(const float *L, const float *a, const float *b, float *X, float *Y, float *Z, int width);
     static void RGB2Lab(float *X, float *Y, float *Z, float *L, float *a, float *b, const float wp[3][3], int width);
+    static void Lab2RGB(const float *L, const float *a, const float *b, float *R, float *G, float *B, const float wip[3][3], int width);
     static void Lab2RGBLimit(float *L, float *a, float *b, float *R, float *G, float *B, const float wp[3][3], float limit, float afactor, float bfactor, int width);
     static void RGB2L(const float *R, const float *G, const float *B, float *L, const float wp[3][3], int width);
 
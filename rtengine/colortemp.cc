@@ -17,6 +17,11 @@
  *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
 #include <glibmm/ustring.h>
 
 #include "colortemp.h"
@@ -5287,6 +5292,25 @@ double ColorTemp::daylight_spect(double wavelength, double m1, double m2)
 
 
 
+namespace
+{
+
+// XYZ of the ITC reference colors and white point for one temperature
+struct ItcSpectralData {
+    double wpx;
+    double wpz;
+    std::vector<double> X;
+    std::vector<double> Y;
+    std::vector<double> Z;
+};
+
+// The spectral integrations of tempxy only depend on the sampling, the observer and the temperature: they are done
+// once per temperature and kept for the next images. Key: (5.9 sampling, 10° observer, temperature index)
+std::mutex itcSpectralCacheMutex;
+std::map<std::tuple<bool, bool, int>, std::unique_ptr<const ItcSpectralData>> itcSpectralCache;
+
+}
+
 //tempxy : return x and y of xyY for 406 or more refreence color, and for T temperature from 2000K to 12000K
 // we can change step for temperature and increase number  for T > 7500K if necessary
 //these values Temp, x, y are references for all calculations and very precise.
@@ -5783,92 +5807,23 @@ void ColorTemp::tempxy(bool separated, int repref, float **Tx, float **Ty, float
         printf("Number max spectral colors=%i Number sampling temp=%i\n", N_c, N_t);
     }
 
-    typedef struct XYZref {
-        double Xref;
-        double Yref;
-        double Zref;
-    } XYZref;
-    
-    XYZref Refxyz[N_c + 1];
-
-    for (int i = 0; i < N_c; i++) {
-        Refxyz[i].Xref = 0.f;
-        Refxyz[i].Yref = 0.f;
-        Refxyz[i].Zref = 0.f;
-    }
-
-    bool observerchoice = false;
-
-    observerchoice = (wbpar.observer == StandardObserver::TEN_DEGREES);
-
-    if (wbpar.itcwb_sampling) {
-        observerchoice = false;
-    }
-
+    const bool observerchoice = !wbpar.itcwb_sampling && wbpar.observer == StandardObserver::TEN_DEGREES;
     const color_match_type &color_match = observerchoice ? cie_colour_match_jd : cie_colour_match_jd2;
+    const double* const* const spec_colors = wbpar.itcwb_sampling ? spec_colorforxcyc_old : spec_colorforxcyc;
+    const WbTxyz* const temps = wbpar.itcwb_sampling ? Txyzs : Txyz;
 
-    if (separated) {
-        double tempw = Txyz[repref].Tem;
-
-        if (wbpar.itcwb_sampling) {
-            tempw = Txyzs[repref].Tem;
-        }
-
-        double yy = 0.;
-        whitepoint(tempw, wpx, yy, wpz, color_match);
-
-        if (tempw <= INITIALBLACKBODY) {
-           for (int i = 0; i < N_c; i++) {
-                if (! wbpar.itcwb_sampling) {
-                    spectrum_to_color_xyz_blackbody(spec_colorforxcyc[i], tempw, TX[i], TY[i], TZ[i], color_match);
-                } else {
-                    spectrum_to_color_xyz_blackbody(spec_colorforxcyc_old[i], tempw, TX[i], TY[i], TZ[i], color_match);
-                }
-            }
-        } else {
-            double m11, m22, x_DD, y_DD, interm2;
-
-            if (tempw <= 7000) {
-                x_DD = -4.6070e9 / (tempw * tempw * tempw) + 2.9678e6 / (tempw * tempw) + 0.09911e3 / tempw + 0.244063;
-            } else {
-                x_DD = -2.0064e9 / (tempw * tempw * tempw) + 1.9018e6 / (tempw * tempw) + 0.24748e3 / tempw + 0.237040;
-            }
-
-            y_DD = -3.0 * x_DD * x_DD + 2.87 * x_DD - 0.275;
-            //calculate D -daylight in function of s0, s1, s2 and temp ==> x_D y_D
-            //S(lamda)=So(lambda)+m1*s1(lambda)+m2*s2(lambda)
-            interm2 = (0.0241 + 0.2562 * x_DD - 0.734 * y_DD);
-            m11 = (-1.3515 - 1.7703 * x_DD + 5.9114 * y_DD) / interm2;
-            m22 = (0.03 - 31.4424 * x_DD + 30.0717 * y_DD) / interm2;
-
-            for (int i = 0; i < N_c; i++) {
-                if (! wbpar.itcwb_sampling) {
-                    spectrum_to_color_xyz_daylight(spec_colorforxcyc[i], m11, m22, TX[i], TY[i], TZ[i], color_match);
-                } else {
-                    spectrum_to_color_xyz_daylight(spec_colorforxcyc_old[i], m11, m22, TX[i], TY[i], TZ[i], color_match);
-                }
-            }
-        }
-    } else {
-        for (int tt = ttbeg; tt < ttend; tt++) {
-            double tempw = Txyz[tt].Tem;
-
-            if (wbpar.itcwb_sampling) {
-                tempw = Txyzs[repref].Tem;
-            }
-
+    const auto computeSpectralData =
+        [N_c, spec_colors, &color_match](double tempw, ItcSpectralData &data)
+        {
             double yy = 0.;
-            whitepoint(tempw, wpx, yy, wpz, color_match);
-            WPX[tt] = wpx;
-            WPZ[tt] = wpz;
+            whitepoint(tempw, data.wpx, yy, data.wpz, color_match);
+            data.X.resize(N_c);
+            data.Y.resize(N_c);
+            data.Z.resize(N_c);
 
             if (tempw <= INITIALBLACKBODY) {
                 for (int i = 0; i < N_c; i++) {
-                    if (! wbpar.itcwb_sampling) {
-                        spectrum_to_color_xyz_blackbody(spec_colorforxcyc[i], tempw, Refxyz[i].Xref, Refxyz[i].Yref, Refxyz[i].Zref, color_match);
-                    } else {
-                        spectrum_to_color_xyz_blackbody(spec_colorforxcyc_old[i], tempw, Refxyz[i].Xref, Refxyz[i].Yref, Refxyz[i].Zref, color_match);
-                    }
+                    spectrum_to_color_xyz_blackbody(spec_colors[i], tempw, data.X[i], data.Y[i], data.Z[i], color_match);
                 }
             } else {
                 double x_DD;
@@ -5887,18 +5842,85 @@ void ColorTemp::tempxy(bool separated, int repref, float **Tx, float **Ty, float
                 const double m22 = (0.03 - 31.4424 * x_DD + 30.0717 * y_DD) / interm2;
 
                 for (int i = 0; i < N_c; i++) {
-                    if (! wbpar.itcwb_sampling) {
-                        spectrum_to_color_xyz_daylight(spec_colorforxcyc[i], m11, m22, Refxyz[i].Xref, Refxyz[i].Yref, Refxyz[i].Zref, color_match);
-                    } else {
-                        spectrum_to_color_xyz_daylight(spec_colorforxcyc_old[i], m11, m22, Refxyz[i].Xref, Refxyz[i].Yref, Refxyz[i].Zref, color_match);
-                    }
+                    spectrum_to_color_xyz_daylight(spec_colors[i], m11, m22, data.X[i], data.Y[i], data.Z[i], color_match);
                 }
             }
+        };
+
+    // temperatures (index in temps) needed. With the 5.9 sampling, all the temperatures use the reference one
+    std::vector<int> temperatures;
+
+    if (separated || wbpar.itcwb_sampling) {
+        temperatures.push_back(repref);
+    } else {
+        for (int tt = ttbeg; tt < ttend; tt++) {
+            temperatures.push_back(tt);
+        }
+    }
+
+    std::vector<const ItcSpectralData*> spectralData(temperatures.size(), nullptr);
+    std::vector<int> missing;
+
+    {
+        std::lock_guard<std::mutex> lock(itcSpectralCacheMutex);
+
+        for (size_t k = 0; k < temperatures.size(); k++) {
+            const auto iterator = itcSpectralCache.find(std::make_tuple(wbpar.itcwb_sampling, observerchoice, temperatures[k]));
+
+            if (iterator != itcSpectralCache.end()) {
+                spectralData[k] = iterator->second.get();
+            } else {
+                missing.push_back(k);
+            }
+        }
+    }
+
+    if (!missing.empty()) {
+        std::vector<std::unique_ptr<ItcSpectralData>> computed(missing.size());
+
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int k = 0; k < static_cast<int>(missing.size()); k++) {
+            computed[k].reset(new ItcSpectralData);
+            computeSpectralData(temps[temperatures[missing[k]]].Tem, *computed[k]);
+        }
+
+        std::lock_guard<std::mutex> lock(itcSpectralCacheMutex);
+
+        for (size_t k = 0; k < missing.size(); k++) {
+            auto &cached = itcSpectralCache[std::make_tuple(wbpar.itcwb_sampling, observerchoice, temperatures[missing[k]])];
+
+            if (!cached) { // else computed meanwhile by another image
+                cached = std::move(computed[k]);
+            }
+
+            spectralData[missing[k]] = cached.get();
+        }
+    }
+
+    if (separated) {
+        const ItcSpectralData &data = *spectralData[0];
+        wpx = data.wpx;
+        wpz = data.wpz;
+
+        for (int i = 0; i < N_c; i++) {
+            TX[i] = data.X[i];
+            TY[i] = data.Y[i];
+            TZ[i] = data.Z[i];
+        }
+    } else {
+        for (int tt = ttbeg; tt < ttend; tt++) {
+            const ItcSpectralData &data = *spectralData[wbpar.itcwb_sampling ? 0 : tt - ttbeg];
+            wpx = data.wpx;
+            wpz = data.wpz;
+            WPX[tt] = wpx;
+            WPZ[tt] = wpz;
 
             for (int i = 0; i < N_c; i++) {
-                Tx[i][tt] = Refxyz[i].Xref;
-                Ty[i][tt] = Refxyz[i].Yref;
-                Tz[i][tt] = Refxyz[i].Zref;
+                Tx[i][tt] = data.X[i];
+                Ty[i][tt] = data.Y[i];
+                Tz[i][tt] = data.Z[i];
             }
         }
     }
@@ -0,0 +1,97 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#include "cpudispatch.h"
+
+namespace
+{
+
+rtengine::SimdLevel detectSimdLevel()
+{
+    using rtengine::SimdLevel;
+
+    SimdLevel level = SimdLevel::GENERIC;
+
+#ifdef __SSE2__
+    level = SimdLevel::SSE2;
+#endif
+
+#ifdef RT_CPU_DISPATCH
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+        level = SimdLevel::AVX512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        level = SimdLevel::AVX2;
+    }
+#endif
+
+    const char* const requested = std::getenv("RT_SIMD_LEVEL");
+
+    if (requested) {
+        for (SimdLevel candidate : {SimdLevel::GENERIC, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            // only allow to lower the detected level
+            if (candidate <= level && !strcmp(requested, rtengine::getSimdLevelName(candidate))) {
+                level = candidate;
+                break;
+            }
+        }
+    }
+
+    return level;
+}
+
+}
+
+namespace rtengine
+{
+
+SimdLevel getSimdLevel()
+{
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+const char* getSimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::SSE2: {
+            return "sse2";
+        }
+
+        case SimdLevel::AVX2: {
+            return "avx2";
+        }
+
+        case SimdLevel::AVX512: {
+            return "avx512";
+        }
+
+        case SimdLevel::GENERIC:
+        default: {
+            return "generic";
+        }
+    }
+}
+
+}
@@ -0,0 +1,41 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+namespace rtengine
+{
+
+// Instruction set levels for which some hot kernels have dedicated code paths.
+// The level is detected once at run time, so that binaries built for the
+// x86-64 baseline still use wider vectors on recent processors.
+enum class SimdLevel {
+    GENERIC,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Returns the highest level supported by both the build and the processor.
+// It can be lowered with the RT_SIMD_LEVEL environment variable
+// (generic, sse2, avx2 or avx512), e.g. to compare the output of the code paths.
+SimdLevel getSimdLevel();
+
+const char* getSimdLevelName(SimdLevel level);
+
+}
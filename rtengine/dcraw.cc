@@ -274,6 +274,9 @@ void CLASS derror()
     else
       fprintf (stderr,_("Corrupt data near 0x%llx\n"), (INT64) ftello(ifp));
   }
+#ifdef _OPENMP
+  #pragma omp atomic
+#endif
   data_error++;
 /*RT Issue 2467  longjmp (failure, 1);*/
 }
@@ -831,7 +834,7 @@ struct jhead {
   ushort *huff[6], *free[4], *row;
 };
 
-int CLASS ljpeg_start (struct jhead *jh, int info_only)
+int CLASS ljpeg_start (struct jhead *jh, int info_only, ljpeg_reader_t &rd)
 {
   ushort c, tag, len;
   uchar data[0x10000];
@@ -839,13 +842,13 @@ int CLASS ljpeg_start (struct jhead *jh, int info_only)
 
   memset (jh, 0, sizeof *jh);
   jh->restart = INT_MAX;
-  if ((fgetc(ifp),fgetc(ifp)) != 0xd8) return 0;
+  if ((fgetc(rd.ifp),fgetc(rd.ifp)) != 0xd8) return 0;
   do {
-    if (!fread (data, 2, 2, ifp)) return 0;
+    if (!fread (data, 2, 2, rd.ifp)) return 0;
     tag =  data[0] << 8 | data[1];
     len = (data[2] << 8 | data[3]) - 2;
     if (tag <= 0xff00) return 0;
-    fread (data, 1, len, ifp);
+    fread (data, 1, len, rd.ifp);
     switch (tag) {
       case 0xffc3:
 	jh->sraw = ((data[7] >> 4) * (data[7] & 15) - 1) & 3;
@@ -856,7 +859,7 @@ int CLASS ljpeg_start (struct jhead *jh, int info_only)
 	jh->high = data[1] << 8 | data[2];
 	jh->wide = data[3] << 8 | data[4];
 	jh->clrs = data[5] + jh->sraw;
-	if (len == 9 && !dng_version) getc(ifp);
+	if (len == 9 && !dng_version) getc(rd.ifp);
 	break;
       case 0xffc4:
 	if (info_only) break;
@@ -885,7 +888,7 @@ int CLASS ljpeg_start (struct jhead *jh, int info_only)
   }
   jh->row = (ushort *) calloc (2 * jh->wide*jh->clrs, 4);
   merror (jh->row, "ljpeg_start()");
-  return zero_after_ff = 1;
+  return rd.zero_after_ff = 1;
 }
 
 void CLASS ljpeg_end (struct jhead *jh)
@@ -895,20 +898,20 @@ void CLASS ljpeg_end (struct jhead *jh)
   free (jh->row);
 }
 
-inline int CLASS ljpeg_diff (ushort *huff)
+inline int CLASS ljpeg_diff (ushort *huff, ljpeg_reader_t &rd)
 {
   int len, diff;
 
-  len = gethuff(huff);
+  len = rd.getbithuff(*huff, huff+1);
   if (len == 16 && (!dng_version || dng_version >= 0x1010000))
     return -32768;
-  diff = getbits(len);
+  diff = rd.getbithuff(len, 0);
   if ((diff & (1 << (len-1))) == 0)
     diff -= (1 << len) - 1;
   return diff;
 }
 
-ushort * CLASS ljpeg_row (int jrow, struct jhead *jh)
+ushort * CLASS ljpeg_row (int jrow, struct jhead *jh, ljpeg_reader_t &rd)
 {
   int col, c, diff, pred, spred=0;
   ushort mark=0, *row[3];
@@ -916,16 +919,16 @@ ushort * CLASS ljpeg_row (int jrow, struct jhead *jh)
   if (jrow * jh->wide % jh->restart == 0) {
     FORC(6) jh->vpred[c] = 1 << (jh->bits-1);
     if (jrow) {
-      fseek (ifp, -2, SEEK_CUR);
-      do mark = (mark << 8) + (c = fgetc(ifp));
+      fseek (rd.ifp, -2, SEEK_CUR);
+      do mark = (mark << 8) + (c = fgetc(rd.ifp));
       while (c != EOF && mark >> 4 != 0xffd);
     }
-    getbits(-1);
+    rd.getbithuff(-1, 0);
   }
   FORC3 row[c] = jh->row + jh->wide*jh->clrs*((jrow+c) & 1);
   for (col=0; col < jh->wide; col++)
     FORC(jh->clrs) {
-      diff = ljpeg_diff (jh->huff[c]);
+      diff = ljpeg_diff (jh->huff[c], rd);
       if (jh->sraw && c <= jh->sraw && (col | c))
 		    pred = spred;
       else if (col) pred = row[0][-jh->clrs];
@@ -1089,26 +1092,29 @@ void CLASS adobe_copy_pixel (unsigned row, unsigned col, ushort **rp)
   if (tiff_samples == 2 && shot_select) (*rp)--;
 }
 
-void CLASS ljpeg_idct (struct jhead *jh)
+void CLASS ljpeg_idct (struct jhead *jh, ljpeg_reader_t &rd)
 {
   int c, i, j, len, skip, coef;
   float work[3][8][8];
-  static float cs[106] = { 0 };
+  // RT: initialised once in a thread-safe way, the DNG tiles can be decoded concurrently
+  static const struct cs_t {
+    float v[106];
+    cs_t() { int c; FORC(106) v[c] = cos((c & 31)*rtengine::RT_PI/16)/2; }
+  } cs_table;
+  const float *cs = cs_table.v;
   static const uchar zigzag[80] =
   {  0, 1, 8,16, 9, 2, 3,10,17,24,32,25,18,11, 4, 5,12,19,26,33,
     40,48,41,34,27,20,13, 6, 7,14,21,28,35,42,49,56,57,50,43,36,
     29,22,15,23,30,37,44,51,58,59,52,45,38,31,39,46,53,60,61,54,
     47,55,62,63,63,63,63,63,63,63,63,63,63,63,63,63,63,63,63,63 };
 
-  if (!cs[0])
-    FORC(106) cs[c] = cos((c & 31)*rtengine::RT_PI/16)/2;
   memset (work, 0, sizeof work);
-  work[0][0][0] = jh->vpred[0] += ljpeg_diff (jh->huff[0]) * jh->quant[0];
+  work[0][0][0] = jh->vpred[0] += ljpeg_diff (jh->huff[0], rd) * jh->quant[0];
   for (i=1; i < 64; i++ ) {
-    len = gethuff (jh->huff[16]);
+    len = rd.getbithuff (*jh->huff[16], jh->huff[16]+1);
     i += skip = len >> 4;
     if (!(len &= 15) && skip < 15) break;
-    coef = getbits(len);
+    coef = rd.getbithuff(len, 0);
     if ((coef & (1 << (len-1))) == 0)
       coef -= (1 << len) - 1;
     ((float *)work)[zigzag[i]] = coef * jh->quant[i];
@@ -1125,53 +1131,94 @@ void CLASS ljpeg_idct (struct jhead *jh)
   FORC(64) jh->idct[c] = CLIP(((float *)work[2])[c]+0.5);
 }
 
-void CLASS lossless_dng_load_raw()
+bool CLASS lossless_dng_load_tile (unsigned trow, unsigned tcol, ljpeg_reader_t &rd)
 {
-  unsigned save, trow=0, tcol=0, jwide, jrow, jcol, row, col, i, j;
+  unsigned jwide, jrow, jcol, row, col, i, j;
   struct jhead jh;
   ushort *rp;
 
+  if (!ljpeg_start (&jh, 0, rd)) return false;
+  jwide = jh.wide;
+  if (filters || (colors == 1 && jh.clrs > 1)) jwide *= jh.clrs;
+  jwide /= MIN (is_raw, tiff_samples);
+  switch (jh.algo) {
+    case 0xc1:
+      jh.vpred[0] = 16384;
+      rd.getbithuff(-1, 0);
+      for (jrow=0; jrow+7 < jh.high; jrow += 8) {
+	for (jcol=0; jcol+7 < jh.wide; jcol += 8) {
+	  ljpeg_idct (&jh, rd);
+	  rp = jh.idct;
+	  row = trow + jcol/tile_width + jrow*2;
+	  col = tcol + jcol%tile_width;
+	  for (i=0; i < 16; i+=2)
+	    for (j=0; j < 8; j++)
+	      adobe_copy_pixel (row+i, col+j, &rp);
+	}
+      }
+      break;
+    case 0xc3:
+      for (row=col=jrow=0; jrow < jh.high; jrow++) {
+	rp = ljpeg_row (jrow, &jh, rd);
+	for (jcol=0; jcol < jwide; jcol++) {
+	  adobe_copy_pixel (trow+row, tcol+col, &rp);
+	  if (++col >= tile_width || col >= raw_width)
+	    row += 1 + (col = 0);
+	}
+      }
+  }
+  ljpeg_end (&jh);
+  return true;
+}
+
+void CLASS lossless_dng_load_raw()
+{
+  unsigned save, trow=0, tcol=0;
+
   size_t tilesWide = (raw_width + tile_width - 1) / tile_width;
   size_t tilesHigh = (raw_height + tile_length - 1) / tile_length;
   size_t tileCount = tilesWide * tilesHigh;
 
+#if defined( _OPENMP ) && defined( MYFILE_MMAP )
+  if (tileCount > 1) {
+    // RT: the tiles are independent, read their offsets up front and decode them concurrently,
+    // each thread with its own cursor over the memory mapped file and its own bit reader
+    std::vector<unsigned> offsets(tileCount);
+    for (auto &offset : offsets)
+      offset = get4();
+
+#pragma omp parallel
+{
+    rtengine::IMFILE ifpthr = *ifp;
+    rtengine::IMFILE *ifpthrp = &ifpthr;
+    unsigned zero_after_ff_thr = 0;
+    getbithuff_t getbithuff_thr(this, ifpthrp, zero_after_ff_thr);
+    ljpeg_reader_t rd{ifpthrp, zero_after_ff_thr, getbithuff_thr};
+
+    // only master thread will update the progress bar
+    ifpthr.plistener = nullptr;
+    #pragma omp master
+    {
+    ifpthr.plistener = ifp->plistener;
+    }
+    #pragma omp for schedule(dynamic)
+    for (size_t tile = 0; tile < tileCount; tile++) {
+      fseek (&ifpthr, offsets[tile], SEEK_SET);
+      lossless_dng_load_tile ((tile / tilesWide) * tile_length, (tile % tilesWide) * tile_width, rd);
+    }
+}
+    return;
+  }
+#endif
+
   while (trow < raw_height) {
     save = ftell(ifp);
     if (tileCount > 1)
       fseek (ifp, get4(), SEEK_SET);
-    if (!ljpeg_start (&jh, 0)) break;
-    jwide = jh.wide;
-    if (filters || (colors == 1 && jh.clrs > 1)) jwide *= jh.clrs;
-    jwide /= MIN (is_raw, tiff_samples);
-    switch (jh.algo) {
-      case 0xc1:
-	jh.vpred[0] = 16384;
-	getbits(-1);
-	for (jrow=0; jrow+7 < jh.high; jrow += 8) {
-	  for (jcol=0; jcol+7 < jh.wide; jcol += 8) {
-	    ljpeg_idct (&jh);
-	    rp = jh.idct;
-	    row = trow + jcol/tile_width + jrow*2;
-	    col = tcol + jcol%tile_width;
-	    for (i=0; i < 16; i+=2)
-	      for (j=0; j < 8; j++)
-		adobe_copy_pixel (row+i, col+j, &rp);
-	  }
-	}
-	break;
-      case 0xc3:
-	for (row=col=jrow=0; jrow < jh.high; jrow++) {
-	  rp = ljpeg_row (jrow, &jh);
-	  for (jcol=0; jcol < jwide; jcol++) {
-	    adobe_copy_pixel (trow+row, tcol+col, &rp);
-	    if (++col >= tile_width || col >= raw_width)
-	      row += 1 + (col = 0);
-	  }
-	}    }
+    if (!lossless_dng_load_tile (trow, tcol, ljpeg_reader)) break;
     fseek (ifp, save+4, SEEK_SET);
     if ((tcol += tile_width) >= raw_width)
       trow += tile_length + (tcol = 0);
-    ljpeg_end (&jh);
   }
 }
 
@@ -6628,6 +6675,7 @@ int CLASS parse_tiff_ifd (int base)
       case 273:				/* StripOffset */
       case 513:				/* JpegIFOffset */
       case 61447:
+	if (tag == 273) tiff_ifd[ifd].strips = len;	// RT
 	tiff_ifd[ifd].offset = get4()+base;
 	if (!tiff_ifd[ifd].bps && tiff_ifd[ifd].offset > 0) {
 	  fseek (ifp, tiff_ifd[ifd].offset, SEEK_SET);
@@ -11345,8 +11393,55 @@ notraw:
 // #include <zlib.h>
 // #include <stdint.h>
 
+#ifdef __SSE2__
+// Adds the bytes at a distance of FACTOR, FACTOR*2 ... in place, i.e. the inverse of the horizontal byte differencing
+template<int FACTOR>
+static void decodeDeltaBytesSSE(Bytef * src, size_t len) {
+  __m128i carry = _mm_setzero_si128();
+  size_t col = 0;
+  for (; col + 16 <= len; col += 16) {
+    __m128i v = _mm_loadu_si128((__m128i*)&src[col]);
+    // prefix sum of the lanes which are FACTOR bytes apart
+    v = _mm_add_epi8(v, _mm_slli_si128(v, FACTOR));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, FACTOR * 2));
+    if (FACTOR < 4) {
+      v = _mm_add_epi8(v, _mm_slli_si128(v, FACTOR * 4));
+    }
+    if (FACTOR == 1) {
+      v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+    }
+    v = _mm_add_epi8(v, carry);
+    _mm_storeu_si128((__m128i*)&src[col], v);
+    // the last FACTOR bytes of the block carry into the next one
+    if (FACTOR == 1) {
+      carry = _mm_set1_epi8(src[col + 15]);
+    } else if (FACTOR == 2) {
+      uint16_t last;
+      memcpy(&last, &src[col + 14], 2);
+      carry = _mm_set1_epi16(last);
+    } else {
+      uint32_t last;
+      memcpy(&last, &src[col + 12], 4);
+      carry = _mm_set1_epi32(last);
+    }
+  }
+  for (col = std::max<size_t>(col, FACTOR); col < len; ++col) {
+    src[col] += src[col - FACTOR];
+  }
+}
+#endif
+
 static void decodeFPDeltaRow(Bytef * src, Bytef * dst, size_t tileWidth, size_t realTileWidth, int bytesps, int factor) {
   // DecodeDeltaBytes
+#ifdef __SSE2__
+  if (factor == 1) {
+    decodeDeltaBytesSSE<1>(src, realTileWidth*bytesps);
+  } else if (factor == 2) {
+    decodeDeltaBytesSSE<2>(src, realTileWidth*bytesps);
+  } else if (factor == 4) {
+    decodeDeltaBytesSSE<4>(src, realTileWidth*bytesps);
+  } else
+#endif
   for (size_t col = factor; col < realTileWidth*bytesps; ++col) {
     src[col] += src[col - factor];
   }
@@ -11361,7 +11456,34 @@ static void decodeFPDeltaRow(Bytef * src, Bytef * dst, size_t tileWidth, size_t
   } else {
     union X { uint32_t x; uint8_t c; };
     if (((union X){1}).c) {
-		for (size_t col = 0; col < tileWidth; ++col) {
+        size_t col = 0;
+#ifdef __SSE2__
+        // interleave the byte planes, most significant plane first
+        if (bytesps == 4) {
+            for (; col + 16 <= tileWidth; col += 16) {
+                const __m128i b3 = _mm_loadu_si128((__m128i*)&src[col]);
+                const __m128i b2 = _mm_loadu_si128((__m128i*)&src[col + realTileWidth]);
+                const __m128i b1 = _mm_loadu_si128((__m128i*)&src[col + realTileWidth*2]);
+                const __m128i b0 = _mm_loadu_si128((__m128i*)&src[col + realTileWidth*3]);
+                const __m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+                const __m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+                const __m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+                const __m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+                _mm_storeu_si128((__m128i*)&dst[col*4], _mm_unpacklo_epi16(lo01, lo23));
+                _mm_storeu_si128((__m128i*)&dst[col*4 + 16], _mm_unpackhi_epi16(lo01, lo23));
+                _mm_storeu_si128((__m128i*)&dst[col*4 + 32], _mm_unpacklo_epi16(hi01, hi23));
+                _mm_storeu_si128((__m128i*)&dst[col*4 + 48], _mm_unpackhi_epi16(hi01, hi23));
+            }
+        } else if (bytesps == 2) {
+            for (; col + 16 <= tileWidth; col += 16) {
+                const __m128i b1 = _mm_loadu_si128((__m128i*)&src[col]);
+                const __m128i b0 = _mm_loadu_si128((__m128i*)&src[col + realTileWidth]);
+                _mm_storeu_si128((__m128i*)&dst[col*2], _mm_unpacklo_epi8(b0, b1));
+                _mm_storeu_si128((__m128i*)&dst[col*2 + 16], _mm_unpackhi_epi8(b0, b1));
+            }
+        }
+#endif
+		for (; col < tileWidth; ++col) {
 			for (size_t byte = 0; byte < bytesps; ++byte)
 				dst[col*bytesps + byte] = src[col + realTileWidth*(bytesps-byte-1)];  // Little endian
 		}
@@ -11482,7 +11604,8 @@ static void expandFloats(Bytef * dst, int tileWidth, int bytesps) {
   }
 }
 
-static int decompress(size_t srcLen, size_t dstLen, unsigned char *in, unsigned char *out) {
+static int decompress(size_t srcLen, size_t dstLen, size_t expectedLen, const unsigned char *in, unsigned char *out) {
+    // RT: a stream not inflating to expectedLen is an error (e.g. the first strip of a multi-strip image)
     // At least in zlib 1.2.11 the uncompress function is not thread save while it is thread save in zlib 1.2.8
     // This simple replacement is thread save. Used example code from https://zlib.net/zlib_how.html
 
@@ -11501,7 +11624,7 @@ static int decompress(size_t srcLen, size_t dstLen, unsigned char *in, unsigned
     strm.avail_out = dstLen;
     strm.next_out = out;
     strm.avail_in = srcLen;
-    strm.next_in = in;
+    strm.next_in = const_cast<unsigned char*>(in);
     ret = inflate(&strm, Z_NO_FLUSH);
     switch (ret) {
     case Z_NEED_DICT:
@@ -11511,9 +11634,10 @@ static int decompress(size_t srcLen, size_t dstLen, unsigned char *in, unsigned
         (void)inflateEnd(&strm);
         return ret;
     }
+    const bool complete = strm.total_out == expectedLen;
     /* clean up and return */
     (void)inflateEnd(&strm);
-    return ret == Z_STREAM_END ? Z_OK : Z_DATA_ERROR;
+    return ret == Z_STREAM_END && complete ? Z_OK : Z_DATA_ERROR;
 }
 
 void CLASS deflate_dng_load_raw() {
@@ -11553,79 +11677,120 @@ void CLASS deflate_dng_load_raw() {
   // NOTE: This reader is based on the official DNG SDK from Adobe.
   // It assumes tiles without subtiles, but the standard does not say that
   // subtiles or strips couldn't be used.
-  if (tile_length < INT_MAX) {
-    size_t tilesWide = (raw_width + tile_width - 1) / tile_width;
-    size_t tilesHigh = (raw_height + tile_length - 1) / tile_length;
-    size_t tileCount = tilesWide * tilesHigh;
-    //fprintf(stderr, "%dx%d tiles, %d total\n", tilesWide, tilesHigh, tileCount);
-    size_t tileOffsets[tileCount];
-    if (tileCount == 1) {
-      tileOffsets[0] = ifd->offset;
-    } else {
-      for (size_t t = 0; t < tileCount; ++t) {
-        tileOffsets[t] = get4();
-      }
+  // RT: an untiled image is read as a single tile, i.e. a single strip
+  const bool tiled = tile_width < INT_MAX && tile_length < INT_MAX;
+  if (!tiled && ifd->strips != 1) {
+    fprintf(stderr, "deflate_dng_load_raw %s: Only single strip untiled files are supported\n",ifname);
+    return;
+  }
+  const size_t tileWidth = tile_width < INT_MAX ? tile_width : raw_width;
+  const size_t tileLength = tile_length < INT_MAX ? tile_length : raw_height;
+  const size_t tilesWide = (raw_width + tileWidth - 1) / tileWidth;
+  const size_t tilesHigh = (raw_height + tileLength - 1) / tileLength;
+  const size_t tileCount = tilesWide * tilesHigh;
+  //fprintf(stderr, "%dx%d tiles, %d total\n", tilesWide, tilesHigh, tileCount);
+  std::vector<size_t> tileOffsets(tileCount);
+  if (tileCount == 1) {
+    tileOffsets[0] = ifd->offset;
+  } else {
+    for (size_t t = 0; t < tileCount; ++t) {
+      tileOffsets[t] = get4();
     }
-    size_t tileBytes[tileCount];
-    uLongf maxCompressed = 0;
-    if (tileCount == 1) {
-      tileBytes[0] = maxCompressed = ifd->bytes;
-    } else {
-      fseek(ifp, ifd->bytes, SEEK_SET);
-      for (size_t t = 0; t < tileCount; ++t) {
-        tileBytes[t] = get4();
-        //fprintf(stderr, "Tile %d at %d, size %d\n", t, tileOffsets[t], tileBytes[t]);
-        if (maxCompressed < tileBytes[t])
-          maxCompressed = tileBytes[t];
+  }
+  std::vector<size_t> tileBytes(tileCount);
+  uLongf maxCompressed = 0;
+  if (tileCount == 1) {
+    tileBytes[0] = maxCompressed = ifd->bytes;
+  } else {
+    fseek(ifp, ifd->bytes, SEEK_SET);
+    for (size_t t = 0; t < tileCount; ++t) {
+      tileBytes[t] = get4();
+      //fprintf(stderr, "Tile %d at %d, size %d\n", t, tileOffsets[t], tileBytes[t]);
+      if (maxCompressed < tileBytes[t])
+        maxCompressed = tileBytes[t];
+    }
+  }
+  const int bytesps = ifd->bps >> 3;
+  const uLongf dstLen = tileWidth * tileLength * 4;
+
+  // undoes the predictor and expands the samples to float, rows are independent
+  const auto decodeRows = [&](Bytef * uBuffer, size_t y, size_t x, size_t rowBegin, size_t rowEnd) {
+    const size_t thisTileWidth = x + tileWidth > raw_width ? raw_width - x : tileWidth;
+    for (size_t row = rowBegin; row < rowEnd; ++row) {
+      Bytef * src = uBuffer + row*tileWidth*bytesps;
+      Bytef * dst = (Bytef *)&float_raw_image[(y+row)*raw_width + x];
+      if (predFactor) {
+        decodeFPDeltaRow(src, dst, thisTileWidth, tileWidth, bytesps, predFactor);
       }
+      expandFloats(dst, thisTileWidth, bytesps);
     }
-    uLongf dstLen = tile_width * tile_length * 4;
+  };
 
 #ifdef _OPENMP
-#pragma omp parallel
+  // with fewer tiles than threads, the rows of each tile are decoded concurrently after its inflate
+  const bool parallelTiles = tileCount >= static_cast<size_t>(omp_get_max_threads());
+#else
+  const bool parallelTiles = false;
+#endif
+
+#ifdef _OPENMP
+#pragma omp parallel if(parallelTiles)
 #endif
 {
-    Bytef * cBuffer = new Bytef[maxCompressed];
-    Bytef * uBuffer = new Bytef[dstLen];
+    // RT: the buffers are only allocated by the threads which get a tile
+    std::unique_ptr<Bytef[]> cBuffer;
+    std::unique_ptr<Bytef[]> uBuffer;
 
 #ifdef _OPENMP
-    #pragma omp for collapse(2) schedule(dynamic) nowait
+    #pragma omp for schedule(dynamic) nowait
 #endif
-    for (size_t y = 0; y < raw_height; y += tile_length) {
-        for (size_t x = 0; x < raw_width; x += tile_width) {
-            size_t t = (y / tile_length) * tilesWide + (x / tile_width);
+    for (size_t t = 0; t < tileCount; ++t) {
+        const size_t y = (t / tilesWide) * tileLength;
+        const size_t x = (t % tilesWide) * tileWidth;
+        if (!uBuffer) {
+            uBuffer.reset(new Bytef[dstLen]);
+        }
+        const Bytef * cData;
+#ifdef MYFILE_MMAP
+        // RT: inflate straight from the memory mapped file
+        if (tileOffsets[t] + tileBytes[t] > static_cast<size_t>(ifp->size)) {
+            fprintf(stderr, "DNG Deflate: tile %d is out of the file\n", (int)t);
+            continue;
+        }
+        cData = reinterpret_cast<const Bytef*>(ifp->data) + tileOffsets[t];
+#else
+        if (!cBuffer) {
+            cBuffer.reset(new Bytef[maxCompressed]);
+        }
 #ifdef _OPENMP
-            #pragma omp critical
+        #pragma omp critical
+#endif
+        {
+            fseek(ifp, tileOffsets[t], SEEK_SET);
+            fread(cBuffer.get(), 1, tileBytes[t], ifp);
+        }
+        cData = cBuffer.get();
+#endif
+        int err = decompress(tileBytes[t], dstLen, tileWidth * tileLength * bytesps, cData, uBuffer.get());
+        if (err != Z_OK) {
+            fprintf(stderr, "DNG Deflate: Failed uncompressing tile %d, with error %d\n", (int)t, err);
+        } else if (ifd->sample_format == 3) {  // Floating point data
+            const size_t thisTileLength = y + tileLength > raw_height ? raw_height - y : tileLength;
+            if (parallelTiles) {
+                decodeRows(uBuffer.get(), y, x, 0, thisTileLength);
+            } else {
+#ifdef _OPENMP
+                #pragma omp parallel for
 #endif
-            {
-                fseek(ifp, tileOffsets[t], SEEK_SET);
-                fread(cBuffer, 1, tileBytes[t], ifp);
-            }
-            int err = decompress(tileBytes[t], dstLen, cBuffer, uBuffer);
-            if (err != Z_OK) {
-                fprintf(stderr, "DNG Deflate: Failed uncompressing tile %d, with error %d\n", (int)t, err);
-            } else if (ifd->sample_format == 3) {  // Floating point data
-                int bytesps = ifd->bps >> 3;
-                size_t thisTileLength = y + tile_length > raw_height ? raw_height - y : tile_length;
-                size_t thisTileWidth = x + tile_width > raw_width ? raw_width - x : tile_width;
                 for (size_t row = 0; row < thisTileLength; ++row) {
-                    Bytef * src = uBuffer + row*tile_width*bytesps;
-                    Bytef * dst = (Bytef *)&float_raw_image[(y+row)*raw_width + x];
-                    if (predFactor) {
-                        decodeFPDeltaRow(src, dst, thisTileWidth, tile_width, bytesps, predFactor);
-                    }
-                    expandFloats(dst, thisTileWidth, bytesps);
+                    decodeRows(uBuffer.get(), y, x, row, row + 1);
                 }
-            } else {  // 32-bit Integer data
-                // TODO
             }
+        } else {  // 32-bit Integer data
+            // TODO
         }
     }
-
-    delete [] cBuffer;
-    delete [] uBuffer;
 }
-  }
 
 }
 
@@ -64,6 +64,7 @@ public:
     ,RT_matrix_from_constant(ThreeValBool::X)
     ,RT_baseline_exposure(0)
 	,getbithuff(this,ifp,zero_after_ff)
+	,ljpeg_reader{ifp,zero_after_ff,getbithuff}
 	,nikbithuff(ifp)
     {
         shrink=0;
@@ -297,6 +298,7 @@ protected:
     struct tiff_ifd {
       int new_sub_file_type, width, height, bps, comp, phint, offset, flip, samples, bytes;
       int tile_width, tile_length, sample_format, predictor;
+      int strips; // RT: number of StripOffsets
       float shutter;
     } tiff_ifd[10];
 
@@ -379,6 +381,14 @@ private:
 };
 getbithuff_t getbithuff;
 
+// File cursor and bit reader used by the lossless JPEG decoder, so that independent tiles can be decoded concurrently
+struct ljpeg_reader_t {
+   rtengine::IMFILE *&ifp;
+   unsigned &zero_after_ff;
+   getbithuff_t &getbithuff;
+};
+ljpeg_reader_t ljpeg_reader;
+
 class nikbithuff_t
 {
 public:
@@ -404,16 +414,20 @@ ushort * make_decoder (const uchar *source);
 void crw_init_tables (unsigned table, ushort *huff[2]);
 int canon_has_lowbits();
 void canon_load_raw();
-int ljpeg_start (struct jhead *jh, int info_only);
+int ljpeg_start (struct jhead *jh, int info_only, ljpeg_reader_t &rd);
+int ljpeg_start (struct jhead *jh, int info_only) { return ljpeg_start(jh, info_only, ljpeg_reader); }
 void ljpeg_end (struct jhead *jh);
-int ljpeg_diff (ushort *huff);
-ushort * ljpeg_row (int jrow, struct jhead *jh);
+int ljpeg_diff (ushort *huff, ljpeg_reader_t &rd);
+int ljpeg_diff (ushort *huff) { return ljpeg_diff(huff, ljpeg_reader); }
+ushort * ljpeg_row (int jrow, struct jhead *jh, ljpeg_reader_t &rd);
+ushort * ljpeg_row (int jrow, struct jhead *jh) { return ljpeg_row(jrow, jh, ljpeg_reader); }
 void lossless_jpeg_load_raw();
-void ljpeg_idct (struct jhead *jh);
+void ljpeg_idct (struct jhead *jh, ljpeg_reader_t &rd);
 
 
 void canon_sraw_load_raw();
 void adobe_copy_pixel (unsigned row, unsigned col, ushort **rp);
+bool lossless_dng_load_tile (unsigned trow, unsigned tcol, ljpeg_reader_t &rd);
 void lossless_dng_load_raw();
 void packed_dng_load_raw();
 void deflate_dng_load_raw();
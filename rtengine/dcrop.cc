@@ -51,12 +51,75 @@ constexpr T skips(T a, T b)
     return a / b + static_cast<bool>(a % b);
 }
 
+// Returns the skip of the subsampled pass of a crop window, or skip if the window is small enough to be
+// computed at once
+int getCoarseSkip(int cropW, int cropH, int skip)
+{
+    const double budget = rtengine::settings->progressivePreview * 1000.0;
+    int coarseSkip = skip;
+
+    if (budget > 0.0) {
+        while (double(cropW / coarseSkip) * double(cropH / coarseSkip) > budget) {
+            coarseSkip *= 2;
+        }
+    }
+
+    return coarseSkip;
+}
+
+// Minimum duration in ms of the full quality update of a crop for the subsampled pass to be worth its cost
+constexpr int PROGRESSIVE_MIN_TIME = 200;
+
+// Listener of a coarse crop: same window as the real listener, at a larger skip
+class CoarseCropListener final :
+    public rtengine::DetailedCropListener
+{
+public:
+    CoarseCropListener() : listener(nullptr), skip(1) {}
+
+    void set(rtengine::DetailedCropListener* listener, int skip)
+    {
+        this->listener = listener;
+        this->skip = skip;
+    }
+
+    void setDetailedCrop(
+        rtengine::IImage8* img,
+        rtengine::IImage8* imgtrue,
+        const rtengine::procparams::ColorManagementParams& cmp,
+        const rtengine::procparams::CropParams& cp,
+        int cx,
+        int cy,
+        int cw,
+        int ch,
+        int skip
+    ) override
+    {
+        listener->setDetailedCrop(img, imgtrue, cmp, cp, cx, cy, cw, ch, skip);
+    }
+
+    void getWindow(int& cx, int& cy, int& cw, int& ch, int& skip) override
+    {
+        listener->getWindow(cx, cy, cw, ch, skip);
+        skip = this->skip;
+    }
+
+private:
+    rtengine::DetailedCropListener* listener;
+    int skip;
+};
+
 }
 
 namespace rtengine
 {
 
 Crop::Crop(ImProcCoordinator* parent, EditDataProvider *editDataProvider, bool isDetailWindow)
+    : Crop(parent, editDataProvider, isDetailWindow, false)
+{
+}
+
+Crop::Crop(ImProcCoordinator* parent, EditDataProvider *editDataProvider, bool isDetailWindow, bool coarse)
     : PipetteBuffer(editDataProvider), origCrop(nullptr), spotCrop(nullptr), laboCrop(nullptr), labnCrop(nullptr),
       cropImg(nullptr), shbuf_real(nullptr), transCrop(nullptr), cieCrop(nullptr), shbuffer(nullptr),
       updating(false), newUpdatePending(false), skip(10),
@@ -65,20 +128,28 @@ Crop::Crop(ImProcCoordinator* parent, EditDataProvider *editDataProvider, bool i
       rqcropx(0), rqcropy(0), rqcropw(-1), rqcroph(-1),
       borderRequested(32), upperBorder(0), leftBorder(0),
       cropAllocated(false),
-      cropImageListener(nullptr), parent(parent), isDetailWindow(isDetailWindow)
+      cropImageListener(nullptr), parent(parent), isDetailWindow(isDetailWindow),
+      coarseStale(true), progressive(!coarse), fullUpdateTime(-1)
 {
-    parent->crops.push_back(this);
+    // The coarse crops are owned and updated by their crop, the coordinator doesn't know them
+    if (!coarse) {
+        parent->crops.push_back(this);
+    }
 }
 
 Crop::~Crop()
 {
+    coarseCrop.reset();
 
     MyMutex::MyLock cropLock(cropMutex);
 
-    std::vector<Crop*>::iterator i = std::find(parent->crops.begin(), parent->crops.end(), this);
+    // The coarse crops aren't registered
+    if (progressive) {
+        std::vector<Crop*>::iterator i = std::find(parent->crops.begin(), parent->crops.end(), this);
 
-    if (i != parent->crops.end()) {
-        parent->crops.erase(i);
+        if (i != parent->crops.end()) {
+            parent->crops.erase(i);
+        }
     }
 
     MyMutex::MyLock processingLock(parent->mProcessing);
@@ -87,6 +158,11 @@ Crop::~Crop()
 
 void Crop::destroy()
 {
+    if (coarseCrop) {
+        coarseCrop->destroy();
+        coarseStale = true;
+    }
+
     MyMutex::MyLock lock(cropMutex);
     MyMutex::MyLock processingLock(parent->mProcessing);
     freeAll();
@@ -160,8 +236,22 @@ void Crop::update(int todo)
 
     if (overrideWindow) {
         cropImageListener->getWindow(wx, wy, ww, wh, ws);
+
+        // The subsampled pass costs up to the progressivePreview budget, only do it when the last full quality
+        // update was slow or its duration is unknown
+        const bool slow = fullUpdateTime < 0 || fullUpdateTime >= PROGRESSIVE_MIN_TIME;
+        const int coarseSkip = progressive && slow ? getCoarseSkip(ww, wh, ws) : ws;
+
+        if (coarseSkip > ws) {
+            updateCoarse(todo, coarseSkip);
+        } else {
+            coarseStale = true;
+        }
     }
 
+    MyTime startTime;
+    startTime.set();
+
     // re-allocate sub-images and arrays if their dimensions changed
     bool needsinitupdate = false;
 
@@ -1762,7 +1852,14 @@ void Crop::update(int todo)
     // Computing the preview image, i.e. converting from lab->Monitor color space (soft-proofing disabled) or lab->Output profile->Monitor color space (soft-proofing enabled)
     parent->ipf.lab2monitorRgb(labnCrop, cropImg);
 
-    if (cropImageListener) {
+    if (!parent->ipf.isCancelled()) {
+        MyTime endTime;
+        endTime.set();
+        fullUpdateTime = endTime.etime(startTime) / 1000;
+    }
+
+    // A cancelled update is redone by the parent, don't show its partial result
+    if (cropImageListener && !parent->ipf.isCancelled()) {
         // Computing the internal image for analysis, i.e. conversion from lab->Output profile (rtSettings.HistogramWorking disabled) or lab->WCS (rtSettings.HistogramWorking enabled)
 
         // internal image in output color space for analysis
@@ -1795,6 +1892,26 @@ void Crop::update(int todo)
     }
 }
 
+/* @brief Renders the window of the listener at coarseSkip and hands it to the listener
+ *
+ * The coarse crop keeps its own buffers, so that it is updated as incrementally as this crop. It isn't registered
+ * in parent->crops: it is only updated from here, on behalf of this crop.
+ */
+void Crop::updateCoarse(int todo, int coarseSkip)
+{
+    if (!coarseCrop) {
+        coarseCrop.reset(new Crop(parent, nullptr, isDetailWindow, true));
+        coarseListener.reset(new CoarseCropListener);
+    }
+
+    static_cast<CoarseCropListener*>(coarseListener.get())->set(cropImageListener, coarseSkip);
+    coarseCrop->setListener(coarseListener.get());
+    coarseCrop->update(coarseStale ? ALL : todo);
+
+    // A cancelled update leaves partial results in the buffers
+    coarseStale = parent->ipf.isCancelled();
+}
+
 void Crop::freeAll()
 {
 
@@ -2096,6 +2213,9 @@ void Crop::fullUpdate()
         parent->plistener->setProgressState(true);
     }
 
+    // A cancellation only applies to the updater thread that has been joined above
+    parent->renderCancellation.reset();
+
     // If there are more update request, the following WHILE will collect it
     newUpdatePending = true;
 
@@ -2119,6 +2239,20 @@ int Crop::get_skip()
     return skip;
 }
 
+bool Crop::sourceIntersects(int x1, int y1, int x2, int y2)
+{
+    MyMutex::MyLock lock(cropMutex);
+
+    if (trafw < 0) {
+        // Not processed yet
+        return true;
+    }
+
+    // One more skip step around, as the spots are rounded to the scaled grid
+    return x1 <= trafx + (trafw + 1) * skip && x2 >= trafx - skip
+        && y1 <= trafy + (trafh + 1) * skip && y2 >= trafy - skip;
+}
+
 int Crop::getLeftBorder()
 {
     MyMutex::MyLock lock(cropMutex);
@@ -18,6 +18,8 @@
  */
 #pragma once
 
+#include <memory>
+
 #include "rtengine.h"
 #include "pipettebuffer.h"
 #include "rtgui/threadutils.h"
@@ -65,10 +67,21 @@ protected:
     MyMutex cropMutex;
     ImProcCoordinator* const parent;
     const bool isDetailWindow;
+
+    // Progressive refinement: coarseCrop renders the same window subsampled before this crop computes it
+    std::unique_ptr<Crop> coarseCrop;
+    std::unique_ptr<DetailedCropListener> coarseListener;
+    bool coarseStale;  /// coarseCrop missed some updates, its buffers have to be recomputed
+    bool progressive;  /// false for the coarse crops themselves
+    int fullUpdateTime;  /// duration in ms of the last complete update, -1 if unknown
+
     EditUniqueID getCurrEditID() const;
     bool setCropSizes(int cropX, int cropY, int cropW, int cropH, int skip, bool internal);
+    void updateCoarse(int todo, int coarseSkip);
     void freeAll();
 
+    Crop(ImProcCoordinator* parent, EditDataProvider *editDataProvider, bool isDetailWindow, bool coarse);
+
 public:
     Crop(ImProcCoordinator* parent, EditDataProvider *editDataProvider, bool isDetailWindow);
     ~Crop    () override;
@@ -91,6 +104,8 @@ public:
     void setListener    (DetailedCropListener* il) override;
     void destroy        () override;
     int get_skip();
+    /** @brief Tells whether the image source area of the last update intersects the given area (full image coordinates) */
+    bool sourceIntersects(int x1, int y1, int x2, int y2);
     int getLeftBorder();
     int getUpperBorder();
 };
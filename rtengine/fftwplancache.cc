@@ -0,0 +1,234 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include <glib/gstdio.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/convert.h>
+#include <glibmm/miscutils.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "fftwplancache.h"
+#include "settings.h"
+#include "rtgui/threadutils.h"
+
+namespace rtengine
+{
+
+extern MyMutex *fftwMutex;
+extern const Settings* settings;
+
+}
+
+namespace
+{
+
+struct PlanKey {
+    int rows;
+    int cols;
+    int howmany;
+    int kind0;
+    int kind1;
+    unsigned flags;
+    int nthreads;
+    bool inPlace;
+
+    bool operator <(const PlanKey& other) const
+    {
+        return std::tie(rows, cols, howmany, kind0, kind1, flags, nthreads, inPlace)
+             < std::tie(other.rows, other.cols, other.howmany, other.kind0, other.kind1, other.flags, other.nthreads, other.inPlace);
+    }
+};
+
+struct CachedPlan {
+    rtengine::FftwPlanCache::Plan plan;
+    unsigned long lastUse;
+};
+
+std::map<PlanKey, CachedPlan> plans;
+unsigned long useCount = 0;
+Glib::ustring wisdomFile;
+bool wisdomChanged = false;
+
+void destroyPlan(fftwf_plan plan)
+{
+    // the planner is not thread-safe and fftwf_destroy_plan may touch its data
+    MyMutex::MyLock lock(*rtengine::fftwMutex);
+    fftwf_destroy_plan(plan);
+}
+
+rtengine::FftwPlanCache::Plan getPlan(int rows, int cols, int howmany, bool inPlace, fftw_r2r_kind kind0, fftw_r2r_kind kind1, unsigned flags, int nthreads)
+{
+    const PlanKey key{rows, cols, howmany, kind0, kind1, flags, nthreads, inPlace};
+
+    // released after the lock, as destroying the evicted plan locks fftwMutex again
+    rtengine::FftwPlanCache::Plan evicted;
+
+    MyMutex::MyLock lock(*rtengine::fftwMutex);
+
+    const auto it = plans.find(key);
+
+    if (it != plans.end()) {
+        it->second.lastUse = ++useCount;
+        return it->second.plan;
+    }
+
+    if (plans.size() >= rtengine::FftwPlanCache::MAX_PLANS) {
+        auto lru = plans.begin();
+
+        for (auto iter = plans.begin(); iter != plans.end(); ++iter) {
+            if (iter->second.lastUse < lru->second.lastUse) {
+                lru = iter;
+            }
+        }
+
+        evicted = std::move(lru->second.plan);
+        plans.erase(lru);
+    }
+
+    // scratch arrays, as planning may overwrite them
+    const size_t size = static_cast<size_t>(rows) * cols * howmany;
+    float* const tmpin = static_cast<float*>(fftwf_malloc(size * sizeof(float)));
+    float* const tmpout = key.inPlace ? tmpin : static_cast<float*>(fftwf_malloc(size * sizeof(float)));
+
+#ifdef RT_FFTW3F_OMP
+    fftwf_plan_with_nthreads(nthreads);
+#endif
+
+    const int n[2] = {rows, cols};
+    const fftw_r2r_kind kind[2] = {kind0, kind1};
+    const fftwf_plan newPlan = fftwf_plan_many_r2r(2, n, howmany, tmpin, nullptr, 1, rows * cols, tmpout, nullptr, 1, rows * cols, kind, flags);
+
+    if (tmpout != tmpin) {
+        fftwf_free(tmpout);
+    }
+
+    fftwf_free(tmpin);
+
+    if (!(flags & FFTW_ESTIMATE)) {
+        wisdomChanged = true;
+    }
+
+    if (rtengine::settings->verbose) {
+        printf("FFTW plan %dx%dx%d (%d threads) created\n", howmany, rows, cols, nthreads);
+    }
+
+    const rtengine::FftwPlanCache::Plan plan(newPlan ? std::shared_ptr<std::remove_pointer<fftwf_plan>::type>(newPlan, destroyPlan) : nullptr);
+    plans.emplace(key, CachedPlan{plan, ++useCount});
+    return plan;
+}
+
+}
+
+namespace rtengine
+{
+
+FftwPlanCache::Plan FftwPlanCache::r2r2d(int rows, int cols, const float* in, const float* out, fftw_r2r_kind kind0, fftw_r2r_kind kind1, unsigned flags, bool multiThread)
+{
+#if defined(RT_FFTW3F_OMP) && defined(_OPENMP)
+    const int nthreads = multiThread ? omp_get_max_threads() : 1;
+#else
+    const int nthreads = 1;
+#endif
+
+    // plans created on fftwf_malloc'ed arrays only accept arrays with the same alignment
+    if (fftwf_alignment_of(const_cast<float*>(in)) || fftwf_alignment_of(const_cast<float*>(out))) {
+        flags |= FFTW_UNALIGNED;
+    }
+
+    return getPlan(rows, cols, 1, in == out, kind0, kind1, flags, nthreads);
+}
+
+FftwPlanCache::Plan FftwPlanCache::r2r2dMany(int rows, int cols, int howmany, fftw_r2r_kind kind0, fftw_r2r_kind kind1, unsigned flags)
+{
+    return getPlan(rows, cols, howmany, false, kind0, kind1, flags, 1);
+}
+
+void FftwPlanCache::loadWisdom(const Glib::ustring& fname)
+{
+    MyMutex::MyLock lock(*fftwMutex);
+
+    wisdomFile = fname;
+    wisdomChanged = false;
+
+    if (Glib::file_test(fname, Glib::FILE_TEST_EXISTS) && !fftwf_import_wisdom_from_filename(Glib::filename_from_utf8(fname).c_str())) {
+        if (settings->verbose) {
+            printf("Could not import the FFTW wisdom from %s\n", fname.c_str());
+        }
+    }
+}
+
+void FftwPlanCache::saveWisdom()
+{
+    MyMutex::MyLock lock(*fftwMutex);
+
+    if (!wisdomChanged || wisdomFile.empty()) {
+        return;
+    }
+
+    g_mkdir_with_parents(Glib::path_get_dirname(wisdomFile).c_str(), 0755);
+
+    // Exported to a unique temporary file which then replaces the wisdom file, so that a crash
+    // or another instance saving at the same time can't leave a truncated or mixed up file
+    const std::string fileName = Glib::filename_from_utf8(wisdomFile);
+    std::string tmpName = fileName + ".XXXXXX";
+    const int fd = g_mkstemp(&tmpName[0]);
+
+    if (fd != -1) {
+        g_close(fd, nullptr);
+
+        if (fftwf_export_wisdom_to_filename(tmpName.c_str())) {
+            bool renamed = g_rename(tmpName.c_str(), fileName.c_str()) == 0;
+
+            if (!renamed) {
+                // Windows doesn't replace existing files
+                g_remove(fileName.c_str());
+                renamed = g_rename(tmpName.c_str(), fileName.c_str()) == 0;
+            }
+
+            if (renamed) {
+                wisdomChanged = false;
+                return;
+            }
+        }
+
+        g_remove(tmpName.c_str());
+    }
+
+    if (settings->verbose) {
+        printf("Could not export the FFTW wisdom to %s\n", wisdomFile.c_str());
+    }
+}
+
+void FftwPlanCache::clear()
+{
+    // released after the lock, as destroying the plans locks fftwMutex again
+    std::map<PlanKey, CachedPlan> cleared;
+
+    MyMutex::MyLock lock(*fftwMutex);
+    cleared.swap(plans);
+}
+
+}
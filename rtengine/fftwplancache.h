@@ -0,0 +1,82 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <memory>
+#include <type_traits>
+
+#include <fftw3.h>
+
+#include <glibmm/ustring.h>
+
+namespace rtengine
+{
+
+/**
+ * Process-wide cache of the single precision real-to-real FFTW plans, keyed by the shape of the transform.
+ *
+ * The plans are created once, under fftwMutex, on scratch arrays, so asking for a plan never touches the
+ * caller's data even with FFTW_MEASURE. The cache keeps at most MAX_PLANS of them and evicts the least
+ * recently used one beyond that. A plan is shared between the cache and the Plan handles returned by the
+ * getters and is only destroyed when the last of them goes away, so keep the handle, not the bare
+ * fftwf_plan, for as long as the plan is executed. Never call fftwf_cleanup() while the engine is running.
+ * Execute the plans with fftwf_execute_r2r(plan, in, out) on arrays with the same in-placeness as the
+ * ones passed to the getter, which is thread-safe and does not need any lock.
+ *
+ * The accumulated FFTW wisdom is persisted in the cache directory, so the FFTW_MEASURE plans of the
+ * denoise tools are only measured once per machine.
+ */
+class FftwPlanCache
+{
+public:
+    /** Shared handle to a cached plan, converts to the fftwf_plan to execute */
+    class Plan
+    {
+    public:
+        Plan() = default;
+        explicit Plan(std::shared_ptr<std::remove_pointer<fftwf_plan>::type> plan) : plan(std::move(plan)) {}
+
+        operator fftwf_plan() const
+        {
+            return plan.get();
+        }
+
+    private:
+        std::shared_ptr<std::remove_pointer<fftwf_plan>::type> plan;
+    };
+
+    /** Number of plans kept by the cache. The denoisers need a new set of plans for each image width */
+    static constexpr size_t MAX_PLANS = 32;
+
+    /** 2D transform of rows x cols floats.
+      * @param multiThread plan for omp_get_max_threads() threads when fftw is built with OpenMP support */
+    static Plan r2r2d(int rows, int cols, const float* in, const float* out, fftw_r2r_kind kind0, fftw_r2r_kind kind1, unsigned flags, bool multiThread = false);
+    /** howmany contiguous 2D transforms of rows x cols floats, as used for the blocks of the DCT denoisers.
+      * The plan is out of place, for arrays allocated with fftwf_malloc */
+    static Plan r2r2dMany(int rows, int cols, int howmany, fftw_r2r_kind kind0, fftw_r2r_kind kind1, unsigned flags);
+
+    /** Imports the wisdom from the given file, which is also the one written by saveWisdom() */
+    static void loadWisdom(const Glib::ustring& fname);
+    /** Writes the wisdom if plans were measured since it was loaded */
+    static void saveWisdom();
+    /** Drops all the cached plans. Those still held by a handle are destroyed when it is released */
+    static void clear();
+};
+
+}
@@ -16,6 +16,7 @@
  *  You should have received a copy of the GNU General Public License
  *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
@@ -24,6 +25,9 @@
 #include "gauss.h"
 
 #include "boxblur.h"
+#include "cpudispatch.h"
+#include "gauss_wide.h"
+#include "jaggedarray.h"
 #include "opthelper.h"
 #include "rt_math.h"
 
@@ -106,6 +110,149 @@ template<class T> void calculateYvVFactors( const T sigma, T &b1, T &b2, T &b3,
 
 }
 
+#ifdef RT_CPU_DISPATCH
+rtengine::YvVCoefficients calculateYvVCoefficients(double sigma)
+{
+    rtengine::YvVCoefficients c;
+    calculateYvVFactors<double>(sigma, c.b1, c.b2, c.b3, c.B, c.M);
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) {
+            c.M[i][j] *= (1.0 + c.b2 + (c.b1 - c.b3) * c.b3);
+            c.M[i][j] /= (1.0 + c.b1 - c.b2 + c.b3) * (1.0 - c.b1 - c.b2 - c.b3);
+        }
+
+    return c;
+}
+
+// Use the AVX2 or AVX-512 variants if the processor supports them.
+// Return false if the caller has to use the SSE2 variant instead.
+// The scratch buffers of the wide kernels are allocated here, so that no std::vector code is compiled with -mavx2/-mavx512f.
+template<class T> bool gaussHorizontalWide (T** src, T** dst, const int W, const int H, const float sigma)
+{
+    return false;
+}
+
+template<> bool gaussHorizontalWide<float> (float** src, float** dst, const int W, const int H, const float sigma)
+{
+    switch (rtengine::getSimdLevel()) {
+        case rtengine::SimdLevel::AVX512: {
+            std::vector<float> buffer(W * rtengine::GAUSS_AVX512_LANES);
+            rtengine::gaussHorizontalAvx512(src, dst, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        case rtengine::SimdLevel::AVX2: {
+            std::vector<float> buffer(W * rtengine::GAUSS_AVX2_LANES);
+            rtengine::gaussHorizontalAvx2(src, dst, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
+template<class T> bool gaussVerticalWide (T** src, T** dst, const int W, const int H, const float sigma)
+{
+    return false;
+}
+
+template<> bool gaussVerticalWide<float> (float** src, float** dst, const int W, const int H, const float sigma)
+{
+    switch (rtengine::getSimdLevel()) {
+        case rtengine::SimdLevel::AVX512: {
+            std::vector<float> buffer(H * rtengine::GAUSS_AVX512_LANES);
+            rtengine::gaussVerticalAvx512(src, dst, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        case rtengine::SimdLevel::AVX2: {
+            std::vector<float> buffer(H * rtengine::GAUSS_AVX2_LANES);
+            rtengine::gaussVerticalAvx2(src, dst, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
+template<class T> bool gaussVerticalMultWide (T** src, T** dst, const int W, const int H, const float sigma)
+{
+    return false;
+}
+
+template<> bool gaussVerticalMultWide<float> (float** src, float** dst, const int W, const int H, const float sigma)
+{
+    switch (rtengine::getSimdLevel()) {
+        case rtengine::SimdLevel::AVX512: {
+            std::vector<float> buffer(H * rtengine::GAUSS_AVX512_LANES);
+            rtengine::gaussVerticalMultAvx512(src, dst, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        case rtengine::SimdLevel::AVX2: {
+            std::vector<float> buffer(H * rtengine::GAUSS_AVX2_LANES);
+            rtengine::gaussVerticalMultAvx2(src, dst, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
+template<class T> bool gaussVerticalDivWide (T** src, T** dst, T** divBuffer, const int W, const int H, const float sigma)
+{
+    return false;
+}
+
+template<> bool gaussVerticalDivWide<float> (float** src, float** dst, float** divBuffer, const int W, const int H, const float sigma)
+{
+    switch (rtengine::getSimdLevel()) {
+        case rtengine::SimdLevel::AVX512: {
+            std::vector<float> buffer(H * rtengine::GAUSS_AVX512_LANES);
+            rtengine::gaussVerticalDivAvx512(src, dst, divBuffer, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        case rtengine::SimdLevel::AVX2: {
+            std::vector<float> buffer(H * rtengine::GAUSS_AVX2_LANES);
+            rtengine::gaussVerticalDivAvx2(src, dst, divBuffer, buffer.data(), W, H, calculateYvVCoefficients(sigma));
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+#else
+template<class T> bool gaussHorizontalWide (T** src, T** dst, const int W, const int H, const float sigma)
+{
+    return false;
+}
+
+template<class T> bool gaussVerticalWide (T** src, T** dst, const int W, const int H, const float sigma)
+{
+    return false;
+}
+
+template<class T> bool gaussVerticalMultWide (T** src, T** dst, const int W, const int H, const float sigma)
+{
+    return false;
+}
+
+template<class T> bool gaussVerticalDivWide (T** src, T** dst, T** divBuffer, const int W, const int H, const float sigma)
+{
+    return false;
+}
+#endif
+
 // classical filtering if the support window is small and src != dst
 template<class T> void gauss3x3 (T** RESTRICT src, T** RESTRICT dst, const int W, const int H, const T c0, const T c1, const T c2, const T b0, const T b1)
 {
@@ -1480,8 +1627,12 @@ template<class T> void gaussianBlurImpl(T** src, T** dst, const int W, const int
                     } else if (sigma <= GAUSS_7X7_LIMIT && src != dst) {
                         gauss7x7mult(src, dst, W, H, sigma);
                     } else {
-                        gaussHorizontalSse<T> (src, src, W, H, sigma);
-                        gaussVerticalSsemult<T> (src, dst, W, H, sigma);
+                        if (!gaussHorizontalWide<T> (src, src, W, H, sigma)) {
+                            gaussHorizontalSse<T> (src, src, W, H, sigma);
+                        }
+                        if (!gaussVerticalMultWide<T> (src, dst, W, H, sigma)) {
+                            gaussVerticalSsemult<T> (src, dst, W, H, sigma);
+                        }
                     }
                     break;
                 }
@@ -1492,15 +1643,23 @@ template<class T> void gaussianBlurImpl(T** src, T** dst, const int W, const int
                     } else if (sigma <= GAUSS_7X7_LIMIT && src != dst) {
                         gauss7x7div (src, dst, buffer2, W, H, sigma);
                     } else {
-                        gaussHorizontalSse<T> (src, dst, W, H, sigma);
-                        gaussVerticalSsediv<T> (dst, dst, buffer2, W, H, sigma);
+                        if (!gaussHorizontalWide<T> (src, dst, W, H, sigma)) {
+                            gaussHorizontalSse<T> (src, dst, W, H, sigma);
+                        }
+                        if (!gaussVerticalDivWide<T> (dst, dst, buffer2, W, H, sigma)) {
+                            gaussVerticalSsediv<T> (dst, dst, buffer2, W, H, sigma);
+                        }
                     }
                     break;
                 }
 
                 case GAUSS_STANDARD : {
-                    gaussHorizontalSse<T> (src, dst, W, H, sigma);
-                    gaussVerticalSse<T> (dst, dst, W, H, sigma);
+                    if (!gaussHorizontalWide<T> (src, dst, W, H, sigma)) {
+                        gaussHorizontalSse<T> (src, dst, W, H, sigma);
+                    }
+                    if (!gaussVerticalWide<T> (dst, dst, W, H, sigma)) {
+                        gaussVerticalSse<T> (dst, dst, W, H, sigma);
+                    }
                     break;
                 }
                 }
@@ -1559,3 +1718,105 @@ void gaussianBlur(float** src, float** dst, const int W, const int H, const doub
     gaussianBlurImpl<float>(src, dst, W, H, sigma, useBoxBlur, gausstype, buffer2);
 }
 
+void gaussianBlurPyramid(float** src, float** dst, const int W, const int H, const double sigma)
+{
+    // Lowest sigma of the downsampled blur: the box filter of the downsampling and the linear interpolation of the
+    // upsampling have to stay small in front of it
+    constexpr double PYRAMID_MIN_SIGMA = 8.0;
+    // Below, gaussianBlur uses the single precision filters, whose borders don't match the ones used here
+    constexpr double PYRAMID_LIMIT = 25.0;
+
+    int factor = 1;
+
+    while (sigma >= PYRAMID_LIMIT && sigma >= 2 * factor * PYRAMID_MIN_SIGMA && W >= 8 * factor && H >= 8 * factor) {
+        factor *= 2;
+    }
+
+    if (factor == 1) {
+        gaussianBlur(src, dst, W, H, sigma);
+        return;
+    }
+
+    const int w = (W + factor - 1) / factor;
+    const int h = (H + factor - 1) / factor;
+    // The variances of the box filter ((f² - 1) / 12) and of the linear interpolation ((f² - 1) / 6) are part of the blur
+    const double reducedSigma = std::sqrt(rtengine::SQR(sigma) - (rtengine::SQR(factor) - 1) / 4.0) / factor;
+
+    rtengine::JaggedArray<float>* reducedBuffer = nullptr;
+    rtengine::JaggedArray<float>* blurredBuffer = nullptr;
+
+#ifdef _OPENMP
+    // shared by the threads of the parallel region, if any
+    #pragma omp single copyprivate(reducedBuffer, blurredBuffer)
+#endif
+    {
+        reducedBuffer = new rtengine::JaggedArray<float>(w, h);
+        blurredBuffer = new rtengine::JaggedArray<float>(w, h);
+    }
+
+    float** const reduced = *reducedBuffer;
+    float** const blurred = *blurredBuffer;
+
+    // downsample by averaging factor x factor blocks
+#ifdef _OPENMP
+    #pragma omp for
+#endif
+    for (int y = 0; y < h; ++y) {
+        const int rowBegin = y * factor;
+        const int rowEnd = std::min(rowBegin + factor, H);
+
+        std::fill(reduced[y], reduced[y] + w, 0.f);
+
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            for (int j = 0; j < W; ++j) {
+                reduced[y][j / factor] += src[i][j];
+            }
+        }
+
+        const float rowScale = 1.f / (factor * (rowEnd - rowBegin));
+
+        for (int x = 0; x < w - 1; ++x) {
+            reduced[y][x] *= rowScale;
+        }
+
+        reduced[y][w - 1] /= (rowEnd - rowBegin) * (W - (w - 1) * factor);
+    }
+
+    // same double precision filters as gaussianBlur for large sigmas, whatever reducedSigma
+    gaussHorizontal<float>(reduced, blurred, w, h, reducedSigma);
+    gaussVertical<float>(blurred, blurred, w, h, reducedSigma);
+
+    // upsample with linear interpolation between the centers of the blocks
+    std::vector<int> x0s(W);
+    std::vector<float> xWeights(W);
+
+    for (int x = 0; x < W; ++x) {
+        const float pos = rtengine::LIM((x + 0.5f) / factor - 0.5f, 0.f, static_cast<float>(w - 1));
+        x0s[x] = std::min(static_cast<int>(pos), w - 2);
+        xWeights[x] = pos - x0s[x];
+    }
+
+#ifdef _OPENMP
+    #pragma omp for
+#endif
+    for (int y = 0; y < H; ++y) {
+        const float pos = rtengine::LIM((y + 0.5f) / factor - 0.5f, 0.f, static_cast<float>(h - 1));
+        const int y0 = std::min(static_cast<int>(pos), h - 2);
+        const float yWeight = pos - y0;
+
+        for (int x = 0; x < W; ++x) {
+            const int x0 = x0s[x];
+            const float top = blurred[y0][x0] + xWeights[x] * (blurred[y0][x0 + 1] - blurred[y0][x0]);
+            const float bottom = blurred[y0 + 1][x0] + xWeights[x] * (blurred[y0 + 1][x0 + 1] - blurred[y0 + 1][x0]);
+            dst[y][x] = top + yWeight * (bottom - top);
+        }
+    }
+
+#ifdef _OPENMP
+    #pragma omp single
+#endif
+    {
+        delete reducedBuffer;
+        delete blurredBuffer;
+    }
+}
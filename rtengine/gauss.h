@@ -23,3 +23,10 @@ static constexpr auto GAUSS_SKIP = 0.25;
 
 
 void gaussianBlur(float** src, float** dst, const int W, const int H, const double sigma, bool useBoxBlur = false, eGaussType gausstype = GAUSS_STANDARD, float** buffer2 = nullptr);
+
+// Gaussian blur for large sigmas (GAUSS_STANDARD only): blurs a copy of src downsampled by a power of 2, keeping
+// a sigma of at least 8 px at the lower resolution, and interpolates it back. Away from the image borders, it stays
+// within 1% of the signal range of gaussianBlur (0.1% from sigma 60), about the error of gaussianBlur itself. At the
+// borders, the last blocks are repeated instead of the last pixels. Falls back to gaussianBlur below sigma 25.
+// Like gaussianBlur, it can be called by all the threads of a parallel region. src and dst may be the same.
+void gaussianBlurPyramid(float** src, float** dst, const int W, const int H, const double sigma);
@@ -0,0 +1,54 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with -mavx512f, see rtengine/CMakeLists.txt
+#include "gauss_wide_kernels.h"
+
+namespace
+{
+
+typedef float vfloat16 __attribute__((vector_size(64)));
+static_assert(sizeof(vfloat16) == rtengine::GAUSS_AVX512_LANES * sizeof(float), "size of the scratch buffers");
+
+}
+
+namespace rtengine
+{
+
+void gaussHorizontalAvx512(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c)
+{
+    gaussHorizontalWide<vfloat16>(src, dst, buffer, W, H, c);
+}
+
+void gaussVerticalAvx512(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c)
+{
+    gaussVerticalWide<vfloat16, VerticalOutput::STORE>(src, dst, nullptr, buffer, W, H, c);
+}
+
+void gaussVerticalMultAvx512(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c)
+{
+    gaussVerticalWide<vfloat16, VerticalOutput::MULT>(src, dst, nullptr, buffer, W, H, c);
+}
+
+void gaussVerticalDivAvx512(float** src, float** dst, float** divBuffer, float* buffer, int W, int H, const YvVCoefficients& c)
+{
+    gaussVerticalWide<vfloat16, VerticalOutput::DIV>(src, dst, divBuffer, buffer, W, H, c);
+}
+
+}
@@ -0,0 +1,51 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+namespace rtengine
+{
+
+// Coefficients of the recursive (Young - van Vliet) gaussian approximation,
+// including the boundary correction matrix of Triggs and Sdika
+struct YvVCoefficients {
+    double B;
+    double b1;
+    double b2;
+    double b3;
+    double M[3][3];
+};
+
+// Wide vector variants of the recursive gaussian blur, compiled with -mavx2 resp. -mavx512f.
+// They must only be called if getSimdLevel() reports support for the instruction set.
+// Like their SSE2 counterparts in gauss.cc, they are meant to be called from inside an OpenMP parallel region.
+// buffer is a scratch area of W (horizontal) resp. H (vertical) times GAUSS_AVX2_LANES resp. GAUSS_AVX512_LANES floats per thread.
+// The Mult and Div variants are the vertical passes of GAUSS_MULT (dst *= blurred src) and GAUSS_DIV (dst = divBuffer / blurred src).
+constexpr int GAUSS_AVX2_LANES = 8;
+constexpr int GAUSS_AVX512_LANES = 16;
+
+void gaussHorizontalAvx2(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c);
+void gaussVerticalAvx2(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c);
+void gaussVerticalMultAvx2(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c);
+void gaussVerticalDivAvx2(float** src, float** dst, float** divBuffer, float* buffer, int W, int H, const YvVCoefficients& c);
+void gaussHorizontalAvx512(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c);
+void gaussVerticalAvx512(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c);
+void gaussVerticalMultAvx512(float** src, float** dst, float* buffer, int W, int H, const YvVCoefficients& c);
+void gaussVerticalDivAvx512(float** src, float** dst, float** divBuffer, float* buffer, int W, int H, const YvVCoefficients& c);
+
+}
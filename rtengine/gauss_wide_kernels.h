@@ -0,0 +1,364 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+// Implementation of the wide vector gaussian kernels declared in gauss_wide.h, written once
+// for GCC vector extension types and included by gauss_avx2.cc and gauss_avx512.cc.
+// These translation units are compiled with instruction set flags the baseline build doesn't have,
+// so only include headers here which don't emit inline code shared with the rest of rtengine.
+
+#include <cstring>
+
+#include "gauss_wide.h"
+
+namespace
+{
+
+// Vectors of the block sizes of the SSE2 code in gauss.cc, used for the remainders of the wide passes
+typedef float vfloatSse4 __attribute__((vector_size(16)));
+typedef float vfloatSse8 __attribute__((vector_size(32)));
+
+template<typename V>
+constexpr int lanes()
+{
+    return sizeof(V) / sizeof(float);
+}
+
+template<typename V>
+inline V loadv(const float* p)
+{
+    V v;
+    std::memcpy(&v, p, sizeof(V));
+    return v;
+}
+
+template<typename V>
+inline void storev(float* p, const V& v)
+{
+    std::memcpy(p, &v, sizeof(V));
+}
+
+template<typename V>
+inline V broadcast(double value)
+{
+    return V{} + static_cast<float>(value);
+}
+
+// v where v > 0, other elsewhere (including NaN)
+template<typename V>
+inline V selectPositive(const V& v, const V& other)
+{
+    typedef decltype(v > v) Mask;
+    const Mask mask = v > V{};
+    return (V)(((Mask)v & mask) | ((Mask)other & ~mask));
+}
+
+template<typename V>
+inline V gatherColumn(float** src, int row, int col)
+{
+    V v;
+
+    for (int k = 0; k < lanes<V>(); ++k) {
+        v[k] = src[row + k][col];
+    }
+
+    return v;
+}
+
+// Blurs the rows i to i + lanes<V>() - 1, tmp holds W * lanes<V>() floats
+template<typename V>
+inline void gaussHorizontalBlock(float** src, float** dst, float* tmp, const int i, const int W, const rtengine::YvVCoefficients& c)
+{
+    constexpr int N = lanes<V>();
+    const double B = c.B, b1 = c.b1, b2 = c.b2, b3 = c.b3;
+    const auto& M = c.M;
+    const V Bv = broadcast<V>(B);
+    const V b1v = broadcast<V>(b1);
+    const V b2v = broadcast<V>(b2);
+    const V b3v = broadcast<V>(b3);
+
+    V Tv = gatherColumn<V>(src, i, 0);
+    V Tm3v = Tv * (Bv + b1v + b2v + b3v);
+    storev(tmp, Tm3v);
+
+    V Tm2v = gatherColumn<V>(src, i, 1) * Bv + Tm3v * b1v + Tv * (b2v + b3v);
+    storev(tmp + N, Tm2v);
+
+    V Rv = gatherColumn<V>(src, i, 2) * Bv + Tm2v * b1v + Tm3v * b2v + Tv * b3v;
+    storev(tmp + 2 * N, Rv);
+
+    for (int j = 3; j < W; j++) {
+        Tv = Rv;
+        Rv = gatherColumn<V>(src, i, j) * Bv + Tv * b1v + Tm2v * b2v + Tm3v * b3v;
+        storev(tmp + j * N, Rv);
+        Tm3v = Tm2v;
+        Tm2v = Tv;
+    }
+
+    Tv = gatherColumn<V>(src, i, W - 1);
+
+    const V temp2Wp1 = Tv + broadcast<V>(M[2][0]) * (Rv - Tv) + broadcast<V>(M[2][1]) * (Tm2v - Tv) + broadcast<V>(M[2][2]) * (Tm3v - Tv);
+    const V temp2W = Tv + broadcast<V>(M[1][0]) * (Rv - Tv) + broadcast<V>(M[1][1]) * (Tm2v - Tv) + broadcast<V>(M[1][2]) * (Tm3v - Tv);
+
+    Rv = Tv + broadcast<V>(M[0][0]) * (Rv - Tv) + broadcast<V>(M[0][1]) * (Tm2v - Tv) + broadcast<V>(M[0][2]) * (Tm3v - Tv);
+    storev(tmp + (W - 1) * N, Rv);
+
+    Tm2v = Bv * Tm2v + b1v * Rv + b2v * temp2W + b3v * temp2Wp1;
+    storev(tmp + (W - 2) * N, Tm2v);
+
+    Tm3v = Bv * Tm3v + b1v * Tm2v + b2v * Rv + b3v * temp2W;
+    storev(tmp + (W - 3) * N, Tm3v);
+
+    Tv = Rv;
+    Rv = Tm3v;
+    Tm3v = Tv;
+
+    for (int j = W - 4; j >= 0; j--) {
+        Tv = Rv;
+        Rv = loadv<V>(tmp + j * N) * Bv + Tv * b1v + Tm2v * b2v + Tm3v * b3v;
+        storev(tmp + j * N, Rv);
+        Tm3v = Tm2v;
+        Tm2v = Tv;
+    }
+
+    for (int k = 0; k < N; k++) {
+        for (int j = 0; j < W; j++) {
+            dst[i + k][j] = tmp[j * N + k];
+        }
+    }
+}
+
+// processes lanes<V>() rows per iteration, tmp holds W * lanes<V>() floats
+template<typename V>
+void gaussHorizontalWide(float** src, float** dst, float* tmp, const int W, const int H, const rtengine::YvVCoefficients& c)
+{
+    constexpr int N = lanes<V>();
+    const double B = c.B, b1 = c.b1, b2 = c.b2, b3 = c.b3;
+    const auto& M = c.M;
+
+#ifdef _OPENMP
+    #pragma omp for nowait
+#endif
+
+    for (int i = 0; i < H - (N - 1); i += N) {
+        gaussHorizontalBlock<V>(src, dst, tmp, i, W, c);
+    }
+
+// The remaining rows are done like in gaussHorizontalSse(), in blocks of 4 and then without vectors, to get the same results
+#ifdef _OPENMP
+    #pragma omp single
+#endif
+    {
+        for (int i = H - (H % N); i < H - 3; i += 4) {
+            gaussHorizontalBlock<vfloatSse4>(src, dst, tmp, i, W, c);
+        }
+
+        for (int i = H - (H % 4); i < H; i++) {
+            tmp[0] = src[i][0] * (B + b1 + b2 + b3);
+            tmp[1] = B * src[i][1] + b1 * tmp[0]  + src[i][0] * (b2 + b3);
+            tmp[2] = B * src[i][2] + b1 * tmp[1]  + b2 * tmp[0]  + b3 * src[i][0];
+
+            for (int j = 3; j < W; j++) {
+                tmp[j] = B * src[i][j] + b1 * tmp[j - 1] + b2 * tmp[j - 2] + b3 * tmp[j - 3];
+            }
+
+            float temp2Wm1 = src[i][W - 1] + M[0][0] * (tmp[W - 1] - src[i][W - 1]) + M[0][1] * (tmp[W - 2] - src[i][W - 1]) + M[0][2] * (tmp[W - 3] - src[i][W - 1]);
+            float temp2W   = src[i][W - 1] + M[1][0] * (tmp[W - 1] - src[i][W - 1]) + M[1][1] * (tmp[W - 2] - src[i][W - 1]) + M[1][2] * (tmp[W - 3] - src[i][W - 1]);
+            float temp2Wp1 = src[i][W - 1] + M[2][0] * (tmp[W - 1] - src[i][W - 1]) + M[2][1] * (tmp[W - 2] - src[i][W - 1]) + M[2][2] * (tmp[W - 3] - src[i][W - 1]);
+
+            tmp[W - 1] = temp2Wm1;
+            tmp[W - 2] = B * tmp[W - 2] + b1 * tmp[W - 1] + b2 * temp2W + b3 * temp2Wp1;
+            tmp[W - 3] = B * tmp[W - 3] + b1 * tmp[W - 2] + b2 * tmp[W - 1] + b3 * temp2W;
+
+            for (int j = W - 4; j >= 0; j--) {
+                tmp[j] = B * tmp[j] + b1 * tmp[j + 1] + b2 * tmp[j + 2] + b3 * tmp[j + 3];
+            }
+
+            for (int j = 0; j < W; j++) {
+                dst[i][j] = tmp[j];
+            }
+        }
+    }
+}
+
+// What the vertical pass does with the blurred values, see gaussianBlur()
+enum class VerticalOutput {
+    STORE, // dst = blurred
+    MULT,  // dst *= blurred
+    DIV    // dst = divBuffer / blurred, dividing by 1 where blurred <= 0
+};
+
+// Like the SSE2 code, GAUSS_DIV only clamps the result to 0 above the last 3 rows
+template<VerticalOutput output, typename V>
+inline void storeVertical(float** dst, float** divBuffer, int row, int col, const V& v, bool clamp)
+{
+    switch (output) {
+        case VerticalOutput::STORE: {
+            storev(&dst[row][col], v);
+            break;
+        }
+
+        case VerticalOutput::MULT: {
+            storev(&dst[row][col], loadv<V>(&dst[row][col]) * v);
+            break;
+        }
+
+        case VerticalOutput::DIV: {
+            const V quotient = loadv<V>(&divBuffer[row][col]) / selectPositive(v, V{} + 1.f);
+            storev(&dst[row][col], clamp ? selectPositive(quotient, V{}) : quotient);
+            break;
+        }
+    }
+}
+
+template<VerticalOutput output>
+inline void storeVertical(float** dst, float** divBuffer, int row, int col, float v)
+{
+    switch (output) {
+        case VerticalOutput::STORE: {
+            dst[row][col] = v;
+            break;
+        }
+
+        case VerticalOutput::MULT: {
+            dst[row][col] *= v;
+            break;
+        }
+
+        case VerticalOutput::DIV: {
+            const float quotient = divBuffer[row][col] / (v > 0.f ? v : 1.f);
+            dst[row][col] = quotient > 0.f ? quotient : 0.f;
+            break;
+        }
+    }
+}
+
+// Blurs the columns i to i + lanes<V>() - 1, tmp holds H * lanes<V>() floats
+template<typename V, VerticalOutput output>
+inline void gaussVerticalBlock(float** src, float** dst, float** divBuffer, float* tmp, const int i, const int H, const rtengine::YvVCoefficients& c)
+{
+    constexpr int N = lanes<V>();
+    const double B = c.B, b1 = c.b1, b2 = c.b2, b3 = c.b3;
+    const auto& M = c.M;
+    const V Bv = broadcast<V>(B);
+    const V b1v = broadcast<V>(b1);
+    const V b2v = broadcast<V>(b2);
+    const V b3v = broadcast<V>(b3);
+
+    V Tv = loadv<V>(&src[0][i]);
+    V Rv = Tv * (Bv + b1v + b2v + b3v);
+    V Tm3v = Rv;
+    storev(tmp, Rv);
+
+    Rv = loadv<V>(&src[1][i]) * Bv + Rv * b1v + Tv * (b2v + b3v);
+    V Tm2v = Rv;
+    storev(tmp + N, Rv);
+
+    Rv = loadv<V>(&src[2][i]) * Bv + Rv * b1v + Tm3v * b2v + Tv * b3v;
+    storev(tmp + 2 * N, Rv);
+
+    for (int j = 3; j < H; j++) {
+        Tv = Rv;
+        Rv = loadv<V>(&src[j][i]) * Bv + Tv * b1v + Tm2v * b2v + Tm3v * b3v;
+        storev(tmp + j * N, Rv);
+        Tm3v = Tm2v;
+        Tm2v = Tv;
+    }
+
+    Tv = loadv<V>(&src[H - 1][i]);
+
+    const V temp2Wp1 = Tv + broadcast<V>(M[2][0]) * (Rv - Tv) + broadcast<V>(M[2][1]) * (Tm2v - Tv) + broadcast<V>(M[2][2]) * (Tm3v - Tv);
+    const V temp2W = Tv + broadcast<V>(M[1][0]) * (Rv - Tv) + broadcast<V>(M[1][1]) * (Tm2v - Tv) + broadcast<V>(M[1][2]) * (Tm3v - Tv);
+
+    Rv = Tv + broadcast<V>(M[0][0]) * (Rv - Tv) + broadcast<V>(M[0][1]) * (Tm2v - Tv) + broadcast<V>(M[0][2]) * (Tm3v - Tv);
+    storeVertical<output>(dst, divBuffer, H - 1, i, Rv, false);
+
+    Tm2v = Bv * Tm2v + b1v * Rv + b2v * temp2W + b3v * temp2Wp1;
+    storeVertical<output>(dst, divBuffer, H - 2, i, Tm2v, false);
+
+    Tm3v = Bv * Tm3v + b1v * Tm2v + b2v * Rv + b3v * temp2W;
+    storeVertical<output>(dst, divBuffer, H - 3, i, Tm3v, false);
+
+    Tv = Rv;
+    Rv = Tm3v;
+    Tm3v = Tv;
+
+    for (int j = H - 4; j >= 0; j--) {
+        Tv = Rv;
+        Rv = loadv<V>(tmp + j * N) * Bv + Tv * b1v + Tm2v * b2v + Tm3v * b3v;
+        storeVertical<output>(dst, divBuffer, j, i, Rv, true);
+        Tm3v = Tm2v;
+        Tm2v = Tv;
+    }
+}
+
+// processes lanes<V>() columns per iteration, tmp holds H * lanes<V>() floats
+template<typename V, VerticalOutput output>
+void gaussVerticalWide(float** src, float** dst, float** divBuffer, float* tmp, const int W, const int H, const rtengine::YvVCoefficients& c)
+{
+    constexpr int N = lanes<V>();
+    const double B = c.B, b1 = c.b1, b2 = c.b2, b3 = c.b3;
+    const auto& M = c.M;
+
+#ifdef _OPENMP
+    #pragma omp for nowait
+#endif
+
+    for (int i = 0; i < W - (N - 1); i += N) {
+        gaussVerticalBlock<V, output>(src, dst, divBuffer, tmp, i, H, c);
+    }
+
+// The remaining columns are done like in the gaussVerticalSse*() functions, in blocks of 8 and then without vectors, to get the same results
+#ifdef _OPENMP
+    #pragma omp single
+#endif
+    {
+        for (int i = W - (W % N); i < W - 7; i += 8) {
+            gaussVerticalBlock<vfloatSse8, output>(src, dst, divBuffer, tmp, i, H, c);
+        }
+
+        for (int i = W - (W % 8); i < W; i++) {
+            tmp[0] = src[0][i] * (B + b1 + b2 + b3);
+            tmp[1] = B * src[1][i] + b1 * tmp[0] + src[0][i] * (b2 + b3);
+            tmp[2] = B * src[2][i] + b1 * tmp[1] + b2 * tmp[0] + b3 * src[0][i];
+
+            for (int j = 3; j < H; j++) {
+                tmp[j] = B * src[j][i] + b1 * tmp[j - 1] + b2 * tmp[j - 2] + b3 * tmp[j - 3];
+            }
+
+            float temp2Hm1 = src[H - 1][i] + M[0][0] * (tmp[H - 1] - src[H - 1][i]) + M[0][1] * (tmp[H - 2] - src[H - 1][i]) + M[0][2] * (tmp[H - 3] - src[H - 1][i]);
+            float temp2H   = src[H - 1][i] + M[1][0] * (tmp[H - 1] - src[H - 1][i]) + M[1][1] * (tmp[H - 2] - src[H - 1][i]) + M[1][2] * (tmp[H - 3] - src[H - 1][i]);
+            float temp2Hp1 = src[H - 1][i] + M[2][0] * (tmp[H - 1] - src[H - 1][i]) + M[2][1] * (tmp[H - 2] - src[H - 1][i]) + M[2][2] * (tmp[H - 3] - src[H - 1][i]);
+
+            tmp[H - 1] = temp2Hm1;
+            tmp[H - 2] = B * tmp[H - 2] + b1 * tmp[H - 1] + b2 * temp2H + b3 * temp2Hp1;
+            tmp[H - 3] = B * tmp[H - 3] + b1 * tmp[H - 2] + b2 * tmp[H - 1] + b3 * temp2H;
+
+            for (int j = H - 4; j >= 0; j--) {
+                tmp[j] = B * tmp[j] + b1 * tmp[j + 1] + b2 * tmp[j + 2] + b3 * tmp[j + 3];
+            }
+
+            for (int j = 0; j < H; j++) {
+                storeVertical<output>(dst, divBuffer, j, i, tmp[j]);
+            }
+        }
+    }
+}
+
+}
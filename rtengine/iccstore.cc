@@ -16,6 +16,8 @@
  *  You should have received a copy of the GNU General Public License
  *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <array>
+#include <cmath>
 #include <cstring>
 #include <map>
 #include <string>
@@ -36,6 +38,8 @@
 #include "iccstore.h"
 
 #include "iccmatrices.h"
+#include "rt_math.h"
+#include "sleef.h"
 #include "utils.h"
 
 #include "rtgui/options.h"
@@ -290,6 +294,109 @@ Glib::ustring get_profile_description(cmsHPROFILE profile)
     return std::string(&buf[0]);
 }
 
+
+constexpr int MATRIX_SHAPER_LUT_SIZE = 4096;
+
+// lcms uses the LUT based tags of a profile in priority, whatever its matrix-shaper tags
+bool isPlainMatrixShaper(cmsHPROFILE profile)
+{
+    if (!profile || cmsGetColorSpace(profile) != cmsSigRgbData || !cmsIsMatrixShaper(profile)) {
+        return false;
+    }
+
+    const cmsProfileClassSignature profileClass = cmsGetDeviceClass(profile);
+
+    if (profileClass == cmsSigLinkClass || profileClass == cmsSigAbstractClass || profileClass == cmsSigNamedColorClass) {
+        return false;
+    }
+
+    constexpr cmsTagSignature lutTags[] = {
+        cmsSigAToB0Tag, cmsSigAToB1Tag, cmsSigAToB2Tag,
+        cmsSigBToA0Tag, cmsSigBToA1Tag, cmsSigBToA2Tag,
+        cmsSigDToB0Tag, cmsSigDToB1Tag, cmsSigDToB2Tag, cmsSigDToB3Tag,
+        cmsSigBToD0Tag, cmsSigBToD1Tag, cmsSigBToD2Tag, cmsSigBToD3Tag
+    };
+
+    for (const auto tag : lutTags) {
+        if (cmsIsTag(profile, tag)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Reads the RGB -> XYZ matrix and duplicates the TRCs of a matrix-shaper profile
+bool readMatrixShaper(cmsHPROFILE profile, std::array<std::array<double, 3>, 3>& matrix, cmsToneCurve* trc[3])
+{
+    constexpr cmsTagSignature colorantTags[3] = {cmsSigRedColorantTag, cmsSigGreenColorantTag, cmsSigBlueColorantTag};
+    constexpr cmsTagSignature trcTags[3] = {cmsSigRedTRCTag, cmsSigGreenTRCTag, cmsSigBlueTRCTag};
+
+    for (int c = 0; c < 3; ++c) {
+        const cmsCIEXYZ* const colorant = static_cast<const cmsCIEXYZ*>(cmsReadTag(profile, colorantTags[c]));
+        const cmsToneCurve* const curve = static_cast<const cmsToneCurve*>(cmsReadTag(profile, trcTags[c]));
+
+        if (!colorant || !curve) {
+            return false;
+        }
+
+        matrix[0][c] = colorant->X;
+        matrix[1][c] = colorant->Y;
+        matrix[2][c] = colorant->Z;
+        trc[c] = cmsDupToneCurve(curve);
+    }
+
+    return true;
+}
+
+bool hasZeroBlack(cmsToneCurve* const trc[3])
+{
+    for (int c = 0; c < 3; ++c) {
+        if (std::fabs(cmsEvalToneCurveFloat(trc[c], 0.f)) > 1e-6f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isLinear(cmsToneCurve* const trc[3])
+{
+    return cmsIsToneCurveLinear(trc[0]) && cmsIsToneCurveLinear(trc[1]) && cmsIsToneCurveLinear(trc[2]);
+}
+
+// The output curves are indexed by sqrt(value) to keep the steep start of the gamma encodings accurate
+void applyCurve(const LUTf& lut, const cmsToneCurve* trc, bool sqrtIndex, float* row, int width)
+{
+    const float scale = lut.getSize() - 1;
+    int i = 0;
+
+#ifdef __SSE2__
+    const vfloat scalev = F2V(scale);
+    const vfloat onev = F2V(1.f);
+
+    for (; i < width - 3; i += 4) {
+        const vfloat valv = LVFU(row[i]);
+        const int outOfRange = _mm_movemask_ps((vfloat)vorm(vmaskf_lt(valv, ZEROV), vmaskf_gt(valv, onev)));
+
+        if (outOfRange) {
+            // out of gamut values, evaluate the curve itself
+            for (int j = 0; j < 4; ++j) {
+                const float val = row[i + j];
+                row[i + j] = outOfRange & (1 << j) ? cmsEvalToneCurveFloat(trc, val) : lut[(sqrtIndex ? std::sqrt(val) : val) * scale];
+            }
+        } else {
+            STVFU(row[i], lut[(sqrtIndex ? vsqrtf(valv) : valv) * scalev]);
+        }
+    }
+#endif
+
+    for (; i < width; ++i) {
+        const float val = row[i];
+        row[i] = val >= 0.f && val <= 1.f ? lut[(sqrtIndex ? std::sqrt(val) : val) * scale] : cmsEvalToneCurveFloat(trc, val);
+    }
+}
+
 } // namespace
 
 
@@ -1249,3 +1356,154 @@ cmsHPROFILE rtengine::ICCStore::createFromMatrix(const double matrix[3][3], bool
     delete [] oprof;
     return p;
 }
+
+std::unique_ptr<rtengine::MatrixShaperTransform> rtengine::ICCStore::createMatrixShaperTransform(cmsHPROFILE iprof, cmsHPROFILE oprof, int intent, bool bpc)
+{
+    // Absolute colorimetric depends on the media white point, let lcms handle it
+    if (intent == INTENT_ABSOLUTE_COLORIMETRIC || !isPlainMatrixShaper(oprof) || (iprof && !isPlainMatrixShaper(iprof))) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MatrixShaperTransform> transform(new MatrixShaperTransform);
+
+    std::array<std::array<double, 3>, 3> outMatrix;
+    std::array<std::array<double, 3>, 3> inMatrix = {};
+
+    if (!readMatrixShaper(oprof, outMatrix, transform->outputTRC) || (iprof && !readMatrixShaper(iprof, inMatrix, transform->inputTRC))) {
+        return nullptr;
+    }
+
+    // lcms forces the black point compensation of v4 profiles in perceptual and saturation intents. It's a no-op as long as
+    // both black points are at zero, which is always true for Lab
+    const bool usesBpc = bpc || (intent != INTENT_RELATIVE_COLORIMETRIC && (cmsGetEncodedICCversion(oprof) >= 0x4000000 || (iprof && cmsGetEncodedICCversion(iprof) >= 0x4000000)));
+
+    if (usesBpc && (!hasZeroBlack(transform->outputTRC) || (iprof && !hasZeroBlack(transform->inputTRC)))) {
+        return nullptr;
+    }
+
+    std::array<std::array<double, 3>, 3> xyzToOut;
+
+    if (!invertMatrix(outMatrix, xyzToOut)) {
+        return nullptr;
+    }
+
+    // Lab input is converted to XYZ in [0;65535]
+    const std::array<std::array<double, 3>, 3> matrix = iprof ? dotProduct(xyzToOut, inMatrix) : xyzToOut;
+    const double matrixScale = iprof ? 1.0 : 1.0 / 65535.0;
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            transform->matrix[i][j] = matrix[i][j] * matrixScale;
+        }
+    }
+
+    transform->linearInput = !iprof || isLinear(transform->inputTRC);
+    transform->linearOutput = isLinear(transform->outputTRC);
+
+    for (int c = 0; c < 3; ++c) {
+        if (!transform->linearInput) {
+            transform->inputCurves[c](MATRIX_SHAPER_LUT_SIZE);
+
+            for (int i = 0; i < MATRIX_SHAPER_LUT_SIZE; ++i) {
+                transform->inputCurves[c][i] = cmsEvalToneCurveFloat(transform->inputTRC[c], static_cast<float>(i) / (MATRIX_SHAPER_LUT_SIZE - 1));
+            }
+        }
+
+        // lcms applies the reversed TRCs to output a matrix-shaper profile
+        cmsToneCurve* const reversed = cmsReverseToneCurve(transform->outputTRC[c]);
+
+        if (!reversed) {
+            return nullptr;
+        }
+
+        cmsFreeToneCurve(transform->outputTRC[c]);
+        transform->outputTRC[c] = reversed;
+
+        if (!transform->linearOutput) {
+            transform->outputCurves[c](MATRIX_SHAPER_LUT_SIZE);
+
+            for (int i = 0; i < MATRIX_SHAPER_LUT_SIZE; ++i) {
+                const float val = static_cast<float>(i) / (MATRIX_SHAPER_LUT_SIZE - 1);
+                transform->outputCurves[c][i] = cmsEvalToneCurveFloat(reversed, val * val);
+            }
+        }
+    }
+
+    return transform;
+}
+
+rtengine::MatrixShaperTransform::MatrixShaperTransform() :
+    matrix{},
+    linearInput(true),
+    linearOutput(true),
+    inputTRC{},
+    outputTRC{}
+{
+}
+
+rtengine::MatrixShaperTransform::~MatrixShaperTransform()
+{
+    for (int c = 0; c < 3; ++c) {
+        if (inputTRC[c]) {
+            cmsFreeToneCurve(inputTRC[c]);
+        }
+
+        if (outputTRC[c]) {
+            cmsFreeToneCurve(outputTRC[c]);
+        }
+    }
+}
+
+void rtengine::MatrixShaperTransform::labToRgb(const float* L, const float* a, const float* b, float* R, float* G, float* B, int width) const
+{
+    Color::Lab2RGB(L, a, b, R, G, B, matrix, width);
+
+    if (!linearOutput) {
+        applyCurve(outputCurves[0], outputTRC[0], true, R, width);
+        applyCurve(outputCurves[1], outputTRC[1], true, G, width);
+        applyCurve(outputCurves[2], outputTRC[2], true, B, width);
+    }
+}
+
+void rtengine::MatrixShaperTransform::rgbToRgb(float* R, float* G, float* B, int width) const
+{
+    if (!linearInput) {
+        applyCurve(inputCurves[0], inputTRC[0], false, R, width);
+        applyCurve(inputCurves[1], inputTRC[1], false, G, width);
+        applyCurve(inputCurves[2], inputTRC[2], false, B, width);
+    }
+
+    int i = 0;
+
+#ifdef __SSE2__
+    const vfloat matrixv[3][3] = {
+        {F2V(matrix[0][0]), F2V(matrix[0][1]), F2V(matrix[0][2])},
+        {F2V(matrix[1][0]), F2V(matrix[1][1]), F2V(matrix[1][2])},
+        {F2V(matrix[2][0]), F2V(matrix[2][1]), F2V(matrix[2][2])}
+    };
+
+    for (; i < width - 3; i += 4) {
+        const vfloat rv = LVFU(R[i]);
+        const vfloat gv = LVFU(G[i]);
+        const vfloat bv = LVFU(B[i]);
+        STVFU(R[i], matrixv[0][0] * rv + matrixv[0][1] * gv + matrixv[0][2] * bv);
+        STVFU(G[i], matrixv[1][0] * rv + matrixv[1][1] * gv + matrixv[1][2] * bv);
+        STVFU(B[i], matrixv[2][0] * rv + matrixv[2][1] * gv + matrixv[2][2] * bv);
+    }
+#endif
+
+    for (; i < width; ++i) {
+        const float r = R[i];
+        const float g = G[i];
+        const float b = B[i];
+        R[i] = matrix[0][0] * r + matrix[0][1] * g + matrix[0][2] * b;
+        G[i] = matrix[1][0] * r + matrix[1][1] * g + matrix[1][2] * b;
+        B[i] = matrix[2][0] * r + matrix[2][1] * g + matrix[2][2] * b;
+    }
+
+    if (!linearOutput) {
+        applyCurve(outputCurves[0], outputTRC[0], true, R, width);
+        applyCurve(outputCurves[1], outputTRC[1], true, G, width);
+        applyCurve(outputCurves[2], outputTRC[2], true, B, width);
+    }
+}
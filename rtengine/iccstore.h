@@ -27,6 +27,9 @@
 
 #include <lcms2.h>
 
+#include "LUT.h"
+#include "noncopyable.h"
+
 namespace rtengine
 {
 
@@ -54,6 +57,38 @@ private:
     std::string data;
 };
 
+/**
+ * @brief Native replacement for the lcms transforms from Lab or a matrix-shaper RGB profile to a matrix-shaper RGB profile
+ *
+ * Such transforms reduce to a 3x3 matrix between per channel tone curves, so they are applied row by row with SIMD
+ * and 1D lookup tables instead of cmsDoTransform. Values falling outside of [0;1] go through the tone curves of the
+ * profiles, like lcms does, so that out of gamut colors are kept. Build it with ICCStore::createMatrixShaperTransform().
+ */
+class MatrixShaperTransform final :
+    public NonCopyable
+{
+public:
+    ~MatrixShaperTransform();
+
+    /** Converts a row from Lab in the LabImage range (L in [0;32768]) to RGB in [0;1] */
+    void labToRgb(const float* L, const float* a, const float* b, float* R, float* G, float* B, int width) const;
+    /** Converts a row of RGB in [0;1], in place */
+    void rgbToRgb(float* R, float* G, float* B, int width) const;
+
+private:
+    friend class ICCStore;
+
+    MatrixShaperTransform();
+
+    float matrix[3][3];
+    bool linearInput;
+    bool linearOutput;
+    LUTf inputCurves[3];
+    LUTf outputCurves[3];
+    cmsToneCurve* inputTRC[3];
+    cmsToneCurve* outputTRC[3];
+};
+
 class ICCStore final
 {
 public:
@@ -98,6 +133,11 @@ public:
 
     static cmsHPROFILE createFromMatrix(const double matrix[3][3], bool gamma = false, const Glib::ustring& name = Glib::ustring());
 
+    /** Returns the native equivalent of the lcms transform from iprof (or from Lab if iprof is nullptr) to oprof,
+      * or nullptr if one of the profiles isn't a plain RGB matrix-shaper, in which case lcms has to be used.
+      * Reads the profiles, so has to be called with lcmsMutex locked. */
+    static std::unique_ptr<MatrixShaperTransform> createMatrixShaperTransform(cmsHPROFILE iprof, cmsHPROFILE oprof, int intent, bool bpc);
+
 private:
     class Implementation;
 
@@ -1909,6 +1909,24 @@ public:
         bool uncompressed = false,
         bool big = false
     ) const = 0;
+#ifdef LIBJXL
+    /** @brief Saves the image to file in a JPEG XL format.
+      * @param fname is the name of the file
+      * @param bps can be 8, 16 or 32 depending on the bits per pixels the output file will have
+      * @param isFloat is true for saving float samples (always the case with 32 bits)
+      * @param lossless selects the lossless mode, otherwise the image is encoded with the given distance
+      * @param distance is the Butteraugli distance of the lossy mode, 1.0 being visually lossless
+      * @param effort is the encoding effort (1...9), higher values are slower and give smaller files
+        @return the error code, 0 if none */
+    virtual int saveAsJXL (
+        const Glib::ustring &fname,
+        int bps = -1,
+        bool isFloat = false,
+        bool lossless = true,
+        float distance = 1.f,
+        int effort = 7
+    ) const = 0;
+#endif
     /** @brief Sets the progress listener if you want to follow the progress of the image saving operations (optional).
       * @param pl is the pointer to the class implementing the ProgressListener interface */
     virtual void setSaveProgressListener (ProgressListener* pl) = 0;
@@ -86,6 +86,13 @@ public:
         return saveTIFF(fname, bps, isFloat, uncompressed);
     }
 
+#ifdef LIBJXL
+    int saveAsJXL(const Glib::ustring &fname, int bps = -1, bool isFloat = false, bool lossless = true, float distance = 1.f, int effort = 7) const override
+    {
+        return saveJXL(fname, bps, isFloat, lossless, distance, effort);
+    }
+#endif
+
     void setSaveProgressListener(ProgressListener* pl) override
     {
         setProgressListener(pl);
@@ -494,3 +494,26 @@ void Imagefloat::ExecCMSTransform(cmsHTRANSFORM hTransform, const LabImage &labI
         } // End of parallelization
     }
 }
+
+// Native version for matrix-shaper profiles, see ICCStore::createMatrixShaperTransform
+void Imagefloat::ExecCMSTransform(const MatrixShaperTransform &transform)
+{
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 16)
+#endif
+
+    for (int y = 0; y < height; y++) {
+        transform.rgbToRgb(r(y), g(y), b(y), width);
+    }
+}
+
+void Imagefloat::ExecCMSTransform(const MatrixShaperTransform &transform, const LabImage &labImage, int cx, int cy)
+{
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+
+    for (int y = cy; y < cy + height; y++) {
+        transform.labToRgb(labImage.L[y] + cx, labImage.a[y] + cx, labImage.b[y] + cx, r(y - cy), g(y - cy), b(y - cy), width);
+    }
+}
@@ -30,6 +30,7 @@ using namespace procparams;
 class Image8;
 class Image16;
 class LabImage;
+class MatrixShaperTransform;
 
 /*
  * Image type used by most tools; expected range: [0.0 ; 65535.0]
@@ -92,6 +93,19 @@ public:
     {
         return saveTIFF (fname, bps, isFloat, uncompressed, big);
     }
+#ifdef LIBJXL
+    int saveAsJXL (
+        const Glib::ustring &fname,
+        int bps = -1,
+        bool isFloat = false,
+        bool lossless = true,
+        float distance = 1.f,
+        int effort = 7
+    ) const override
+    {
+        return saveJXL (fname, bps, isFloat, lossless, distance, effort);
+    }
+#endif
     void setSaveProgressListener (ProgressListener* pl) override
     {
         setProgressListener (pl);
@@ -219,6 +233,8 @@ public:
     void                 normalizeFloatTo65535(bool multithread=true);
     void                 ExecCMSTransform(cmsHTRANSFORM hTransform);
     void                 ExecCMSTransform(cmsHTRANSFORM hTransform, const LabImage &labImage, int cx, int cy);
+    void                 ExecCMSTransform(const MatrixShaperTransform &transform);
+    void                 ExecCMSTransform(const MatrixShaperTransform &transform, const LabImage &labImage, int cx, int cy);
 };
 
 }
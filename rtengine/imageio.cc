@@ -17,6 +17,7 @@
  *  You should have received a copy of the GNU General Public License
  *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -28,7 +29,9 @@
 
 #ifdef LIBJXL
 #include "jxl/decode_cxx.h"
+#include "jxl/encode_cxx.h"
 #include "jxl/resizable_parallel_runner_cxx.h"
+#include "jxl/thread_parallel_runner_cxx.h"
 #endif
 
 #include <fcntl.h>
@@ -36,6 +39,7 @@
 #include <png.h>
 #include <tiff.h>
 #include <tiffio.h>
+#include <zlib.h>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -92,6 +96,256 @@ FILE* g_fopen_withBinaryAndLock(const Glib::ustring& fname)
     return f;
 }
 
+// Applies the TIFF horizontal differencing predictor to a row of RGB samples
+template <typename T>
+void tiffHorizontalDiff(unsigned char* row, int width)
+{
+    T* const samples = reinterpret_cast<T*>(row);
+
+    for (int i = width * 3 - 1; i >= 3; --i) {
+        samples[i] -= samples[i - 3];
+    }
+}
+
+// Applies the TIFF floating point predictor to a row of RGB samples: the bytes of the samples are
+// split into planes, most significant byte first, and the planes are differenced
+void tiffFloatingPointDiff(unsigned char* row, int width, int bytesPerSample, std::vector<unsigned char>& tmp)
+{
+    const int count = width * 3;
+    tmp.assign(row, row + count * bytesPerSample);
+
+    for (int i = 0; i < count; ++i) {
+        for (int b = 0; b < bytesPerSample; ++b) {
+#if __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__
+            row[(bytesPerSample - 1 - b) * count + i] = tmp[i * bytesPerSample + b];
+#else
+            row[b * count + i] = tmp[i * bytesPerSample + b];
+#endif
+        }
+    }
+
+    for (int i = count * bytesPerSample - 1; i >= 3; --i) {
+        row[i] -= row[i - 3];
+    }
+}
+
+// TIFF flavour of LZW, as written by libtiff: codes of 9 to 12 bits packed MSB first,
+// with the code width growing one code early
+void tiffLzwEncode(const unsigned char* in, std::size_t size, std::vector<unsigned char>& out)
+{
+    constexpr int CODE_CLEAR = 256;
+    constexpr int CODE_EOI = 257;
+    constexpr int CODE_FIRST = 258;
+    constexpr int CODE_MAX = 4095;
+    constexpr std::uint32_t HASH_BITS = 13;
+
+    // keys are (prefix << 8 | byte) + 1, 0 marks a free slot
+    std::vector<std::uint32_t> keys(1 << HASH_BITS);
+    std::vector<std::uint16_t> codes(1 << HASH_BITS);
+
+    std::uint32_t bitBuffer = 0;
+    int bitCount = 0;
+    int nbits = 9;
+    int maxCode = (1 << nbits) - 1;
+    int freeEnt = CODE_FIRST;
+
+    out.clear();
+    out.reserve(size / 2 + 16);
+
+    const auto put =
+        [&](int code)
+        {
+            bitBuffer = (bitBuffer << nbits) | code;
+            bitCount += nbits;
+
+            while (bitCount >= 8) {
+                bitCount -= 8;
+                out.push_back(static_cast<unsigned char>(bitBuffer >> bitCount));
+            }
+        };
+
+    put(CODE_CLEAR);
+
+    if (size > 0) {
+        int ent = in[0];
+
+        for (std::size_t i = 1; i < size; ++i) {
+            const int c = in[i];
+            const std::uint32_t key = ((static_cast<std::uint32_t>(ent) << 8) | c) + 1;
+            std::uint32_t slot = (key * 2654435761u) >> (32 - HASH_BITS);
+
+            while (keys[slot] && keys[slot] != key) {
+                slot = (slot + 1) & ((1 << HASH_BITS) - 1);
+            }
+
+            if (keys[slot]) {
+                ent = codes[slot];
+                continue;
+            }
+
+            put(ent);
+            keys[slot] = key;
+            codes[slot] = freeEnt++;
+            ent = c;
+
+            if (freeEnt == CODE_MAX - 1) {
+                // table is full, emit clear code and reset
+                put(CODE_CLEAR);
+                std::fill(keys.begin(), keys.end(), 0);
+                freeEnt = CODE_FIRST;
+                nbits = 9;
+                maxCode = (1 << nbits) - 1;
+            } else if (freeEnt > maxCode) {
+                ++nbits;
+                maxCode = (1 << nbits) - 1;
+            }
+        }
+
+        // the decoder adds an entry for the last code too, the EOI code has to be written with its code width
+        put(ent);
+
+        if (++freeEnt == CODE_MAX - 1) {
+            put(CODE_CLEAR);
+            nbits = 9;
+        } else if (freeEnt > maxCode) {
+            ++nbits;
+        }
+    }
+
+    put(CODE_EOI);
+
+    if (bitCount > 0) {
+        out.push_back(static_cast<unsigned char>(bitBuffer << (8 - bitCount)));
+    }
+}
+
+// Compresses one strip of a TIFF file
+bool tiffCompressStrip(uint16_t compression, const unsigned char* in, std::size_t size, std::vector<unsigned char>& out)
+{
+    if (compression == COMPRESSION_LZW) {
+        tiffLzwEncode(in, size, out);
+        return true;
+    }
+
+    uLongf outSize = compressBound(size);
+    out.resize(outSize);
+
+    if (compress2(out.data(), &outSize, in, size, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return false;
+    }
+
+    out.resize(outSize);
+    return true;
+}
+
+// Applies a PNG filter to a row, out receives the filter type byte followed by the filtered row.
+// prev is the unfiltered previous row, nullptr for the first row of the image.
+void pngFilterRow(int filter, const unsigned char* row, const unsigned char* prev, int rowlen, int bpp, unsigned char* out)
+{
+    out[0] = filter;
+    ++out;
+
+    if (!prev && (filter == PNG_FILTER_VALUE_UP || filter == PNG_FILTER_VALUE_PAETH)) {
+        // with a zero previous row, Up is None and Paeth is Sub
+        filter = filter == PNG_FILTER_VALUE_UP ? PNG_FILTER_VALUE_NONE : PNG_FILTER_VALUE_SUB;
+    }
+
+    switch (filter) {
+        case PNG_FILTER_VALUE_SUB:
+            std::copy(row, row + bpp, out);
+
+            for (int i = bpp; i < rowlen; ++i) {
+                out[i] = row[i] - row[i - bpp];
+            }
+
+            break;
+
+        case PNG_FILTER_VALUE_UP:
+            for (int i = 0; i < rowlen; ++i) {
+                out[i] = row[i] - prev[i];
+            }
+
+            break;
+
+        case PNG_FILTER_VALUE_AVG:
+            for (int i = 0; i < rowlen; ++i) {
+                const int a = i >= bpp ? row[i - bpp] : 0;
+                const int b = prev ? prev[i] : 0;
+                out[i] = row[i] - (a + b) / 2;
+            }
+
+            break;
+
+        case PNG_FILTER_VALUE_PAETH:
+            for (int i = 0; i < bpp; ++i) {
+                out[i] = row[i] - prev[i];
+            }
+
+            for (int i = bpp; i < rowlen; ++i) {
+                const int a = row[i - bpp];
+                const int b = prev[i];
+                const int c = prev[i - bpp];
+                const int pa = std::abs(b - c);
+                const int pb = std::abs(a - c);
+                const int pc = std::abs(a + b - 2 * c);
+                out[i] = row[i] - (pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+            }
+
+            break;
+
+        default:
+            std::copy(row, row + rowlen, out);
+    }
+}
+
+// Picks the filter of each row with the usual heuristic: the smallest sum of the filtered bytes, taken as signed
+void pngFilterRowAdaptive(const unsigned char* row, const unsigned char* prev, int rowlen, int bpp, unsigned char* out, std::vector<unsigned char>& tmp)
+{
+    tmp.resize(rowlen + 1);
+    unsigned long bestSum = ~0UL;
+
+    for (int filter = PNG_FILTER_VALUE_NONE; filter < PNG_FILTER_VALUE_LAST; ++filter) {
+        pngFilterRow(filter, row, prev, rowlen, bpp, tmp.data());
+        unsigned long sum = 0;
+
+        for (int i = 1; i <= rowlen; ++i) {
+            sum += std::abs(static_cast<signed char>(tmp[i]));
+        }
+
+        if (sum < bestSum) {
+            bestSum = sum;
+            std::copy(tmp.begin(), tmp.end(), out);
+        }
+    }
+}
+
+bool pngWriteChunk(FILE* file, const char* type, const unsigned char* data, std::size_t size)
+{
+    const unsigned char length[4] = {
+        static_cast<unsigned char>(size >> 24),
+        static_cast<unsigned char>(size >> 16),
+        static_cast<unsigned char>(size >> 8),
+        static_cast<unsigned char>(size)
+    };
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(type), 4);
+
+    if (size) {
+        crc = crc32(crc, data, size);
+    }
+
+    const unsigned char crcBytes[4] = {
+        static_cast<unsigned char>(crc >> 24),
+        static_cast<unsigned char>(crc >> 16),
+        static_cast<unsigned char>(crc >> 8),
+        static_cast<unsigned char>(crc)
+    };
+
+    return fwrite(length, 1, 4, file) == 4
+           && fwrite(type, 1, 4, file) == 4
+           && (!size || fwrite(data, 1, size, file) == size)
+           && fwrite(crcBytes, 1, 4, file) == 4;
+}
+
 template <typename Iterator, typename Integer = std::size_t>
 auto to_long(const Iterator &iter, Integer n = Integer{0}) -> decltype(
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -1066,10 +1320,6 @@ int ImageIO::savePNG  (const Glib::ustring &fname, volatile int bps) const
 
     png_set_write_fn (png, file, png_write_data, png_flush);
 
-    png_set_filter(png, 0, PNG_FILTER_PAETH);
-    png_set_compression_level(png, 6);
-    png_set_compression_strategy(png, 3);
-
     int width = getWidth ();
     int height = getHeight ();
 
@@ -1092,38 +1342,162 @@ int ImageIO::savePNG  (const Glib::ustring &fname, volatile int bps) const
         png_set_iCCP(png, info, "icc", 0, profdata, profileData.size());
     }
 
-    int rowlen = width * 3 * bps / 8;
-    unsigned char *row = new unsigned char [rowlen];
-
     png_write_info(png, info);
+    png_write_flush(png);
+    png_destroy_write_struct(&png, &info);
 
-    for (int i = 0; i < height; i++) {
-        getScanline (i, row, bps);
+    // libpng only writes the header chunks. The image data is filtered and deflated by groups of rows
+    // concurrently, each group ending on a flush boundary, and the groups are written in order as the
+    // IDAT chunks of a single zlib stream.
+    const int rowlen = width * 3 * bps / 8;
+    const int bpp = 3 * bps / 8;
+    const int rowsPerGroup = rtengine::LIM((1 << 19) / (rowlen + 1), 1, height);
+    const int groups = (height + rowsPerGroup - 1) / rowsPerGroup;
+    const int filter = rtengine::LIM(settings->pngFilter, 0, PNG_FILTER_VALUE_LAST);
+    const int level = rtengine::LIM(settings->pngCompression, 0, 9);
+    const int strategy = rtengine::LIM(settings->pngStrategy, static_cast<int>(Z_DEFAULT_STRATEGY), static_cast<int>(Z_RLE));
+
+    // With the strategies searching for matches, each group is primed with the last 32 KiB of filtered
+    // data of the previous one, as a single stream would be. The threads filter these rows again.
+    constexpr int windowSize = 1 << 15;
+    const int dictRows = level > 0 && (strategy == Z_DEFAULT_STRATEGY || strategy == Z_FILTERED) ? (windowSize + rowlen) / (rowlen + 1) : 0;
+
+    // zlib stream header, see RFC 1950
+    const int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    const unsigned char cmf = 0x78;
+    const unsigned char flg = (flevel << 6) + 31 - ((cmf * 256 + (flevel << 6)) % 31);
+
+    uLong adler = adler32(0L, Z_NULL, 0);
+    bool writeOk = true;
 
-        if (bps == 16) {
-            // convert to network byte order
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        std::vector<unsigned char> prev(rowlen);
+        std::vector<unsigned char> cur(rowlen);
+        std::vector<unsigned char> filtered(static_cast<std::size_t>(rowsPerGroup + dictRows) * (rowlen + 1));
+        std::vector<unsigned char> compressed;
+        std::vector<unsigned char> tmp;
+
+        const auto getRow =
+            [&](int y, unsigned char* row)
+            {
+                getScanline (y, row, bps);
+
+                if (bps == 16) {
+                    // convert to network byte order
 #if __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__
-            for (int j = 0; j < width * 6; j += 2) {
-                unsigned char tmp = row[j];
-                row[j] = row[j + 1];
-                row[j + 1] = tmp;
+                    for (int j = 0; j < rowlen; j += 2) {
+                        std::swap(row[j], row[j + 1]);
+                    }
+#endif
+                }
+            };
+
+        z_stream strm = {};
+        // raw deflate, the zlib header and trailer are written separately
+        const bool initOk = deflateInit2(&strm, level, Z_DEFLATED, -15, 8, strategy) == Z_OK;
+
+#ifdef _OPENMP
+        #pragma omp for ordered schedule(dynamic)
+#endif
+        for (int group = 0; group < groups; ++group) {
+            const int firstRow = group * rowsPerGroup;
+            const int rows = std::min(rowsPerGroup, height - firstRow);
+            const bool last = group == groups - 1;
+            const int groupDictRows = std::min(dictRows, firstRow);
+            const int startRow = firstRow - groupDictRows;
+
+            if (startRow > 0) {
+                getRow (startRow - 1, prev.data());
             }
 
+            for (int i = 0; i < groupDictRows + rows; ++i) {
+                const unsigned char* const prevRow = startRow + i > 0 ? prev.data() : nullptr;
+                unsigned char* const out = filtered.data() + static_cast<std::size_t>(i) * (rowlen + 1);
+                getRow (startRow + i, cur.data());
+
+                if (filter == PNG_FILTER_VALUE_LAST) {
+                    pngFilterRowAdaptive(cur.data(), prevRow, rowlen, bpp, out, tmp);
+                } else {
+                    pngFilterRow(filter, cur.data(), prevRow, rowlen, bpp, out);
+                }
+
+                prev.swap(cur);
+            }
+
+            const std::size_t dictSize = std::min<std::size_t>(static_cast<std::size_t>(groupDictRows) * (rowlen + 1), windowSize);
+            unsigned char* const groupData = filtered.data() + static_cast<std::size_t>(groupDictRows) * (rowlen + 1);
+            const std::size_t size = static_cast<std::size_t>(rows) * (rowlen + 1);
+            const uLong groupAdler = adler32(adler32(0L, Z_NULL, 0), groupData, size);
+            bool compressOk = initOk && deflateReset(&strm) == Z_OK;
+
+            if (compressOk && dictSize > 0) {
+                compressOk = deflateSetDictionary(&strm, groupData - dictSize, dictSize) == Z_OK;
+            }
+
+            if (compressOk) {
+                compressed.resize(deflateBound(&strm, size) + 16);
+                strm.next_in = groupData;
+                strm.avail_in = size;
+                strm.next_out = compressed.data();
+                strm.avail_out = compressed.size();
+
+                // the last group ends the deflate stream, the others end on a byte boundary so that they can be concatenated
+                const int ret = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+                compressOk = (last ? ret == Z_STREAM_END : ret == Z_OK && strm.avail_out > 0) && strm.avail_in == 0;
+                compressed.resize(strm.total_out);
+            }
+
+#ifdef _OPENMP
+            #pragma omp ordered
 #endif
-        }
+            {
+                if (writeOk && compressOk) {
+                    adler = adler32_combine(adler, groupAdler, size);
+
+                    if (group == 0) {
+                        compressed.insert(compressed.begin(), {cmf, flg});
+                    }
+
+                    if (last) {
+                        compressed.insert(compressed.end(), {
+                            static_cast<unsigned char>(adler >> 24),
+                            static_cast<unsigned char>(adler >> 16),
+                            static_cast<unsigned char>(adler >> 8),
+                            static_cast<unsigned char>(adler)
+                        });
+                    }
+
+                    writeOk = pngWriteChunk(file, "IDAT", compressed.data(), compressed.size());
+                } else {
+                    writeOk = false;
+                }
 
-        png_write_row (png, (png_byte*)row);
+                if (pl) {
+                    pl->setProgress ((double)(firstRow + rows) / height);
+                }
+            }
+        }
 
-        if (pl && !(i % 100)) {
-            pl->setProgress ((double)(i + 1) / height);
+        if (initOk) {
+            deflateEnd(&strm);
         }
     }
 
-    png_write_end(png, info);
-    png_destroy_write_struct(&png, &info);
+    if (writeOk) {
+        writeOk = pngWriteChunk(file, "IEND", nullptr, 0);
+    }
 
-    delete [] row;
-    fclose (file);
+    if (fclose (file) != 0) {
+        writeOk = false;
+    }
+
+    if (!writeOk) {
+        g_remove(fname.c_str());
+        return IMIO_CANNOTWRITEFILE;
+    }
 
     if (!saveMetadata(fname)) {
         g_remove(fname.c_str());
@@ -1314,8 +1688,18 @@ int ImageIO::saveTIFF (
         bps = getBPS ();
     }
 
-    int lineWidth = width * 3 * (bps / 8);
-    std::vector<unsigned char> linebuffer(lineWidth);
+    const int lineWidth = width * 3 * (bps / 8);
+    // Strips of about 1 MiB, so that they can be compressed and later decoded concurrently
+    const int rowsPerStrip = rtengine::LIM((1 << 20) / lineWidth, 1, height);
+    const int strips = (height + rowsPerStrip - 1) / rowsPerStrip;
+    const uint16_t compression =
+        uncompressed ? COMPRESSION_NONE
+        : settings->tiffCompression == 1 ? COMPRESSION_LZW
+        : COMPRESSION_ADOBE_DEFLATE;
+    const uint16_t predictor =
+        uncompressed || !settings->tiffPredictor ? PREDICTOR_NONE
+        : (bps == 16 || bps == 32) && isFloat ? PREDICTOR_FLOATINGPOINT
+        : PREDICTOR_HORIZONTAL;
 
     std::string mode = "w";
 
@@ -1342,18 +1726,16 @@ int ImageIO::saveTIFF (
         pl->setProgress (0.0);
     }
 
-    bool needsReverse = false;
-
     TIFFSetField (out, TIFFTAG_SOFTWARE, "RawTherapee " RTVERSION);
     TIFFSetField (out, TIFFTAG_IMAGEWIDTH, width);
     TIFFSetField (out, TIFFTAG_IMAGELENGTH, height);
     TIFFSetField (out, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
     TIFFSetField (out, TIFFTAG_SAMPLESPERPIXEL, 3);
-    TIFFSetField (out, TIFFTAG_ROWSPERSTRIP, height);
+    TIFFSetField (out, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
     TIFFSetField (out, TIFFTAG_BITSPERSAMPLE, bps);
     TIFFSetField (out, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
     TIFFSetField (out, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-    TIFFSetField (out, TIFFTAG_COMPRESSION, uncompressed ? COMPRESSION_NONE : COMPRESSION_ADOBE_DEFLATE);
+    TIFFSetField (out, TIFFTAG_COMPRESSION, compression);
     TIFFSetField (out, TIFFTAG_SAMPLEFORMAT, (bps == 16 || bps == 32) && isFloat ? SAMPLEFORMAT_IEEEFP : SAMPLEFORMAT_UINT);
 
     // somehow Exiv2 (tested with 0.27.3) doesn't seem to be able to update
@@ -1381,38 +1763,63 @@ int ImageIO::saveTIFF (
     TIFFSetField(out, TIFFTAG_YRESOLUTION, y_res);
     TIFFSetField(out, TIFFTAG_RESOLUTIONUNIT, res_unit);
 
-    if (!uncompressed) {
-        TIFFSetField (out, TIFFTAG_PREDICTOR, (bps == 16 || bps == 32) && isFloat ? PREDICTOR_FLOATINGPOINT : PREDICTOR_HORIZONTAL);
+    if (predictor != PREDICTOR_NONE) {
+        TIFFSetField (out, TIFFTAG_PREDICTOR, predictor);
     }
     if (!profileData.empty()) {
         TIFFSetField (out, TIFFTAG_ICCPROFILE, profileData.size(), profileData.data());
     }
 
-    for (int row = 0; row < height; row++) {
-        getScanline (row, linebuffer.data(), bps, isFloat);
+    // The strips are prepared and compressed by the threads of the team, then written in order by TIFFWriteRawStrip
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        std::vector<unsigned char> stripBuffer(static_cast<std::size_t>(rowsPerStrip) * lineWidth);
+        std::vector<unsigned char> compressed;
+        std::vector<unsigned char> tmp;
 
-        if (bps == 16) {
-            if(needsReverse && !uncompressed && isFloat) {
-                for(int i = 0; i < lineWidth; i += 2) {
-                    std::swap(linebuffer[i], linebuffer[i + 1]);
-                }
-            }
-        } else if (bps == 32) {
-            if(needsReverse && !uncompressed) {
-                for(int i = 0; i < lineWidth; i += 4) {
-                    std::swap(linebuffer[i], linebuffer[i + 3]);
-                    std::swap(linebuffer[i + 1], linebuffer[i + 2]);
+#ifdef _OPENMP
+        #pragma omp for ordered schedule(dynamic)
+#endif
+        for (int strip = 0; strip < strips; ++strip) {
+            const int firstRow = strip * rowsPerStrip;
+            const int rows = std::min(rowsPerStrip, height - firstRow);
+
+            for (int i = 0; i < rows; ++i) {
+                unsigned char* const row = stripBuffer.data() + static_cast<std::size_t>(i) * lineWidth;
+                getScanline (firstRow + i, row, bps, isFloat);
+
+                if (predictor == PREDICTOR_FLOATINGPOINT) {
+                    tiffFloatingPointDiff(row, width, bps / 8, tmp);
+                } else if (predictor == PREDICTOR_HORIZONTAL) {
+                    if (bps == 8) {
+                        tiffHorizontalDiff<uint8_t>(row, width);
+                    } else if (bps == 16) {
+                        tiffHorizontalDiff<uint16_t>(row, width);
+                    } else {
+                        tiffHorizontalDiff<uint32_t>(row, width);
+                    }
                 }
             }
-        }
 
-        if (TIFFWriteScanline (out, linebuffer.data(), row, 0) < 0) {
-            TIFFClose (out);
-            return IMIO_CANNOTWRITEFILE;
-        }
+            const std::size_t stripSize = static_cast<std::size_t>(rows) * lineWidth;
+            const bool compressOk = compression == COMPRESSION_NONE || tiffCompressStrip(compression, stripBuffer.data(), stripSize, compressed);
+            const std::vector<unsigned char>& data = compression == COMPRESSION_NONE ? stripBuffer : compressed;
+            const std::size_t dataSize = compression == COMPRESSION_NONE ? stripSize : compressed.size();
 
-        if (pl && !(row % 100)) {
-            pl->setProgress ((double)(row + 1) / height);
+#ifdef _OPENMP
+            #pragma omp ordered
+#endif
+            {
+                if (writeOk && (!compressOk || TIFFWriteRawStrip (out, strip, const_cast<unsigned char*>(data.data()), dataSize) < 0)) {
+                    writeOk = false;
+                }
+
+                if (pl) {
+                    pl->setProgress ((double)(firstRow + rows) / height);
+                }
+            }
         }
     }
 
@@ -1425,7 +1832,7 @@ int ImageIO::saveTIFF (
     fclose (file);
 #endif
 
-    if (!saveMetadata(fname)) {
+    if (writeOk && !saveMetadata(fname)) {
         writeOk = false;
     }
 
@@ -1442,6 +1849,180 @@ int ImageIO::saveTIFF (
     }
 }
 
+#ifdef LIBJXL
+int ImageIO::saveJXL (const Glib::ustring &fname, int bps, bool isFloat, bool lossless, float distance, int effort) const
+{
+    if (getWidth() < 1 || getHeight() < 1) {
+        return IMIO_HEADERERROR;
+    }
+
+    const int width = getWidth ();
+    const int height = getHeight ();
+
+    if (bps < 0) {
+        bps = getBPS ();
+    }
+
+    if (bps == 32) {
+        isFloat = true;
+    } else if (bps != 16) {
+        bps = 8;
+        isFloat = false;
+    }
+
+    if (pl) {
+        pl->setProgressStr ("PROGRESSBAR_SAVEJXL");
+        pl->setProgress (0.0);
+    }
+
+    const std::size_t lineWidth = static_cast<std::size_t>(width) * 3 * (bps / 8);
+    std::vector<unsigned char> pixels(lineWidth * height);
+
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int row = 0; row < height; ++row) {
+        getScanline (row, pixels.data() + row * lineWidth, bps, isFloat);
+    }
+
+    auto enc = JxlEncoderMake(nullptr);
+    auto runner = JxlThreadParallelRunnerMake(nullptr, JxlThreadParallelRunnerDefaultNumWorkerThreads());
+
+    if (JXL_ENC_SUCCESS != JxlEncoderSetParallelRunner(enc.get(), JxlThreadParallelRunner, runner.get())) {
+        std::cerr << "Error: JxlEncoderSetParallelRunner failed" << std::endl;
+        return IMIO_CANNOTWRITEFILE;
+    }
+
+    const JxlPixelFormat format = {
+        3,
+        bps == 8 ? JXL_TYPE_UINT8 : bps == 32 ? JXL_TYPE_FLOAT : isFloat ? JXL_TYPE_FLOAT16 : JXL_TYPE_UINT16,
+        JXL_NATIVE_ENDIAN,
+        0
+    };
+
+    JxlBasicInfo info;
+    JxlEncoderInitBasicInfo(&info);
+    info.xsize = width;
+    info.ysize = height;
+    info.bits_per_sample = bps;
+    info.exponent_bits_per_sample = isFloat ? (bps == 16 ? 5 : 8) : 0;
+    // lossless coding has to keep the samples in the output profile instead of converting them to XYB
+    info.uses_original_profile = lossless ? JXL_TRUE : JXL_FALSE;
+
+    if (JXL_ENC_SUCCESS != JxlEncoderSetBasicInfo(enc.get(), &info)) {
+        std::cerr << "Error: JxlEncoderSetBasicInfo failed" << std::endl;
+        return IMIO_CANNOTWRITEFILE;
+    }
+
+    if (!profileData.empty()) {
+        if (JXL_ENC_SUCCESS != JxlEncoderSetICCProfile(enc.get(), reinterpret_cast<const std::uint8_t*>(profileData.data()), profileData.size())) {
+            std::cerr << "Error: JxlEncoderSetICCProfile failed" << std::endl;
+            return IMIO_CANNOTWRITEFILE;
+        }
+    } else {
+        JxlColorEncoding colorEncoding = {};
+        JxlColorEncodingSetToSRGB(&colorEncoding, JXL_FALSE);
+
+        if (JXL_ENC_SUCCESS != JxlEncoderSetColorEncoding(enc.get(), &colorEncoding)) {
+            std::cerr << "Error: JxlEncoderSetColorEncoding failed" << std::endl;
+            return IMIO_CANNOTWRITEFILE;
+        }
+    }
+
+    // Exiv2 can't write the metadata of JPEG XL files, the Exif data goes into a box of the container instead
+    if (!metadataInfo.filename().empty()) {
+        try {
+            metadataInfo.load();
+            Exiv2::ExifData exif = metadataInfo.getOutputExifData();
+            exif["Exif.Image.Software"] = "RawTherapee " RTVERSION;
+            Exiv2::Blob blob;
+            Exiv2::ExifParser::encode(blob, Exiv2::littleEndian, exif);
+
+            if (!blob.empty()) {
+                // the box starts with the offset of the TIFF header
+                std::vector<std::uint8_t> box(4, 0);
+                box.insert(box.end(), blob.begin(), blob.end());
+
+                if (JXL_ENC_SUCCESS != JxlEncoderUseBoxes(enc.get())
+                    || JXL_ENC_SUCCESS != JxlEncoderAddBox(enc.get(), "Exif", box.data(), box.size(), JXL_FALSE)) {
+                    std::cerr << "Warning: JxlEncoderAddBox failed" << std::endl;
+                }
+            }
+        } catch (const std::exception& exc) {
+            if (settings->verbose) {
+                std::cout << "EXIF LOAD ERROR: " << exc.what() << std::endl;
+            }
+        }
+    }
+
+    JxlEncoderFrameSettings* const frameSettings = JxlEncoderFrameSettingsCreate(enc.get(), nullptr);
+    JxlEncoderFrameSettingsSetOption(frameSettings, JXL_ENC_FRAME_SETTING_EFFORT, rtengine::LIM(effort, 1, 9));
+
+    if (lossless) {
+        JxlEncoderSetFrameLossless(frameSettings, JXL_TRUE);
+    } else {
+        JxlEncoderSetFrameDistance(frameSettings, rtengine::LIM(distance, 0.1f, 25.f));
+    }
+
+    if (JXL_ENC_SUCCESS != JxlEncoderAddImageFrame(frameSettings, &format, pixels.data(), pixels.size())) {
+        std::cerr << "Error: JxlEncoderAddImageFrame failed" << std::endl;
+        return IMIO_CANNOTWRITEFILE;
+    }
+
+    // the encoder has its own copy of the pixels
+    std::vector<unsigned char>().swap(pixels);
+    JxlEncoderCloseInput(enc.get());
+
+    if (pl) {
+        pl->setProgress (0.5);
+    }
+
+    FILE* const file = g_fopen_withBinaryAndLock (fname);
+
+    if (!file) {
+        return IMIO_CANNOTWRITEFILE;
+    }
+
+    // the codestream is written as it is produced
+    std::vector<std::uint8_t> buffer(1 << 20);
+    bool writeOk = true;
+    JxlEncoderStatus status = JXL_ENC_NEED_MORE_OUTPUT;
+
+    while (status == JXL_ENC_NEED_MORE_OUTPUT) {
+        std::uint8_t* next = buffer.data();
+        std::size_t avail = buffer.size();
+        status = JxlEncoderProcessOutput(enc.get(), &next, &avail);
+        const std::size_t size = next - buffer.data();
+
+        if (size && fwrite(buffer.data(), 1, size, file) != size) {
+            writeOk = false;
+            break;
+        }
+    }
+
+    if (status != JXL_ENC_SUCCESS) {
+        std::cerr << "Error: JxlEncoderProcessOutput failed" << std::endl;
+        writeOk = false;
+    }
+
+    if (fclose (file) != 0) {
+        writeOk = false;
+    }
+
+    if (pl) {
+        pl->setProgressStr ("PROGRESSBAR_READY");
+        pl->setProgress (1.0);
+    }
+
+    if (writeOk) {
+        return IMIO_SUCCESS;
+    } else {
+        g_remove (fname.c_str());
+        return IMIO_CANNOTWRITEFILE;
+    }
+}
+#endif // LIBJXL
+
 // PNG read and write routines:
 
 void png_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
@@ -1505,6 +2086,10 @@ int ImageIO::save (const Glib::ustring &fname) const
         return saveJPEG (fname);
     } else if (hasTiffExtension(fname)) {
         return saveTIFF (fname);
+#ifdef LIBJXL
+    } else if (hasJxlExtension(fname)) {
+        return saveJXL (fname);
+#endif
     } else {
         return IMIO_FILETYPENOTSUPPORTED;
     }
@@ -112,6 +112,9 @@ public:
         bool uncompressed = false,
         bool big = false
     ) const;
+#ifdef LIBJXL
+    int saveJXL (const Glib::ustring &fname, int bps = -1, bool isFloat = false, bool lossless = true, float distance = 1.f, int effort = 7) const;
+#endif
 
     cmsHPROFILE getEmbeddedProfile () const;
     void getEmbeddedProfileData (int& length, unsigned char*& pdata) const;
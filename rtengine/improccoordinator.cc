@@ -36,6 +36,7 @@
 #include "metadata.h"
 #include "labimage.h"
 #include "lcp.h"
+#include "pipelinetrace.h"
 #include "procparams.h"
 #include "tweakoperator.h"
 #include "refreshmap.h"
@@ -76,6 +77,11 @@ ImProcCoordinator::ImProcCoordinator() :
     gamutCheck(false),
     sharpMask(false),
     sharpMaskChanged(false),
+    spotsOnlyChange(false),
+    spotsChangedX1(0),
+    spotsChangedY1(0),
+    spotsChangedX2(0),
+    spotsChangedY2(0),
     scale(10),
     highDetailPreprocessComputed(false),
     highDetailRawComputed(false),
@@ -246,6 +252,7 @@ ImProcCoordinator::ImProcCoordinator() :
     locallcieMask(0),
     retistrsav(nullptr)
 {
+    ipf.setCancellationToken(&renderCancellation);
 }
 
 ImProcCoordinator::~ImProcCoordinator()
@@ -336,6 +343,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
 {
     // TODO Locallab printf
     MyMutex::MyLock processingLock(mProcessing);
+    PipelineTrace::Scope trace("preview", "updatePreviewImage");
 
     bool highDetailNeeded = options.prevdemo == PD_Sidecar ? true : (todo & M_HIGHQUAL);
     //    printf("metwb=%s \n", params->wb.method.c_str());
@@ -389,6 +397,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         float bluedeha = 0.f;
 
         if ((todo & M_PREPROC) || (!highDetailPreprocessComputed && highDetailNeeded)) {
+            PipelineTrace::Scope stageTrace("preview", "preprocess");
             imgsrc->setCurrentFrame(params->raw.bayersensor.imageNum);
             imgsrc->preprocess(rp, params->lensProf, params->coarse, reddeha, greendeha, bluedeha, true);
             if(imgsrc->getSensorType() == ST_BAYER) {//Bayer
@@ -463,7 +472,10 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
 
             bool autoContrast = imgsrc->getSensorType() == ST_BAYER ? params->raw.bayersensor.dualDemosaicAutoContrast : params->raw.xtranssensor.dualDemosaicAutoContrast;
             double contrastThreshold = imgsrc->getSensorType() == ST_BAYER ? params->raw.bayersensor.dualDemosaicContrast : params->raw.xtranssensor.dualDemosaicContrast;
-            imgsrc->demosaic(rp, autoContrast, contrastThreshold, params->pdsharpening.enabled);
+            {
+                PipelineTrace::Scope stageTrace("preview", "demosaic");
+                imgsrc->demosaic(rp, autoContrast, contrastThreshold, params->pdsharpening.enabled);
+            }
 
             if (imgsrc->getSensorType() == ST_BAYER && bayerAutoContrastListener && autoContrast) {
                 bayerAutoContrastListener->autoContrastChanged(contrastThreshold);
@@ -478,6 +490,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
         if ((todo & (M_RAW | M_CSHARP)) && params->pdsharpening.enabled) {
+            PipelineTrace::Scope stageTrace("preview", "captureSharpening");
             double pdSharpencontrastThreshold = params->pdsharpening.contrast;
             double pdSharpenRadius = params->pdsharpening.deconvradius;
             imgsrc->captureSharpening(params->pdsharpening, sharpMask, pdSharpencontrastThreshold, pdSharpenRadius);
@@ -519,6 +532,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
         if ((todo & (M_RETINEX | M_INIT)) && params->retinex.enabled) {
+            PipelineTrace::Scope stageTrace("preview", "retinex");
             bool dehacontlutili = false;
             bool mapcontlutili = false;
             bool useHsl = false;
@@ -542,6 +556,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
 
         if (todo & (M_INIT | M_LINDENOISE | M_HDR)) {
             MyMutex::MyLock initLock(minit);  // Also used in crop window
+            PipelineTrace::Scope stageTrace("preview", "getImage");
             //imgsrc->HLRecovery_Global(params->toneCurve);   // this handles Color HLRecovery
 
 
@@ -840,6 +855,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             }
 
             ipf.firstAnalysis(orig_prev, *params, vhist16);
+            stageTrace.setSize(pW, pH);
         }
   
         oprevi = orig_prev;
@@ -863,6 +879,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
         if ((todo & M_HDR) && (params->fattal.enabled || params->dehaze.enabled)) {
+            PipelineTrace::Scope stageTrace("preview", "dehaze/fattal", pW, pH);
             if (fattal_11_dcrop_cache) {
                 delete fattal_11_dcrop_cache;
                 fattal_11_dcrop_cache = nullptr;
@@ -883,6 +900,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
       //  if ((needstransform || ((todo & (M_TRANSFORM | M_RGBCURVE))  && params->dirpyrequalizer.cbdlMethod == "bef" && params->dirpyrequalizer.enabled && !params->colorappearance.enabled))) {
         if ((needstransform || ((todo & (M_TRANSFORM | M_RGBCURVE))  && params->dirpyrequalizer.cbdlMethod == "bef" && params->dirpyrequalizer.enabled && !cam02))) {
             // Forking the image
+            PipelineTrace::Scope stageTrace("preview", "geometry", pW, pH);
             assert(oprevi);
             Imagefloat *op = oprevi;
             oprevi = new Imagefloat(pW, pH);
@@ -1110,6 +1128,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
 
 
         if ((todo & (M_AUTOEXP | M_RGBCURVE | M_CROP)) && params->locallab.enabled && !params->locallab.spots.empty()) {
+            PipelineTrace::Scope stageTrace("preview", "locallab", pW, pH);
 
             ipf.rgb2lab(*oprevi, *oprevl, params->icm.workingProfile);
 
@@ -1669,6 +1688,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
 
         if ((todo & M_RGBCURVE) || (todo & M_CROP)) {
+            PipelineTrace::Scope stageTrace("preview", "rgbProc", pW, pH);
             //complexCurve also calculated pre-curves histogram depending on crop
             CurveFactory::complexCurve(params->toneCurve.expcomp, params->toneCurve.black / 65535.0,
                                        params->toneCurve.hlcompr, params->toneCurve.hlcomprthresh,
@@ -1829,6 +1849,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         //scale = 1;
 
         if ((todo & (M_LUMINANCE + M_COLOR)) || (todo & M_AUTOEXP)) {
+            PipelineTrace::Scope stageTrace("preview", "labAdjustments", pW, pH);
             nprevl->CopyFrom(oprevl);
             histCCurve.clear();
             histLCurve.clear();
@@ -1863,6 +1884,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             wavcontlutili = CurveFactory::diagonalCurve2Lut(params->wavelet.wavclCurve, wavclCurve, scale == 1 ? 1 : 16);
 
             if ((params->wavelet.enabled)) {
+                PipelineTrace::Scope waveletTrace("preview", "wavelet", pW, pH);
                 WaveletParams WaveParams = params->wavelet;
                 WaveParams.getCurves(wavCLVCurve, wavdenoise, wavdenoiseh, wavblcurve, waOpacityCurveRG, waOpacityCurveSH, waOpacityCurveBY, waOpacityCurveW, waOpacityCurveWL);
                 int kall = 0;
@@ -2269,6 +2291,7 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
             }
 
             if (params->colorappearance.enabled) {
+                PipelineTrace::Scope ciecamTrace("preview", "ciecam", pW, pH);
                 // L histo  and Chroma histo for ciecam
                 // histogram will be for Lab (Lch) values, because very difficult to do with J,Q, M, s, C
                 int x1, y1, x2, y2;
@@ -2432,17 +2455,24 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
     }
 
-// process crop, if needed
-    for (size_t i = 0; i < crops.size(); i++)
-        if (crops[i]->hasListener() && (panningRelatedChange || (highDetailNeeded && options.prevdemo != PD_Sidecar) || (todo & (M_MONITOR | M_RGBCURVE | M_LUMACURVE)) || crops[i]->get_skip() == 1)) {
-            crops[i]->update(todo);     // may call ourselves
+    trace.setSize(pW, pH);
+
+    if (ipf.isCancelled()) {
+        // Newer params are waiting: process() redoes this update, crops and display included
+        if (orig_prev != oprevi) {
+            delete oprevi;
+            oprevi = nullptr;
         }
 
+        return;
+    }
+
     if (panningRelatedChange || (todo & M_MONITOR)) {
         if ((todo != CROP && todo != MINUPDATE) || (todo & M_MONITOR)) {
             MyMutex::MyLock prevImgLock(previmg->getMutex());
 
             try {
+                PipelineTrace::Scope stageTrace("preview", "lab2monitorRgb", pW, pH);
                 // Computing the preview image, i.e. converting from WCS->Monitor color space (soft-proofing disabled) or WCS->Printer profile->Monitor color space (soft-proofing enabled)
                 ipf.lab2monitorRgb(nprevl, previmg);
 
@@ -2493,6 +2523,22 @@ void ImProcCoordinator::updatePreviewImage(int todo, bool panningRelatedChange)
         }
     }
 
+    // The crops only depend on the spots around them, unless a tool computes its settings from the whole preview
+    const bool skipUnchangedCrops =
+        spotsOnlyChange && !(todo & M_MONITOR)
+        && !params->toneCurve.autoexp && !params->toneCurve.histmatching
+        && !(params->blackwhite.enabled && params->blackwhite.autoc)
+        && !(params->colorToning.enabled && params->colorToning.autosat)
+        && !params->colorappearance.enabled && !params->locallab.enabled && !params->fattal.enabled;
+
+// process crop, if needed, once the preview is shown: the detail crops take longer
+    for (size_t i = 0; i < crops.size(); i++)
+        if (crops[i]->hasListener() && (panningRelatedChange || (highDetailNeeded && options.prevdemo != PD_Sidecar) || (todo & (M_MONITOR | M_RGBCURVE | M_LUMACURVE)) || crops[i]->get_skip() == 1)
+            && !(skipUnchangedCrops && !crops[i]->sourceIntersects(spotsChangedX1, spotsChangedY1, spotsChangedX2, spotsChangedY2))) {
+            PipelineTrace::Scope stageTrace("preview", "cropUpdate");
+            crops[i]->update(todo);     // may call ourselves
+        }
+
     if (orig_prev != oprevi) {
         delete oprevi;
         oprevi = nullptr;
@@ -3211,8 +3257,13 @@ void ImProcCoordinator::process()
 
     paramsUpdateMutex.lock();
 
+    // Changes of a cancelled updatePreviewImage, which have to be redone along with the new ones
+    bool cancelledPanningRelatedChange = false;
+    bool cancelled = false;
+
     while (changeSinceLast) {
         const bool panningRelatedChange =
+            cancelledPanningRelatedChange ||
             params->toneCurve.isPanningRelatedChange(nextParams->toneCurve)
             || params->labCurve != nextParams->labCurve
             || params->locallab != nextParams->locallab
@@ -3254,10 +3305,23 @@ void ImProcCoordinator::process()
             || params->spot.enabled != nextParams->spot.enabled
             || sharpMaskChanged;
 
+        // When only the spots changed, the detail crops away from them are left as they are
+        spotsOnlyChange = false;
+
+        if (!cancelled && !sharpMaskChanged && !tweakOperator && !paramsBackup
+            && params->spot.enabled && nextParams->spot.enabled && params->spot.entries != nextParams->spot.entries) {
+            ProcParams spotParams = *nextParams;
+            spotParams.spot = params->spot;
+            spotsOnlyChange =
+                spotParams == *params
+                && ImProcFunctions::getSpotsChangedArea(params->spot.entries, nextParams->spot.entries, spotsChangedX1, spotsChangedY1, spotsChangedX2, spotsChangedY2);
+        }
+
         sharpMaskChanged = false;
         *params = *nextParams;
         int change = changeSinceLast;
         changeSinceLast = 0;
+        renderCancellation.reset();
 
         if (tweakOperator) {
             // TWEAKING THE PROCPARAMS FOR THE SPOT ADJUSTMENT MODE
@@ -3275,6 +3339,16 @@ void ImProcCoordinator::process()
         }
 
         paramsUpdateMutex.lock();
+
+        cancelled = renderCancellation.isCancelled();
+
+        if (cancelled) {
+            // The buffers of the cancelled stages hold partial results
+            changeSinceLast |= change;
+            cancelledPanningRelatedChange = panningRelatedChange;
+        } else {
+            cancelledPanningRelatedChange = false;
+        }
     }
 
     paramsUpdateMutex.unlock();
@@ -3302,6 +3376,11 @@ void ImProcCoordinator::endUpdateParams(int changeFlags)
 {
     changeSinceLast |= changeFlags;
 
+    if (updaterRunning && (changeFlags & (~M_VOID))) {
+        // Abandon the current render, process() redoes its changes along with the new ones
+        renderCancellation.cancel();
+    }
+
     paramsUpdateMutex.unlock();
     startProcessing();
 }
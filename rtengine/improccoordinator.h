@@ -90,6 +90,8 @@ protected:
     bool gamutCheck;
     bool sharpMask;
     bool sharpMaskChanged;
+    bool spotsOnlyChange; // only the spots changed since the last update, in the area below (full image coordinates)
+    int spotsChangedX1, spotsChangedY1, spotsChangedX2, spotsChangedY2;
     int scale;
     bool highDetailPreprocessComputed;
     bool highDetailRawComputed;
@@ -245,6 +247,7 @@ protected:
     MyMutex paramsUpdateMutex;
     int  changeSinceLast;
     bool updaterRunning;
+    CancellationToken renderCancellation; // set when new params arrive during updatePreviewImage, polled by ipf
     const std::unique_ptr<ProcParams> nextParams;
     bool destroying;
     bool utili;
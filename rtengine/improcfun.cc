@@ -305,6 +305,7 @@ void ImProcFunctions::updateColorProfiles(const Glib::ustring& monitorProfile, R
     }
 
     gamutWarning.reset(nullptr);
+    monitorMatrixTransform.reset(nullptr);
 
     monitorTransform = nullptr;
 
@@ -437,7 +438,11 @@ void ImProcFunctions::updateColorProfiles(const Glib::ustring& monitorProfile, R
                 flags |= cmsFLAGS_BLACKPOINTCOMPENSATION;
             }
 
-            monitorTransform = cmsCreateTransform(iprof, TYPE_Lab_FLT, monitor, TYPE_RGB_FLT, monitorIntent, flags);
+            monitorMatrixTransform = ICCStore::createMatrixShaperTransform(nullptr, monitor, monitorIntent, settings->monitorBPC);
+
+            if (!monitorMatrixTransform) {
+                monitorTransform = cmsCreateTransform(iprof, TYPE_Lab_FLT, monitor, TYPE_RGB_FLT, monitorIntent, flags);
+            }
         }
 
         if (gamutCheck && gamutprof) {
@@ -1522,15 +1527,15 @@ void ImProcFunctions::ciecam_02float(CieImage* ncie, float adap, int pW, int pwb
                     STVF(zbuffer[k], z * c655d35);
                 }
 
-                // XYZ2Lab uses a lookup table. The function behind that lut is a cube root.
-                // SSE can't beat the speed of that lut, so it doesn't make sense to use SSE
-                for (int j = 0; j < width; j++) {
-                    float Ll, aa, bb;
-                    //convert xyz=>lab
-                    Color::XYZ2Lab(xbuffer[j], ybuffer[j], zbuffer[j], Ll, aa, bb);
+                //convert xyz=>lab
+                Color::XYZ2Lab(xbuffer, ybuffer, zbuffer, lab->L[i], lab->a[i], lab->b[i], width);
 
-                    // gamut control in Lab mode; I must study how to do with cIECAM only
-                    if (gamu == 1) {
+                // gamut control in Lab mode; I must study how to do with cIECAM only
+                if (gamu == 1) {
+                    for (int j = 0; j < width; j++) {
+                        const float Ll = lab->L[i][j];
+                        const float aa = lab->a[i][j];
+                        const float bb = lab->b[i][j];
                         float Lprov1, Chprov1;
                         Lprov1 = Ll / 327.68f;
                         Chprov1 = sqrtf(SQR(aa) + SQR(bb)) / 327.68f;
@@ -1549,10 +1554,6 @@ void ImProcFunctions::ciecam_02float(CieImage* ncie, float adap, int pW, int pwb
                         lab->L[i][j] = Lprov1 * 327.68f;
                         lab->a[i][j] = 327.68f * Chprov1 * sincosval.y;
                         lab->b[i][j] = 327.68f * Chprov1 * sincosval.x;
-                    } else {
-                        lab->L[i][j] = Ll;
-                        lab->a[i][j] = aa;
-                        lab->b[i][j] = bb;
                     }
                 }
 
@@ -1831,14 +1832,14 @@ void ImProcFunctions::ciecam_02float(CieImage* ncie, float adap, int pW, int pwb
                         STVF(zbuffer[k], z);
                     }
 
-                    // XYZ2Lab uses a lookup table. The function behind that lut is a cube root.
-                    // SSE can't beat the speed of that lut, so it doesn't make sense to use SSE
-                    for (int j = 0; j < width; j++) {
-                        float Ll, aa, bb;
-                        //convert xyz=>lab
-                        Color::XYZ2Lab(xbuffer[j], ybuffer[j], zbuffer[j], Ll, aa, bb);
+                    //convert xyz=>lab
+                    Color::XYZ2Lab(xbuffer, ybuffer, zbuffer, lab->L[i], lab->a[i], lab->b[i], width);
 
-                        if (gamu == 1) {
+                    if (gamu == 1) {
+                        for (int j = 0; j < width; j++) {
+                            const float Ll = lab->L[i][j];
+                            const float aa = lab->a[i][j];
+                            const float bb = lab->b[i][j];
                             float Lprov1, Chprov1;
                             Lprov1 = Ll / 327.68f;
                             Chprov1 = sqrtf(SQR(aa) + SQR(bb)) / 327.68f;
@@ -1857,12 +1858,7 @@ void ImProcFunctions::ciecam_02float(CieImage* ncie, float adap, int pW, int pwb
                             lab->L[i][j] = Lprov1 * 327.68f;
                             lab->a[i][j] = 327.68f * Chprov1 * sincosval.y;
                             lab->b[i][j] = 327.68f * Chprov1 * sincosval.x;
-                        } else {
-                            lab->L[i][j] = Ll;
-                            lab->a[i][j] = aa;
-                            lab->b[i][j] = bb;
                         }
-
                     }
 
 #endif // __SSE2__
@@ -5709,9 +5705,9 @@ void ImProcFunctions::rgb2lab(const Imagefloat &src, LabImage &dst, const Glib::
 {
     TMatrix wprof = ICCStore::getInstance()->workingSpaceMatrix(workingSpace);
     const float wp[3][3] = {
-        {static_cast<float>(wprof[0][0]), static_cast<float>(wprof[0][1]), static_cast<float>(wprof[0][2])},
+        {static_cast<float>(wprof[0][0]) / Color::D50x, static_cast<float>(wprof[0][1]) / Color::D50x, static_cast<float>(wprof[0][2]) / Color::D50x},
         {static_cast<float>(wprof[1][0]), static_cast<float>(wprof[1][1]), static_cast<float>(wprof[1][2])},
-        {static_cast<float>(wprof[2][0]), static_cast<float>(wprof[2][1]), static_cast<float>(wprof[2][2])}
+        {static_cast<float>(wprof[2][0]) / Color::D50z, static_cast<float>(wprof[2][1]) / Color::D50z, static_cast<float>(wprof[2][2]) / Color::D50z}
     };
 
     const int W = src.getWidth();
@@ -5722,12 +5718,7 @@ void ImProcFunctions::rgb2lab(const Imagefloat &src, LabImage &dst, const Glib::
 #endif
 
     for (int i = 0; i < H; i++) {
-        for (int j = 0; j < W; j++) {
-            float X, Y, Z;
-            Color::rgbxyz(src.r(i, j), src.g(i, j), src.b(i, j), X, Y, Z, wp);
-            //convert Lab
-            Color::XYZ2Lab(X, Y, Z, dst.L[i][j], dst.a[i][j], dst.b[i][j]);
-        }
+        Color::RGB2Lab(src.r(i), src.g(i), src.b(i), dst.L[i], dst.a[i], dst.b[i], wp, W);
     }
 }
 
@@ -5821,29 +5812,39 @@ void ImProcFunctions::rgb2lab(const Image8 &src, int x, int y, int w, int h, flo
     } else {
         TMatrix wprof = ICCStore::getInstance()->workingSpaceMatrix(profile);
         const float wp[3][3] = {
-            {static_cast<float>(wprof[0][0]), static_cast<float>(wprof[0][1]), static_cast<float>(wprof[0][2])},
+            {static_cast<float>(wprof[0][0]) / Color::D50x, static_cast<float>(wprof[0][1]) / Color::D50x, static_cast<float>(wprof[0][2]) / Color::D50x},
             {static_cast<float>(wprof[1][0]), static_cast<float>(wprof[1][1]), static_cast<float>(wprof[1][2])},
-            {static_cast<float>(wprof[2][0]), static_cast<float>(wprof[2][1]), static_cast<float>(wprof[2][2])}
+            {static_cast<float>(wprof[2][0]) / Color::D50z, static_cast<float>(wprof[2][1]) / Color::D50z, static_cast<float>(wprof[2][2]) / Color::D50z}
         };
 
-        const int x2 = x + w;
         const int y2 = y + h;
         constexpr float rgb_factor = 65355.f / 255.f;
 
 #ifdef _OPENMP
-        #pragma omp parallel for schedule(dynamic,16) if (multiThread)
+        #pragma omp parallel if (multiThread)
+#endif
+        {
+            AlignedBuffer<float> rgbBuf(3 * w);
+            float *rbuffer = rgbBuf.data;
+            float *gbuffer = rbuffer + w;
+            float *bbuffer = gbuffer + w;
+
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic,16)
 #endif
 
-        for (int i = y; i < y2; i++) {
-            int offset = (i - y) * w;
+            for (int i = y; i < y2; i++) {
+                const int offset = (i - y) * w;
 
-            for (int j = x; j < x2; j++) {
-                float X, Y, Z;
-                // lab2rgb uses gamma2curve, which is gammatab_srgb.
-                const auto& igamma = Color::igammatab_srgb;
-                Color::rgbxyz(igamma[rgb_factor * src.r(i, j)], igamma[rgb_factor * src.g(i, j)], igamma[rgb_factor * src.b(i, j)], X, Y, Z, wp);
-                Color::XYZ2Lab(X, Y, Z, L[offset], a[offset], b[offset]);
-                offset++;
+                for (int j = 0; j < w; j++) {
+                    // lab2rgb uses gamma2curve, which is gammatab_srgb.
+                    const auto& igamma = Color::igammatab_srgb;
+                    rbuffer[j] = igamma[rgb_factor * src.r(i, x + j)];
+                    gbuffer[j] = igamma[rgb_factor * src.g(i, x + j)];
+                    bbuffer[j] = igamma[rgb_factor * src.b(i, x + j)];
+                }
+
+                Color::RGB2Lab(rbuffer, gbuffer, bbuffer, L + offset, a + offset, b + offset, wp, w);
             }
         }
     }
@@ -5875,42 +5876,13 @@ void ImProcFunctions::lab2rgb(const LabImage &src, Imagefloat &dst, const Glib::
 
     const int W = dst.getWidth();
     const int H = dst.getHeight();
-#ifdef __SSE2__
-    vfloat wipv[3][3];
-
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            wipv[i][j] = F2V(wiprof[i][j]);
-        }
-    }
-
-#endif
 
 #ifdef _OPENMP
     #pragma omp parallel for schedule(dynamic,16)
 #endif
 
     for (int i = 0; i < H; i++) {
-        int j = 0;
-#ifdef __SSE2__
-
-        for (; j < W - 3; j += 4) {
-            vfloat X, Y, Z;
-            vfloat R, G, B;
-            Color::Lab2XYZ(LVFU(src.L[i][j]), LVFU(src.a[i][j]), LVFU(src.b[i][j]), X, Y, Z);
-            Color::xyz2rgb(X, Y, Z, R, G, B, wipv);
-            STVFU(dst.r(i, j), R);
-            STVFU(dst.g(i, j), G);
-            STVFU(dst.b(i, j), B);
-        }
-
-#endif
-
-        for (; j < W; j++) {
-            float X, Y, Z;
-            Color::Lab2XYZ(src.L[i][j], src.a[i][j], src.b[i][j], X, Y, Z);
-            Color::xyz2rgb(X, Y, Z, dst.r(i, j), dst.g(i, j), dst.b(i, j), wip);
-        }
+        Color::Lab2RGB(src.L[i], src.a[i], src.b[i], dst.r(i), dst.g(i), dst.b(i), wip, W);
     }
 }
 
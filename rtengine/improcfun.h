@@ -23,10 +23,12 @@
 
 #include "coord2d.h"
 #include "gamutwarning.h"
+#include "iccstore.h"
 #include "imagedimensions.h"
 #include "jaggedarray.h"
 #include "pipettebuffer.h"
 #include "array2D.h"
+#include "cancellationtoken.h"
 #include "imagesource.h"
 #include <cairomm/cairomm.h>
 
@@ -110,12 +112,14 @@ enum RenderingIntent : int;
 class ImProcFunctions
 {
     cmsHTRANSFORM monitorTransform;
+    std::unique_ptr<MatrixShaperTransform> monitorMatrixTransform; // replaces monitorTransform for matrix-shaper monitor profiles
     std::unique_ptr<GamutWarning> gamutWarning;
     Cairo::RefPtr<Cairo::ImageSurface> locImage;
 
     const procparams::ProcParams* params;
     double scale;
     bool multiThread;
+    const CancellationToken* cancellationToken;
 
     void calcVignettingParams(int oW, int oH, const procparams::VignettingParams& vignetting, double &w2, double &h2, double& maxRadius, double &v, double &b, double &mul);
     static void rgb2lab(const Image8 &src, int x, int y, int w, int h, float L[], float a[], float b[], const procparams::ColorManagementParams &icm, bool consider_histogram_settings, bool multithread);
@@ -154,13 +158,22 @@ enum class BlurType {
     double lumimul[3];
 
     explicit ImProcFunctions(const procparams::ProcParams* iparams, bool imultiThread = true)
-        : monitorTransform(nullptr), params(iparams), scale(1), multiThread(imultiThread), lumimul{} {}
+        : monitorTransform(nullptr), params(iparams), scale(1), multiThread(imultiThread), cancellationToken(nullptr), lumimul{} {}
     ~ImProcFunctions();
     bool needsLuminanceOnly() const
     {
         return !(needsCA() || needsDistortion() || needsRotation() || needsPerspective() || needsLCP() || needsLensfun() || needsMetadata()) && (needsVignetting() || needsPCVignetting() || needsGradient());
     }
     void setScale(double iscale);
+    // The long running kernels (denoise, wavelets, local adjustments) stop early once the token is cancelled
+    void setCancellationToken(const CancellationToken* token)
+    {
+        cancellationToken = token;
+    }
+    bool isCancelled() const
+    {
+        return cancellationToken && cancellationToken->isCancelled();
+    }
 
     bool needsTransform(int oW, int oH, int rawRotationDeg, const FramesMetaData *metadata) const;
     bool needsPCVignetting() const;
@@ -503,6 +516,9 @@ enum class BlurType {
 
     // spot removal tool
     void removeSpots (rtengine::Imagefloat* img, rtengine::ImageSource* imgsrc, const std::vector<procparams::SpotEntry> &entries, const PreviewProps &pp, const rtengine::ColorTemp &currWB, const procparams::ColorManagementParams *cmp, int tr);
+    // Bounding box, in full image coordinates, of what spot removal changes when going from oldEntries to newEntries
+    // (spots copying from a changed area included). Returns false if nothing changes.
+    static bool getSpotsChangedArea(const std::vector<procparams::SpotEntry> &oldEntries, const std::vector<procparams::SpotEntry> &newEntries, int &x1, int &y1, int &x2, int &y2);
 
     // pyramid wavelet
     void cbdl_local_temp(float ** src, float ** loctemp, int srcwidth, int srcheight, const float * mult, float kchro, const double dirpyrThreshold, const float mergeL, const float contres, const double skinprot, const bool gamutlab, float b_l, float t_l, float t_r, float b_r,  int choice, int scale, bool multiThread);
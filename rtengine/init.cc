@@ -19,7 +19,9 @@
 #include <fftw3.h>
 #include <glibmm/miscutils.h>
 #include <glibmm/ustring.h>
+#include "bufferpool.h"
 #include "color.h"
+#include "cpudispatch.h"
 #include "rtengine.h"
 #include "iccstore.h"
 #include "dcp.h"
@@ -28,6 +30,8 @@
 #include "rawimagesource.h"
 #include "improcfun.h"
 #include "improccoordinator.h"
+#include "pipelinetrace.h"
+#include "fftwplancache.h"
 #include "dfmanager.h"
 #include "ffmanager.h"
 #include "rtthumbnail.h"
@@ -44,7 +48,6 @@ const Settings* settings;
 
 MyMutex* lcmsMutex = nullptr;
 MyMutex *fftwMutex = nullptr;
-MyMutex *librawMutex = nullptr;
 
 int init (const Settings* s, const Glib::ustring& baseDir, const Glib::ustring& userSettingsDir, bool loadAll)
 {
@@ -118,20 +121,46 @@ int init (const Settings* s, const Glib::ustring& baseDir, const Glib::ustring&
     Color::init ();
     Exiv2Metadata::init();
 
+    if (settings->verbose) {
+        printf("SIMD code path: %s\n", getSimdLevelName(getSimdLevel()));
+    }
+
+    if (!s->pipelineTraceFile.empty()) {
+        PipelineTrace::open(s->pipelineTraceFile);
+    }
+
+    BufferPool::setCapacity(static_cast<size_t>(s->bufferPoolSize) << 20);
+
     delete lcmsMutex;
     lcmsMutex = new MyMutex;
     fftwMutex = new MyMutex;
-    delete librawMutex;
-    librawMutex = new MyMutex;
+
+#ifdef RT_FFTW3F_OMP
+    fftwf_init_threads();
+#endif
+
+    if (!s->fftwWisdomFile.empty()) {
+        FftwPlanCache::loadWisdom(s->fftwWisdomFile);
+    }
+
     return 0;
 }
 
 void cleanup ()
 {
+    PipelineTrace::close();
     Exiv2Metadata::cleanup();
     ProcParams::cleanup ();
     Color::cleanup ();
     RawImageSource::cleanup ();
+    FftwPlanCache::saveWisdom();
+    FftwPlanCache::clear();
+
+    if (settings->verbose) {
+        BufferPool::printStats();
+    }
+
+    BufferPool::trim();
 
 #ifdef RT_FFTW3F_OMP
     fftwf_cleanup_threads();
@@ -26,6 +26,7 @@
 #include "imagefloat.h"
 #include "improcfun.h"
 #include "labimage.h"
+#include "lutrow.h"
 #include "procparams.h"
 #include "rtengine.h"
 #include "settings.h"
@@ -44,6 +45,15 @@ inline void copyAndClampLine(const float *src, unsigned char *dst, const int W)
     }
 }
 
+inline void copyAndClampLine(const float *R, const float *G, const float *B, unsigned char *dst, const int W)
+{
+    for (int j = 0; j < W; ++j) {
+        *(dst++) = uint16ToUint8Rounded(CLIP(R[j] * MAXVALF));
+        *(dst++) = uint16ToUint8Rounded(CLIP(G[j] * MAXVALF));
+        *(dst++) = uint16ToUint8Rounded(CLIP(B[j] * MAXVALF));
+    }
+}
+
 
 inline void copyAndClamp(const LabImage *src, unsigned char *dst, const double rgb_xyz[3][3], bool multiThread)
 {
@@ -58,72 +68,33 @@ inline void copyAndClamp(const LabImage *src, unsigned char *dst, const double r
         }
     }
 
-#ifdef __SSE2__
-    vfloat rgb_xyzv[3][3];
-
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            rgb_xyzv[i][j] = F2V(rgb_xyzf[i][j]);
-        }
-    }
-
-#endif
 #ifdef _OPENMP
-    #pragma omp parallel for schedule(dynamic,16) if (multiThread)
+    #pragma omp parallel if (multiThread)
 #endif
+    {
+        AlignedBuffer<float> buf(3 * W);
+        float *rbuffer = buf.data;
+        float *gbuffer = rbuffer + W;
+        float *bbuffer = gbuffer + W;
 
-    for (int i = 0; i < H; ++i) {
-        float* rL = src->L[i];
-        float* ra = src->a[i];
-        float* rb = src->b[i];
-        int ix = i * 3 * W;
-
-#ifdef __SSE2__
-        float rbuffer[W] ALIGNED16;
-        float gbuffer[W] ALIGNED16;
-        float bbuffer[W] ALIGNED16;
-        int j = 0;
-
-        for (; j < W - 3; j += 4) {
-            vfloat R, G, B;
-            vfloat x_, y_, z_;
-            Color::Lab2XYZ(LVFU(rL[j]), LVFU(ra[j]), LVFU(rb[j]), x_, y_, z_);
-            Color::xyz2rgb(x_, y_, z_, R, G, B, rgb_xyzv);
-            STVF(rbuffer[j], Color::gamma2curve[R]);
-            STVF(gbuffer[j], Color::gamma2curve[G]);
-            STVF(bbuffer[j], Color::gamma2curve[B]);
-        }
-
-        for (; j < W; ++j) {
-            float R, G, B;
-            float x_, y_, z_;
-            Color::Lab2XYZ(rL[j], ra[j], rb[j], x_, y_, z_);
-            Color::xyz2rgb(x_, y_, z_, R, G, B, rgb_xyzf);
-            rbuffer[j] = Color::gamma2curve[R];
-            gbuffer[j] = Color::gamma2curve[G];
-            bbuffer[j] = Color::gamma2curve[B];
-        }
-
-        for (j = 0; j < W; ++j) {
-            dst[ix++] = uint16ToUint8Rounded(rbuffer[j]);
-            dst[ix++] = uint16ToUint8Rounded(gbuffer[j]);
-            dst[ix++] = uint16ToUint8Rounded(bbuffer[j]);
-        }
+#ifdef _OPENMP
+        #pragma omp for schedule(dynamic,16)
+#endif
 
-#else
+        for (int i = 0; i < H; ++i) {
+            Color::Lab2RGB(src->L[i], src->a[i], src->b[i], rbuffer, gbuffer, bbuffer, rgb_xyzf, W);
+            lookupRow(Color::gamma2curve, rbuffer, rbuffer, W);
+            lookupRow(Color::gamma2curve, gbuffer, gbuffer, W);
+            lookupRow(Color::gamma2curve, bbuffer, bbuffer, W);
 
-        for (int j = 0; j < W; ++j) {
-            float R, G, B;
-            float x_, y_, z_;
-            Color::Lab2XYZ(rL[j], ra[j], rb[j], x_, y_, z_);
-            Color::xyz2rgb(x_, y_, z_, R, G, B, rgb_xyzf);
+            int ix = i * 3 * W;
 
-            dst[ix++] = uint16ToUint8Rounded(Color::gamma2curve[R]);
-            dst[ix++] = uint16ToUint8Rounded(Color::gamma2curve[G]);
-            dst[ix++] = uint16ToUint8Rounded(Color::gamma2curve[B]);
+            for (int j = 0; j < W; ++j) {
+                dst[ix++] = uint16ToUint8Rounded(rbuffer[j]);
+                dst[ix++] = uint16ToUint8Rounded(gbuffer[j]);
+                dst[ix++] = uint16ToUint8Rounded(bbuffer[j]);
+            }
         }
-
-#endif
     }
 }
 
@@ -147,10 +118,11 @@ vfloat gammalog(vfloat x, vfloat p, vfloat s, vfloat g3, vfloat g4)
 //         Thumbnail::processImage                (rtengine/rtthumbnail.cc)
 //
 // If monitorTransform, divide by 327.68 then apply monitorTransform (which can integrate soft-proofing)
+// If monitorMatrixTransform, apply it directly on the Lab rows
 // otherwise divide by 327.68, convert to xyz and apply the sRGB transform, before converting with gamma2curve
 void ImProcFunctions::lab2monitorRgb(LabImage* lab, Image8* image)
 {
-    if (monitorTransform) {
+    if (monitorTransform || monitorMatrixTransform) {
 
         const int W = lab->W;
         const int H = lab->H;
@@ -189,14 +161,26 @@ void ImProcFunctions::lab2monitorRgb(LabImage* lab, Image8* image)
                 float* ra = lab->a[i];
                 float* rb = lab->b[i];
 
+                if (monitorMatrixTransform) {
+                    // planar output, R G and B rows in outbuffer
+                    monitorMatrixTransform->labToRgb(rL, ra, rb, outbuffer, outbuffer + W, outbuffer + 2 * W, W);
+                    copyAndClampLine(outbuffer, outbuffer + W, outbuffer + 2 * W, data + ix, W);
+
+                    if (!gamutWarning) {
+                        continue;
+                    }
+                }
+
                 for (int j = 0; j < W; j++) {
                     buffer[iy++] = rL[j] / 327.68f;
                     buffer[iy++] = ra[j] / 327.68f;
                     buffer[iy++] = rb[j] / 327.68f;
                 }
 
-                cmsDoTransform(monitorTransform, buffer, outbuffer, W);
-                copyAndClampLine(outbuffer, data + ix, W);
+                if (!monitorMatrixTransform) {
+                    cmsDoTransform(monitorTransform, buffer, outbuffer, W);
+                    copyAndClampLine(outbuffer, data + ix, W);
+                }
 
                 if (gamutWarning) {
                     gamutWarning->markLine(image, i, buffer, gwBuf1.data, gwBuf2.data);
@@ -252,7 +236,32 @@ Image8* ImProcFunctions::lab2rgb(LabImage* lab, int cx, int cy, int cw, int ch,
         oprof = ICCStore::getInstance()->getProfile(profile);
     }
 
-    if (oprof) {
+    lcmsMutex->lock();
+    const std::unique_ptr<MatrixShaperTransform> matrixTransform = oprof ? ICCStore::createMatrixShaperTransform(nullptr, oprof, icm.outputIntent, icm.outputBPC) : nullptr;
+    lcmsMutex->unlock();
+
+    if (matrixTransform) {
+        unsigned char *data = image->data;
+
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+            AlignedBuffer<float> pBuf(3 * cw);
+            float *R = pBuf.data;
+            float *G = R + cw;
+            float *B = G + cw;
+
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic,16)
+#endif
+
+            for (int i = cy; i < cy + ch; i++) {
+                matrixTransform->labToRgb(lab->L[i] + cx, lab->a[i] + cx, lab->b[i] + cx, R, G, B, cw);
+                copyAndClampLine(R, G, B, data + (i - cy) * 3 * cw, cw);
+            }
+        } // End of parallelization
+    } else if (oprof) {
         const cmsUInt32Number flags = cmsFLAGS_NOOPTIMIZE | cmsFLAGS_NOCACHE | (icm.outputBPC ? cmsFLAGS_BLACKPOINTCOMPENSATION : 0); // NOCACHE is important for thread safety
 
         lcmsMutex->lock();
@@ -352,43 +361,47 @@ Imagefloat* ImProcFunctions::lab2rgbOut(LabImage* lab, int cx, int cy, int cw, i
         }
 
         lcmsMutex->lock();
-        cmsHPROFILE iprof = cmsCreateLab4Profile(nullptr);
-        cmsHTRANSFORM hTransform = cmsCreateTransform(iprof, TYPE_Lab_FLT, oprof, TYPE_RGB_FLT, icm.outputIntent, flags);
+        const std::unique_ptr<MatrixShaperTransform> matrixTransform = ICCStore::createMatrixShaperTransform(nullptr, oprof, icm.outputIntent, icm.outputBPC);
         lcmsMutex->unlock();
 
-        image->ExecCMSTransform(hTransform, *lab, cx, cy);
-        cmsDeleteTransform(hTransform);
-        cmsCloseProfile(iprof);
+        if (matrixTransform) {
+            image->ExecCMSTransform(*matrixTransform, *lab, cx, cy);
+        } else {
+            lcmsMutex->lock();
+            cmsHPROFILE iprof = cmsCreateLab4Profile(nullptr);
+            cmsHTRANSFORM hTransform = cmsCreateTransform(iprof, TYPE_Lab_FLT, oprof, TYPE_RGB_FLT, icm.outputIntent, flags);
+            lcmsMutex->unlock();
+
+            image->ExecCMSTransform(hTransform, *lab, cx, cy);
+            cmsDeleteTransform(hTransform);
+            cmsCloseProfile(iprof);
+        }
+
         image->normalizeFloatTo65535();
     } else {
 
+        float sRGB_xyzf[3][3];
+
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                sRGB_xyzf[i][j] = sRGB_xyz[i][j];
+            }
+        }
+
 #ifdef _OPENMP
         #pragma omp parallel for schedule(dynamic,16) if (multiThread)
 #endif
 
         for (int i = cy; i < cy + ch; i++) {
-            float R, G, B;
-            float* rL = lab->L[i];
-            float* ra = lab->a[i];
-            float* rb = lab->b[i];
-
-            for (int j = cx; j < cx + cw; j++) {
-
-                float fy = (Color::c1By116 * rL[j]) / 327.68f + Color::c16By116; // (L+16)/116
-                float fx = (0.002f * ra[j]) / 327.68f + fy;
-                float fz = fy - (0.005f * rb[j]) / 327.68f;
-                float LL = rL[j] / 327.68f;
-
-                float x_ = 65535.0f * Color::f2xyz(fx) * Color::D50x;
-                //float y_ = 65535.0 * Color::f2xyz(fy);
-                float z_ = 65535.0f * Color::f2xyz(fz) * Color::D50z;
-                float y_ = (LL > (float)Color::epskap) ? 65535.0f * fy * fy * fy : 65535.0f * LL / (float)Color::kappa;
-
-                Color::xyz2srgb(x_, y_, z_, R, G, B);
-
-                image->r(i - cy, j - cx) = Color::gamma2curve[CLIP(R)];
-                image->g(i - cy, j - cx) = Color::gamma2curve[CLIP(G)];
-                image->b(i - cy, j - cx) = Color::gamma2curve[CLIP(B)];
+            float* const R = image->r(i - cy);
+            float* const G = image->g(i - cy);
+            float* const B = image->b(i - cy);
+            Color::Lab2RGB(lab->L[i] + cx, lab->a[i] + cx, lab->b[i] + cx, R, G, B, sRGB_xyzf, cw);
+
+            for (int j = 0; j < cw; j++) {
+                R[j] = Color::gamma2curve[CLIP(R[j])];
+                G[j] = Color::gamma2curve[CLIP(G[j])];
+                B[j] = Color::gamma2curve[CLIP(B[j])];
             }
         }
     }
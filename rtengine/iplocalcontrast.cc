@@ -50,7 +50,13 @@ void ImProcFunctions::localContrast(LabImage *lab, float **destination, const rt
 #ifdef _OPENMP
         #pragma omp parallel if(multiThread)
 #endif
-        gaussianBlur(lab->L, buf, width, height, sigma);
+        {
+            if (settings->pyramidBlur) {
+                gaussianBlurPyramid(lab->L, buf, width, height, sigma);
+            } else {
+                gaussianBlur(lab->L, buf, width, height, sigma);
+            }
+        }
     } else {
         //OPENMP disabled
         ImProcFunctions::fftw_convol_blur2(lab->L, buf, width, height, sigma, 0, 0);
@@ -26,11 +26,13 @@
 #include "improcfun.h"
 #include "colortemp.h"
 #include "curves.h"
+#include "fftwplancache.h"
 #include "gauss.h"
 #include "iccstore.h"
 #include "imagefloat.h"
 #include "labimage.h"
 #include "color.h"
+#include "alignedbuffer.h"
 #include "rt_math.h"
 #include "jaggedarray.h"
 #include "rt_algo.h"
@@ -464,8 +466,6 @@ vfloat gammalog(vfloat x, vfloat p, vfloat s, vfloat g3, vfloat g4)
 namespace rtengine
 
 {
-extern MyMutex *fftwMutex;
-
 using namespace procparams;
 
 struct local_params {
@@ -3415,42 +3415,49 @@ void ImProcFunctions::ciecamloc_02float(struct local_params& lp, int sp, LabImag
         const bool logjz =  params->locallab.spots.at(sp).logjz;//log encoding
 //calculate min, max, mean for Jz
 #ifdef _OPENMP
-        #pragma omp parallel for reduction(min:mini) reduction(max:maxi) reduction(+:sum) if(multiThread)
+        #pragma omp parallel if (multiThread)
+#endif
+        {
+            AlignedBuffer<float> xyzBuffer(3 * width);
+            float *xbuffer = xyzBuffer.data;
+            float *ybuffer = xbuffer + width;
+            float *zbuffer = ybuffer + width;
+
+#ifdef _OPENMP
+            #pragma omp for reduction(min:mini) reduction(max:maxi) reduction(+:sum)
 #endif
 
-        for (int i = 0; i < height; i += 1) {
-            for (int k = 0; k < width; k += 1) {
-                float L = lab->L[i][k];
-                float a = lab->a[i][k];
-                float b = lab->b[i][k];
-                float x, y, z;
+            for (int i = 0; i < height; i += 1) {
                 //convert Lab => XYZ
-                Color::Lab2XYZ(L, a, b, x, y, z);
-                x = x / 65535.f;
-                y = y / 65535.f;
-                z = z / 65535.f;
-                double Jz, az, bz;
-                double xx, yy, zz;
-                //D50 ==> D65
-                xx = (d50_d65[0][0] * (double) x + d50_d65[0][1] * (double) y + d50_d65[0][2] * (double) z);
-                yy = (d50_d65[1][0] * (double) x + d50_d65[1][1] * (double) y + d50_d65[1][2] * (double) z);
-                zz = (d50_d65[2][0] * (double) x + d50_d65[2][1] * (double) y + d50_d65[2][2] * (double) z);
+                Color::Lab2XYZ(lab->L[i], lab->a[i], lab->b[i], xbuffer, ybuffer, zbuffer, width);
 
-                double L_p, M_p, S_p;
-                bool zcam = z_cam;
+                for (int k = 0; k < width; k += 1) {
+                    float x = xbuffer[k] / 65535.f;
+                    float y = ybuffer[k] / 65535.f;
+                    float z = zbuffer[k] / 65535.f;
+                    double Jz, az, bz;
+                    double xx, yy, zz;
+                    //D50 ==> D65
+                    xx = (d50_d65[0][0] * (double) x + d50_d65[0][1] * (double) y + d50_d65[0][2] * (double) z);
+                    yy = (d50_d65[1][0] * (double) x + d50_d65[1][1] * (double) y + d50_d65[1][2] * (double) z);
+                    zz = (d50_d65[2][0] * (double) x + d50_d65[2][1] * (double) y + d50_d65[2][2] * (double) z);
 
-                Ciecam02::xyz2jzczhz(Jz, az, bz, xx, yy, zz, pl, L_p, M_p, S_p, zcam);
+                    double L_p, M_p, S_p;
+                    bool zcam = z_cam;
 
-                if (Jz > maxi) {
-                    maxi = Jz;
-                }
+                    Ciecam02::xyz2jzczhz(Jz, az, bz, xx, yy, zz, pl, L_p, M_p, S_p, zcam);
 
-                if (Jz < mini) {
-                    mini = Jz;
-                }
+                    if (Jz > maxi) {
+                        maxi = Jz;
+                    }
 
-                sum += Jz;
-                // I read bz, az values and Hz ==> with low chroma values Hz are very different from lab always around 1.4 radians ???? for blue...
+                    if (Jz < mini) {
+                        mini = Jz;
+                    }
+
+                    sum += Jz;
+                    // I read bz, az values and Hz ==> with low chroma values Hz are very different from lab always around 1.4 radians ???? for blue...
+                }
             }
         }
 
@@ -3616,43 +3623,50 @@ void ImProcFunctions::ciecamloc_02float(struct local_params& lp, int sp, LabImag
         };
 
 #ifdef _OPENMP
-        #pragma omp parallel for if(multiThread)
+        #pragma omp parallel if (multiThread)
 #endif
+        {
+            AlignedBuffer<float> xyzBuffer(3 * width);
+            float *xbuffer = xyzBuffer.data;
+            float *ybuffer = xbuffer + width;
+            float *zbuffer = ybuffer + width;
 
-        for (int i = 0; i < height; i++) {
-            for (int k = 0; k < width; k++) {
-                float L = lab->L[i][k];
-                float a = lab->a[i][k];
-                float b = lab->b[i][k];
-                float x, y, z;
+#ifdef _OPENMP
+            #pragma omp for
+#endif
+
+            for (int i = 0; i < height; i++) {
                 //convert Lab => XYZ
-                Color::Lab2XYZ(L, a, b, x, y, z);
-                x = x / 65535.f;
-                y = y / 65535.f;
-                z = z / 65535.f;
-                double Jz, az, bz;//double need because matrix with const(1.6295499532821566e-11) and others
-                double xx, yy, zz;
-                //change WP to D65
-                xx = (d50_d65[0][0] * (double) x + d50_d65[0][1] * (double) y + d50_d65[0][2] * (double) z);
-                yy = (d50_d65[1][0] * (double) x + d50_d65[1][1] * (double) y + d50_d65[1][2] * (double) z);
-                zz = (d50_d65[2][0] * (double) x + d50_d65[2][1] * (double) y + d50_d65[2][2] * (double) z);
-
-                double L_p, M_p, S_p;
-                bool zcam = z_cam;
-                Ciecam02::xyz2jzczhz(Jz, az, bz, xx, yy, zz, pl, L_p, M_p, S_p, zcam);
-                //remapping Jz
-                Jz = Jz * to_screen;
-                az = az * to_screen;
-                bz = bz * to_screen;
-                JJz[i][k] = Jz;
-                Aaz[i][k] = az;
-                Bbz[i][k] = bz;
-
-                if (highhs > 0 || shadhs > 0  || wavcurvejz || mjjz != 0.f || lp.mCjz != 0.f  || LHcurvejz || HHcurvejz || CHcurvejz) {
-                    //here we work in float with usual functions  SH / wavelets / curves H
-                    temp->L[i][k] = tempresid->L[i][k] = tempres->L[i][k] = (float) to_one * 32768.f * (float) JJz[i][k];
-                    temp->a[i][k] = tempresid->a[i][k] = tempres->a[i][k] = (float) to_one * 32768.f * (float) Aaz[i][k];
-                    temp->b[i][k] = tempresid->b[i][k] = tempres->b[i][k] = (float) to_one * 32768.f * (float) Bbz[i][k];
+                Color::Lab2XYZ(lab->L[i], lab->a[i], lab->b[i], xbuffer, ybuffer, zbuffer, width);
+
+                for (int k = 0; k < width; k++) {
+                    float x = xbuffer[k] / 65535.f;
+                    float y = ybuffer[k] / 65535.f;
+                    float z = zbuffer[k] / 65535.f;
+                    double Jz, az, bz;//double need because matrix with const(1.6295499532821566e-11) and others
+                    double xx, yy, zz;
+                    //change WP to D65
+                    xx = (d50_d65[0][0] * (double) x + d50_d65[0][1] * (double) y + d50_d65[0][2] * (double) z);
+                    yy = (d50_d65[1][0] * (double) x + d50_d65[1][1] * (double) y + d50_d65[1][2] * (double) z);
+                    zz = (d50_d65[2][0] * (double) x + d50_d65[2][1] * (double) y + d50_d65[2][2] * (double) z);
+
+                    double L_p, M_p, S_p;
+                    bool zcam = z_cam;
+                    Ciecam02::xyz2jzczhz(Jz, az, bz, xx, yy, zz, pl, L_p, M_p, S_p, zcam);
+                    //remapping Jz
+                    Jz = Jz * to_screen;
+                    az = az * to_screen;
+                    bz = bz * to_screen;
+                    JJz[i][k] = Jz;
+                    Aaz[i][k] = az;
+                    Bbz[i][k] = bz;
+
+                    if (highhs > 0 || shadhs > 0  || wavcurvejz || mjjz != 0.f || lp.mCjz != 0.f  || LHcurvejz || HHcurvejz || CHcurvejz) {
+                        //here we work in float with usual functions  SH / wavelets / curves H
+                        temp->L[i][k] = tempresid->L[i][k] = tempres->L[i][k] = (float) to_one * 32768.f * (float) JJz[i][k];
+                        temp->a[i][k] = tempresid->a[i][k] = tempres->a[i][k] = (float) to_one * 32768.f * (float) Aaz[i][k];
+                        temp->b[i][k] = tempresid->b[i][k] = tempres->b[i][k] = (float) to_one * 32768.f * (float) Bbz[i][k];
+                    }
                 }
             }
         }
@@ -3894,184 +3908,194 @@ void ImProcFunctions::ciecamloc_02float(struct local_params& lp, int sp, LabImag
 
 
 #ifdef _OPENMP
-        #pragma omp parallel  for if(multiThread)
+        #pragma omp parallel if (multiThread)
 #endif
+        {
+            AlignedBuffer<float> xyzBuffer(3 * width);
+            float *xbuffer = xyzBuffer.data;
+            float *ybuffer = xbuffer + width;
+            float *zbuffer = ybuffer + width;
 
-        for (int i = 0; i < height; i++) {
-            for (int k = 0; k < width; k++) {
-                //reconvert to double
-                if (highhs > 0 || shadhs > 0  || wavcurvejz || mjjz != 0.f || lp.mCjz != 0.f || LHcurvejz || HHcurvejz || CHcurvejz) {
-                    //now we work in double necessary for matrix conversion and when in range 0..1 with use of PQ
-                    JJz[i][k] = (double)(temp->L[i][k] / (32768.f * (float) to_one));
-                    Aaz[i][k] = (double)(temp->a[i][k] / (32768.f * (float) to_one));
-                    Bbz[i][k] = (double)(temp->b[i][k] / (32768.f * (float) to_one));
-                }
+#ifdef _OPENMP
+            #pragma omp for
+#endif
 
-                double az =  Aaz[i][k];
-                double bz =  Bbz[i][k];
-                double Jz =  LIM01(JJz[i][k]);
-                Jz *= to_one;
-                double Cz = sqrt(az * az + bz * bz);
+            for (int i = 0; i < height; i++) {
+                for (int k = 0; k < width; k++) {
+                    //reconvert to double
+                    if (highhs > 0 || shadhs > 0  || wavcurvejz || mjjz != 0.f || lp.mCjz != 0.f || LHcurvejz || HHcurvejz || CHcurvejz) {
+                        //now we work in double necessary for matrix conversion and when in range 0..1 with use of PQ
+                        JJz[i][k] = (double)(temp->L[i][k] / (32768.f * (float) to_one));
+                        Aaz[i][k] = (double)(temp->a[i][k] / (32768.f * (float) to_one));
+                        Bbz[i][k] = (double)(temp->b[i][k] / (32768.f * (float) to_one));
+                    }
+
+                    double az =  Aaz[i][k];
+                    double bz =  Bbz[i][k];
+                    double Jz =  LIM01(JJz[i][k]);
+                    Jz *= to_one;
+                    double Cz = sqrt(az * az + bz * bz);
+
+                    //log encoding
+                    if (logjz) {
+                        double jmz =  Jz;
+
+                        if (jmz > noise) {
+                            double mm = applytojz(jmz);
+                            double f = mm / jmz;
+                            Jz *= f;
+                            Jz = LIM01(Jz);//clip values
+                        }
+                    }
 
-                //log encoding
-                if (logjz) {
-                    double jmz =  Jz;
+                    //sigmoid
+                    if (issigjz && iscie) { //sigmoid Jz
+                        float val = Jz;
 
-                    if (jmz > noise) {
-                        double mm = applytojz(jmz);
-                        double f = mm / jmz;
-                        Jz *= f;
-                        Jz = LIM01(Jz);//clip values
-                    }
-                }
+                        if (islogjz) {
+                            val = std::max((xlog(Jz) / log2 - shadows_range) / (dynamic_range + 1.5), noise);//in range EV
+                        }
+
+                        if (sigmoidthjz >= 1.f) {
+                            thjz = athjz * val + bthjz;//threshold
+                        } else {
+                            thjz = atjz * val + btjz;
+                        }
 
-                //sigmoid
-                if (issigjz && iscie) { //sigmoid Jz
-                    float val = Jz;
+                        sigmoidla(val, thjz, sigmjz); //sigmz "slope" of sigmoid
 
-                    if (islogjz) {
-                        val = std::max((xlog(Jz) / log2 - shadows_range) / (dynamic_range + 1.5), noise);//in range EV
-                    }
 
-                    if (sigmoidthjz >= 1.f) {
-                        thjz = athjz * val + bthjz;//threshold
-                    } else {
-                        thjz = atjz * val + btjz;
+                        Jz = LIM01((double) bljz * Jz + (double) val);
                     }
 
-                    sigmoidla(val, thjz, sigmjz); //sigmz "slope" of sigmoid
+                    if (Qtoj == true) { //lightness instead of brightness
+                        Jz /= to_one;
+                        Jz /= maxjzw;//Jz white
+                        Jz = SQR(Jz);
+                    }
 
+                    //contrast
+                    Jz = LIM01(jz_contrast.getVal(LIM01(Jz)));
 
-                    Jz = LIM01((double) bljz * Jz + (double) val);
-                }
+                    //brightness and lightness
+                    if (lightreal > 0) {
+                        Jz = LIM01(jz_light.getVal(Jz));
+                    }
 
-                if (Qtoj == true) { //lightness instead of brightness
-                    Jz /= to_one;
-                    Jz /= maxjzw;//Jz white
-                    Jz = SQR(Jz);
-                }
+                    if (lightreal < 0) {
+                        Jz = LIM01(jz_lightn.getVal(Jz));
+                    }
 
-                //contrast
-                Jz = LIM01(jz_contrast.getVal(LIM01(Jz)));
+                    //Jz (Jz) curve
+                    double Jzold = Jz;
 
-                //brightness and lightness
-                if (lightreal > 0) {
-                    Jz = LIM01(jz_light.getVal(Jz));
-                }
+                    if (jzlocalcurve && localjzutili) {
+                        Jz = (double)(jzlocalcurve[(float) Jz * 65535.f] / 65535.f);
+                        Jz  = 0.3 * (Jz - Jzold) + Jzold;
+                    }
 
-                if (lightreal < 0) {
-                    Jz = LIM01(jz_lightn.getVal(Jz));
-                }
+                    //reconvert from lightness or Brightness
+                    if (Qtoj == false) {
+                        Jz /= to_one;
+                    } else {
+                        Jz = sqrt(Jz);
+                        Jz *= maxjzw;
+                    }
 
-                //Jz (Jz) curve
-                double Jzold = Jz;
+                    double Hz;
+                    //remapping Cz
+                    Hz = xatan2(bz, az);
+                    double Czold = Cz;
 
-                if (jzlocalcurve && localjzutili) {
-                    Jz = (double)(jzlocalcurve[(float) Jz * 65535.f] / 65535.f);
-                    Jz  = 0.3 * (Jz - Jzold) + Jzold;
-                }
+                    //Cz(Cz) curve
+                    if (czlocalcurve && localczutili) {
+                        Cz = (double)(czlocalcurve[(float) Cz * 92666.f * (float) to_one] / (92666.f * (float) to_one));
+                        Cz  = 0.5 * (Cz - Czold) + Czold;
+                    }
 
-                //reconvert from lightness or Brightness
-                if (Qtoj == false) {
-                    Jz /= to_one;
-                } else {
-                    Jz = sqrt(Jz);
-                    Jz *= maxjzw;
-                }
+                    //Cz(Jz) curve
+                    if (czjzlocalcurve && localczjzutili) {
+                        double chromaCfactor = (double)(czjzlocalcurve[(float) Jz * 65535.f * (float) to_one]) / (Jz * 65535. * to_one);
+                        Cz  *=  chromaCfactor;
+                    }
 
-                double Hz;
-                //remapping Cz
-                Hz = xatan2(bz, az);
-                double Czold = Cz;
+                    //Hz in 0 2*PI
+                    if (Hz < 0.0) {
+                        Hz += (2. * rtengine::RT_PI);
+                    }
 
-                //Cz(Cz) curve
-                if (czlocalcurve && localczutili) {
-                    Cz = (double)(czlocalcurve[(float) Cz * 92666.f * (float) to_one] / (92666.f * (float) to_one));
-                    Cz  = 0.5 * (Cz - Czold) + Czold;
-                }
+                    //Chroma slider
+                    if (chromz < 0.) {
+                        Cz = Cz * (1. + 0.01 * chromz);
+                    } else {
+                        double maxcz = czlim / to_one;
+                        double fcz = Cz / maxcz;
+                        double pocz = pow(fcz, 1. - 0.0024 * chromz); //increase value - before 0.0017
+                        Cz = maxcz * pocz;
+                        //  Cz = Cz * (1. + 0.005 * chromz);//linear
+                    }
 
-                //Cz(Jz) curve
-                if (czjzlocalcurve && localczjzutili) {
-                    double chromaCfactor = (double)(czjzlocalcurve[(float) Jz * 65535.f * (float) to_one]) / (Jz * 65535. * to_one);
-                    Cz  *=  chromaCfactor;
-                }
+                    //saturation slider
+                    if (saturz != 0.) {
+                        double js = Jz / maxjzw; //divide by Jz white
+                        js = SQR(js);
 
-                //Hz in 0 2*PI
-                if (Hz < 0.0) {
-                    Hz += (2. * rtengine::RT_PI);
-                }
+                        if (js <= 0.) {
+                            js = 0.0000001;
+                        }
 
-                //Chroma slider
-                if (chromz < 0.) {
-                    Cz = Cz * (1. + 0.01 * chromz);
-                } else {
-                    double maxcz = czlim / to_one;
-                    double fcz = Cz / maxcz;
-                    double pocz = pow(fcz, 1. - 0.0024 * chromz); //increase value - before 0.0017
-                    Cz = maxcz * pocz;
-                    //  Cz = Cz * (1. + 0.005 * chromz);//linear
-                }
+                        double Sz = Cz / (js);
 
-                //saturation slider
-                if (saturz != 0.) {
-                    double js = Jz / maxjzw; //divide by Jz white
-                    js = SQR(js);
+                        if (saturz < 0.) {
+                            Sz = Sz * (1. + 0.01 * saturz);
+                        } else {
+                            Sz = Sz * (1. + 0.003 * saturz);//not pow function because Sz is "open" - 0.003 empirical value to have results comparable to Cz
+                        }
 
-                    if (js <= 0.) {
-                        js = 0.0000001;
+                        Cz = Sz * js;
                     }
 
-                    double Sz = Cz / (js);
+                    //rotation hue
+                    Hz += dhue;
 
-                    if (saturz < 0.) {
-                        Sz = Sz * (1. + 0.01 * saturz);
-                    } else {
-                        Sz = Sz * (1. + 0.003 * saturz);//not pow function because Sz is "open" - 0.003 empirical value to have results comparable to Cz
+                    if (Hz < 0.0) {
+                        Hz += (2. * rtengine::RT_PI);
                     }
 
-                    Cz = Sz * js;
-                }
+                    Cz = clipcz(Cz);
+                    double2 sincosval = xsincos(Hz);
+                    az = clipazbz(Cz * sincosval.y);
+                    bz = clipazbz(Cz * sincosval.x);
+                    Cz = sqrt(az * az + bz * bz);
 
-                //rotation hue
-                Hz += dhue;
-
-                if (Hz < 0.0) {
-                    Hz += (2. * rtengine::RT_PI);
-                }
 
-                Cz = clipcz(Cz);
-                double2 sincosval = xsincos(Hz);
-                az = clipazbz(Cz * sincosval.y);
-                bz = clipazbz(Cz * sincosval.x);
-                Cz = sqrt(az * az + bz * bz);
+                    bz = bz / (to_screen);
+                    az = az / (to_screen);
 
+                    Jz = LIM01(Jz / (to_screen));
 
-                bz = bz / (to_screen);
-                az = az / (to_screen);
+                    if (jabcie) { //Not used does not work at all
+                        Jz = clipjz05(Jz);
+                        gamutjz(Jz, az, bz, pl, wip, 0.94, 0.004);
+                    }
 
-                Jz = LIM01(Jz / (to_screen));
+                    double L_, M_, S_;
+                    double xx, yy, zz;
+                    bool zcam = z_cam;
+                    //reconvert to XYZ in double
+                    Ciecam02::jzczhzxyz(xx, yy, zz, Jz, az, bz, pl, L_, M_, S_, zcam);
+                    //re enable D50
+                    double x, y, z;
+                    x = 65535. * (d65_d50[0][0] * xx + d65_d50[0][1] * yy + d65_d50[0][2] * zz);
+                    y = 65535. * (d65_d50[1][0] * xx + d65_d50[1][1] * yy + d65_d50[1][2] * zz);
+                    z = 65535. * (d65_d50[2][0] * xx + d65_d50[2][1] * yy + d65_d50[2][2] * zz);
 
-                if (jabcie) { //Not used does not work at all
-                    Jz = clipjz05(Jz);
-                    gamutjz(Jz, az, bz, pl, wip, 0.94, 0.004);
+                    xbuffer[k] = x;
+                    ybuffer[k] = y;
+                    zbuffer[k] = z;
                 }
 
-                double L_, M_, S_;
-                double xx, yy, zz;
-                bool zcam = z_cam;
-                //reconvert to XYZ in double
-                Ciecam02::jzczhzxyz(xx, yy, zz, Jz, az, bz, pl, L_, M_, S_, zcam);
-                //re enable D50
-                double x, y, z;
-                x = 65535. * (d65_d50[0][0] * xx + d65_d50[0][1] * yy + d65_d50[0][2] * zz);
-                y = 65535. * (d65_d50[1][0] * xx + d65_d50[1][1] * yy + d65_d50[1][2] * zz);
-                z = 65535. * (d65_d50[2][0] * xx + d65_d50[2][1] * yy + d65_d50[2][2] * zz);
-
-                float Ll, aa, bb;
-                Color::XYZ2Lab(x,  y,  z, Ll, aa, bb);
-                lab->L[i][k] = Ll;
-                lab->a[i][k] = aa;
-                lab->b[i][k] = bb;
+                Color::XYZ2Lab(xbuffer, ybuffer, zbuffer, lab->L[i], lab->a[i], lab->b[i], width);
             }
         }
     }
@@ -4100,66 +4124,73 @@ void ImProcFunctions::ciecamloc_02float(struct local_params& lp, int sp, LabImag
 
             //find main values Cam16
 #ifdef _OPENMP
-            #pragma omp parallel for reduction(min:minicam) reduction(max:maxicamj) reduction(min:minicamq) reduction(max:maxicamq) reduction(min:minisat) reduction(max:maxisat) reduction(min:miniM) reduction(max:maxiM) reduction(+:sumcam) reduction(+:sumcamq) reduction(+:sumsat) reduction(+:sumM)if(multiThread)
+            #pragma omp parallel if (multiThread)
 #endif
+            {
+                AlignedBuffer<float> xyzBuffer(3 * width);
+                float *xbuffer = xyzBuffer.data;
+                float *ybuffer = xbuffer + width;
+                float *zbuffer = ybuffer + width;
 
-            for (int i = 0; i < height; i += 1) {
-                for (int k = 0; k < width; k += 1) {
-                    float L = lab->L[i][k];
-                    float a = lab->a[i][k];
-                    float b = lab->b[i][k];
-                    float x, y, z;
+#ifdef _OPENMP
+                #pragma omp for reduction(min:minicam) reduction(max:maxicamj) reduction(min:minicamq) reduction(max:maxicamq) reduction(min:minisat) reduction(max:maxisat) reduction(min:miniM) reduction(max:maxiM) reduction(+:sumcam) reduction(+:sumcamq) reduction(+:sumsat) reduction(+:sumM)
+#endif
+
+                for (int i = 0; i < height; i += 1) {
                     //convert Lab => XYZ
-                    Color::Lab2XYZ(L, a, b, x, y, z);
-                    x = x / 655.35f;
-                    y = y / 655.35f;
-                    z = z / 655.35f;
-                    float J, C, h, Q, M, s;
-                    Ciecam02::xyz2jchqms_ciecam02float(J, C,  h,
-                                                       Q,  M,  s, aw, fl, wh,
-                                                       x,  y,  z,
-                                                       xw1, yw1,  zw1,
-                                                       c,  nc, pow1, nbb, ncb, pfl, cz, d, c16, plum);
+                    Color::Lab2XYZ(lab->L[i], lab->a[i], lab->b[i], xbuffer, ybuffer, zbuffer, width);
+
+                    for (int k = 0; k < width; k += 1) {
+                        float x = xbuffer[k] / 655.35f;
+                        float y = ybuffer[k] / 655.35f;
+                        float z = zbuffer[k] / 655.35f;
+                        float J, C, h, Q, M, s;
+                        Ciecam02::xyz2jchqms_ciecam02float(J, C,  h,
+                                                           Q,  M,  s, aw, fl, wh,
+                                                           x,  y,  z,
+                                                           xw1, yw1,  zw1,
+                                                           c,  nc, pow1, nbb, ncb, pfl, cz, d, c16, plum);
+
+                        if (J > maxicamj) {
+                            maxicamj = J;
+                        }
 
-                    if (J > maxicamj) {
-                        maxicamj = J;
-                    }
+                        if (J < minicam) {
+                            minicam = J;
+                        }
 
-                    if (J < minicam) {
-                        minicam = J;
-                    }
+                        sumcam += J;
 
-                    sumcam += J;
+                        if (Q > maxicamq) {
+                            maxicamq = Q;
+                        }
 
-                    if (Q > maxicamq) {
-                        maxicamq = Q;
-                    }
+                        if (Q < minicamq) {
+                            minicamq = Q;
+                        }
 
-                    if (Q < minicamq) {
-                        minicamq = Q;
-                    }
+                        sumcamq += Q;
 
-                    sumcamq += Q;
+                        if (s > maxisat) {
+                            maxisat = s;
+                        }
 
-                    if (s > maxisat) {
-                        maxisat = s;
-                    }
+                        if (s < minisat) {
+                            minisat = s;
+                        }
 
-                    if (s < minisat) {
-                        minisat = s;
-                    }
+                        sumsat += s;
 
-                    sumsat += s;
+                        if (M > maxiM) {
+                            maxiM = M;
+                        }
 
-                    if (M > maxiM) {
-                        maxiM = M;
-                    }
+                        if (M < miniM) {
+                            miniM = M;
+                        }
 
-                    if (M < miniM) {
-                        miniM = M;
+                        sumM += M;
                     }
-
-                    sumM += M;
                 }
             }
 
@@ -4568,22 +4599,15 @@ void ImProcFunctions::ciecamloc_02float(struct local_params& lp, int sp, LabImag
                     STVF(zbuffer[k], z * c655d35);
                 }
 
-                // XYZ2Lab uses a lookup table. The function behind that lut is a cube root.
-                // SSE can't beat the speed of that lut, so it doesn't make sense to use SSE
                 for (int j = 0; j < width; j++) {
-                    float Ll, aa, bb;
-                    //convert xyz=>lab
                     xbuffer[j] = CLIP(xbuffer[j]);
                     ybuffer[j] = CLIP(ybuffer[j]);
                     zbuffer[j] = CLIP(zbuffer[j]);
-
-                    Color::XYZ2Lab(xbuffer[j], ybuffer[j], zbuffer[j], Ll, aa, bb);
-
-                    lab->L[i][j] = Ll;
-                    lab->a[i][j] = aa;
-                    lab->b[i][j] = bb;
                 }
 
+                //convert xyz=>lab
+                Color::XYZ2Lab(xbuffer, ybuffer, zbuffer, lab->L[i], lab->a[i], lab->b[i], width);
+
 #endif
             }
         }
@@ -4846,7 +4870,6 @@ void ImProcFunctions::exlabLocal(local_params& lp, float strlap, int bfh, int bf
                 }
             }
 
-            MyMutex::MyLock lock(*fftwMutex);
             ImProcFunctions::retinex_pde(datain.get(), dataout.get(), bfwr, bfhr, lap, 1.f, dE.get(), 0, 1, 1);//350 arbitrary value about 45% strength Laplacian
 #ifdef _OPENMP
             #pragma omp parallel for schedule(dynamic,16) if (multiThread)
@@ -5819,20 +5842,25 @@ void ImProcFunctions::blendstruc(int bfw, int bfh, LabImage* bufcolorig, float r
     array2D<float> ble(bfw, bfh);
     array2D<float> guid(bfw, bfh);
 #ifdef _OPENMP
-    #pragma omp parallel for if (multiThread)
+    #pragma omp parallel if (multiThread)
 #endif
+    {
+        AlignedBuffer<float> xzBuffer(2 * bfw);
+        float *xbuffer = xzBuffer.data;
+        float *zbuffer = xbuffer + bfw;
 
-    for (int ir = 0; ir < bfh; ir++) {
-        for (int jr = 0; jr < bfw; jr++) {
-            float X, Y, Z;
-            float L = bufcolorig->L[ir][jr];
-            float a = bufcolorig->a[ir][jr];
-            float b = bufcolorig->b[ir][jr];
-            Color::Lab2XYZ(L, a, b, X, Y, Z);
+#ifdef _OPENMP
+        #pragma omp for
+#endif
 
-            guid[ir][jr] = Y / 32768.f;
+        for (int ir = 0; ir < bfh; ir++) {
+            Color::Lab2XYZ(bufcolorig->L[ir], bufcolorig->a[ir], bufcolorig->b[ir], xbuffer, guid[ir], zbuffer, bfw);
+
+            for (int jr = 0; jr < bfw; jr++) {
+                guid[ir][jr] /= 32768.f;
 
-            blend2[ir][jr] /= 32768.f;
+                blend2[ir][jr] /= 32768.f;
+            }
         }
     }
 
@@ -6313,14 +6341,6 @@ void ImProcFunctions::retinex_pde(const float * datain, float * dataout, int bfw
 
     // BENCHFUN
 
-#ifdef RT_FFTW3F_OMP
-    if (multiThread) {
-        fftwf_init_threads();
-        fftwf_plan_with_nthreads(omp_get_max_threads());
-    }
-
-#endif
-
     float *datashow = nullptr;
 
     if (show != 0) {
@@ -6358,9 +6378,8 @@ void ImProcFunctions::retinex_pde(const float * datain, float * dataout, int bfw
     }
 
     //execute first
-    const auto dct_fw = fftwf_plan_r2r_2d(bfh, bfw, data_tmp, data_fft, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
-    fftwf_execute(dct_fw);
-    fftwf_destroy_plan(dct_fw);
+    const auto dct_fw = FftwPlanCache::r2r2d(bfh, bfw, data_tmp, data_fft, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE | FFTW_DESTROY_INPUT, multiThread);
+    fftwf_execute_r2r(dct_fw, data_tmp, data_fft);
 
     //execute second
     if (dEenable == 1) {
@@ -6374,9 +6393,7 @@ void ImProcFunctions::retinex_pde(const float * datain, float * dataout, int bfw
 
         //second call to laplacian with 40% strength ==> reduce effect if we are far from ref (deltaE)
         discrete_laplacian_threshold(data_tmp04, datain, bfw, bfh, 0.4f * thresh);
-        const auto dct_fw04 = fftwf_plan_r2r_2d(bfh, bfw, data_tmp04, data_fft04, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
-        fftwf_execute(dct_fw04);
-        fftwf_destroy_plan(dct_fw04);
+        fftwf_execute_r2r(dct_fw, data_tmp04, data_fft04);
         constexpr float exponent = 4.5f;
 
 #ifdef _OPENMP
@@ -6429,9 +6446,8 @@ void ImProcFunctions::retinex_pde(const float * datain, float * dataout, int bfw
         }
     }
 
-    const auto dct_bw = fftwf_plan_r2r_2d(bfh, bfw, data_fft, data_tmp, FFTW_REDFT01, FFTW_REDFT01, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
-    fftwf_execute(dct_bw);
-    fftwf_destroy_plan(dct_bw);
+    const auto dct_bw = FftwPlanCache::r2r2d(bfh, bfw, data_fft, data_tmp, FFTW_REDFT01, FFTW_REDFT01, FFTW_ESTIMATE | FFTW_DESTROY_INPUT, multiThread);
+    fftwf_execute_r2r(dct_bw, data_fft, data_tmp);
     fftwf_free(data_fft);
 
     if (show != 4 && normalize == 1) {
@@ -6462,16 +6478,6 @@ void ImProcFunctions::retinex_pde(const float * datain, float * dataout, int bfw
     if (datashow) {
         fftwf_free(datashow);
     }
-
-    fftwf_cleanup();
-
-#ifdef RT_FFTW3F_OMP
-
-    if (multiThread) {
-        fftwf_cleanup_threads();
-    }
-
-#endif
 }
 
 void ImProcFunctions::maskcalccol(bool invmask, bool pde, int bfw, int bfh, int xstart, int ystart, int sk, int cx, int cy, LabImage* bufcolorig, LabImage* bufmaskblurcol, LabImage* originalmaskcol, LabImage* original, LabImage* reserved, int inv, struct local_params & lp,
@@ -9399,13 +9405,6 @@ void ImProcFunctions::exposure_pde(float * dataor, float * datain, float * datao
 {
 
     //BENCHFUN
-#ifdef RT_FFTW3F_OMP
-    if (multiThread) {
-        fftwf_init_threads();
-        fftwf_plan_with_nthreads(omp_get_max_threads());
-    }
-
-#endif
     float *data_fft, *data_tmp, *data;
 
     if (NULL == (data_tmp = (float *) fftwf_malloc(sizeof(float) * bfw * bfh))) {
@@ -9425,8 +9424,8 @@ void ImProcFunctions::exposure_pde(float * dataor, float * datain, float * datao
         abort();
     }
 
-    const auto dct_fw = fftwf_plan_r2r_2d(bfh, bfw, data_tmp, data_fft, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
-    fftwf_execute(dct_fw);
+    const auto dct_fw = FftwPlanCache::r2r2d(bfh, bfw, data_tmp, data_fft, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE | FFTW_DESTROY_INPUT, multiThread);
+    fftwf_execute_r2r(dct_fw, data_tmp, data_fft);
 
     fftwf_free(data_tmp);
 
@@ -9434,20 +9433,9 @@ void ImProcFunctions::exposure_pde(float * dataor, float * datain, float * datao
     /* 1. / (float) (bfw * bfh)) is the DCT normalisation term, see libfftw */
     ImProcFunctions::rex_poisson_dct(data_fft, bfw, bfh, 1. / (double)(bfw * bfh));
 
-    const auto dct_bw = fftwf_plan_r2r_2d(bfh, bfw, data_fft, data, FFTW_REDFT01, FFTW_REDFT01, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
-    fftwf_execute(dct_bw);
-    fftwf_destroy_plan(dct_fw);
-    fftwf_destroy_plan(dct_bw);
+    const auto dct_bw = FftwPlanCache::r2r2d(bfh, bfw, data_fft, data, FFTW_REDFT01, FFTW_REDFT01, FFTW_ESTIMATE | FFTW_DESTROY_INPUT, multiThread);
+    fftwf_execute_r2r(dct_bw, data_fft, data);
     fftwf_free(data_fft);
-    fftwf_cleanup();
-
-#ifdef RT_FFTW3F_OMP
-
-    if (multiThread) {
-        fftwf_cleanup_threads();
-    }
-
-#endif
 
     normalize_mean_dt(data, dataor, bfw * bfh, mod, 1.f, 0.f, 0.f, 0.f, 0.f, 1.);
     {
@@ -9488,20 +9476,11 @@ void ImProcFunctions::fftw_convol_blur(float * input, float * output, int bfw, i
     */
     //BENCHFUN
 
-#ifdef RT_FFTW3F_OMP
-    if (multiThread) {
-        fftwf_init_threads();
-        fftwf_plan_with_nthreads(omp_get_max_threads());
-    }
-
-#endif
-
-
     float *out; //for FFT data
     float *kern = nullptr;//for kernel gauss
     float *outkern = nullptr;//for FFT kernel
-    fftwf_plan p;
-    fftwf_plan pkern;//plan for FFT
+    FftwPlanCache::Plan p;
+    FftwPlanCache::Plan pkern;//plan for FFT
     int image_size, image_sizechange;
     float n_x = 1.f;
     float n_y = 1.f;//relative coordinates for kernel Gauss
@@ -9517,10 +9496,9 @@ void ImProcFunctions::fftw_convol_blur(float * input, float * output, int bfw, i
 
     /*compute the Fourier transform of the input data*/
 
-    p = fftwf_plan_r2r_2d(bfh, bfw, input, out, FFTW_REDFT10, FFTW_REDFT10,  FFTW_ESTIMATE);//FFT 2 dimensions forward  FFTW_MEASURE FFTW_ESTIMATE
+    p = FftwPlanCache::r2r2d(bfh, bfw, input, out, FFTW_REDFT10, FFTW_REDFT10,  FFTW_ESTIMATE, multiThread);//FFT 2 dimensions forward  FFTW_MEASURE FFTW_ESTIMATE
 
-    fftwf_execute(p);
-    fftwf_destroy_plan(p);
+    fftwf_execute_r2r(p, input, out);
 
     /*define the gaussian constants for the convolution kernel*/
     if (algo == 0) {
@@ -9555,9 +9533,8 @@ void ImProcFunctions::fftw_convol_blur(float * input, float * output, int bfw, i
         }
 
         /*compute the Fourier transform of the kernel data*/
-        pkern = fftwf_plan_r2r_2d(bfh, bfw, kern, outkern, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE); //FFT 2 dimensions forward
-        fftwf_execute(pkern);
-        fftwf_destroy_plan(pkern);
+        pkern = FftwPlanCache::r2r2d(bfh, bfw, kern, outkern, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE, multiThread); //FFT 2 dimensions forward
+        fftwf_execute_r2r(pkern, kern, outkern);
 
 #ifdef _OPENMP
         #pragma omp parallel for if (multiThread)
@@ -9604,8 +9581,8 @@ void ImProcFunctions::fftw_convol_blur(float * input, float * output, int bfw, i
         }
     }
 
-    p = fftwf_plan_r2r_2d(bfh, bfw, out, output, FFTW_REDFT01, FFTW_REDFT01, FFTW_ESTIMATE);//FFT 2 dimensions backward
-    fftwf_execute(p);
+    p = FftwPlanCache::r2r2d(bfh, bfw, out, output, FFTW_REDFT01, FFTW_REDFT01, FFTW_ESTIMATE, multiThread);//FFT 2 dimensions backward
+    fftwf_execute_r2r(p, out, output);
 
 #ifdef _OPENMP
     #pragma omp parallel for if (multiThread)
@@ -9615,22 +9592,11 @@ void ImProcFunctions::fftw_convol_blur(float * input, float * output, int bfw, i
         output[index] /= image_sizechange;
     }
 
-    fftwf_destroy_plan(p);
     fftwf_free(out);
-
-#ifdef RT_FFTW3F_OMP
-
-    if (multiThread) {
-        fftwf_cleanup_threads();
-    }
-
-#endif
 }
 
 void ImProcFunctions::fftw_convol_blur2(float **input2, float **output2, int bfw, int bfh, float radius, int fftkern, int algo)
 {
-    MyMutex::MyLock lock(*fftwMutex);
-
     float *input = nullptr;
 
     if (NULL == (input = (float *) fftwf_malloc(sizeof(float) * bfw * bfh))) {
@@ -9676,28 +9642,17 @@ void ImProcFunctions::fftw_tile_blur(int GW, int GH, int tilssize, int max_numbl
 {
     //BENCHFUN
     float epsil = 0.001f / (tilssize * tilssize);
-    fftwf_plan plan_forward_blox[2];
-    fftwf_plan plan_backward_blox[2];
+    FftwPlanCache::Plan plan_forward_blox[2];
+    FftwPlanCache::Plan plan_backward_blox[2];
 
     array2D<float> tilemask_in(tilssize, tilssize);
     array2D<float> tilemask_out(tilssize, tilssize);
 
-    float *Lbloxtmp  = reinterpret_cast<float*>(fftwf_malloc(max_numblox_W * tilssize * tilssize * sizeof(float)));
-    float *fLbloxtmp = reinterpret_cast<float*>(fftwf_malloc(max_numblox_W * tilssize * tilssize * sizeof(float)));
-
-    int nfwd[2] = {tilssize, tilssize};
-
-    //for DCT:
-    fftw_r2r_kind fwdkind[2] = {FFTW_REDFT10, FFTW_REDFT10};
-    fftw_r2r_kind bwdkind[2] = {FFTW_REDFT01, FFTW_REDFT01};
-
     // Creating the plans with FFTW_MEASURE instead of FFTW_ESTIMATE speeds up the execute a bit
-    plan_forward_blox[0]  = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, Lbloxtmp, nullptr, 1, tilssize * tilssize, fLbloxtmp, nullptr, 1, tilssize * tilssize, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    plan_backward_blox[0] = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, fLbloxtmp, nullptr, 1, tilssize * tilssize, Lbloxtmp, nullptr, 1, tilssize * tilssize, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    plan_forward_blox[1]  = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, Lbloxtmp, nullptr, 1, tilssize * tilssize, fLbloxtmp, nullptr, 1, tilssize * tilssize, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    plan_backward_blox[1] = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, fLbloxtmp, nullptr, 1, tilssize * tilssize, Lbloxtmp, nullptr, 1, tilssize * tilssize, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    fftwf_free(Lbloxtmp);
-    fftwf_free(fLbloxtmp);
+    plan_forward_blox[0]  = FftwPlanCache::r2r2dMany(tilssize, tilssize, max_numblox_W, FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+    plan_backward_blox[0] = FftwPlanCache::r2r2dMany(tilssize, tilssize, max_numblox_W, FFTW_REDFT01, FFTW_REDFT01, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+    plan_forward_blox[1]  = FftwPlanCache::r2r2dMany(tilssize, tilssize, min_numblox_W, FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+    plan_backward_blox[1] = FftwPlanCache::r2r2dMany(tilssize, tilssize, min_numblox_W, FFTW_REDFT01, FFTW_REDFT01, FFTW_MEASURE | FFTW_DESTROY_INPUT);
     const int border = rtengine::max(2, tilssize / 16);
 
     for (int i = 0; i < tilssize; ++i) {
@@ -9870,12 +9825,6 @@ void ImProcFunctions::fftw_tile_blur(int GW, int GH, int tilssize, int max_numbl
         fftwf_free(LbloxArray[i]);
         fftwf_free(fLbloxArray[i]);
     }
-
-    fftwf_destroy_plan(plan_forward_blox[0]);
-    fftwf_destroy_plan(plan_backward_blox[0]);
-    fftwf_destroy_plan(plan_forward_blox[1]);
-    fftwf_destroy_plan(plan_backward_blox[1]);
-    fftwf_cleanup();
 }
 
 void ImProcFunctions::wavcbd(wavelet_decomposition &wdspot, int level_bl, int maxlvl,
@@ -11121,29 +11070,19 @@ void ImProcFunctions::fftw_denoise(int sk, int GW, int GH, int max_numblox_W, in
 {
     // BENCHFUN
 
-    fftwf_plan plan_forward_blox[2];
-    fftwf_plan plan_backward_blox[2];
+    FftwPlanCache::Plan plan_forward_blox[2];
+    FftwPlanCache::Plan plan_backward_blox[2];
 
     array2D<float> tilemask_in(TS, TS);
     array2D<float> tilemask_out(TS, TS);
 
-    float *Lbloxtmp  = reinterpret_cast<float*>(fftwf_malloc(max_numblox_W * TS * TS * sizeof(float)));
-    float *fLbloxtmp = reinterpret_cast<float*>(fftwf_malloc(max_numblox_W * TS * TS * sizeof(float)));
     float params_Ldetail = 0.f;
 
-    int nfwd[2] = {TS, TS};
-
-    //for DCT:
-    fftw_r2r_kind fwdkind[2] = {FFTW_REDFT10, FFTW_REDFT10};
-    fftw_r2r_kind bwdkind[2] = {FFTW_REDFT01, FFTW_REDFT01};
-
     // Creating the plans with FFTW_MEASURE instead of FFTW_ESTIMATE speeds up the execute a bit
-    plan_forward_blox[0]  = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, Lbloxtmp, nullptr, 1, TS * TS, fLbloxtmp, nullptr, 1, TS * TS, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    plan_backward_blox[0] = fftwf_plan_many_r2r(2, nfwd, max_numblox_W, fLbloxtmp, nullptr, 1, TS * TS, Lbloxtmp, nullptr, 1, TS * TS, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    plan_forward_blox[1]  = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, Lbloxtmp, nullptr, 1, TS * TS, fLbloxtmp, nullptr, 1, TS * TS, fwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    plan_backward_blox[1] = fftwf_plan_many_r2r(2, nfwd, min_numblox_W, fLbloxtmp, nullptr, 1, TS * TS, Lbloxtmp, nullptr, 1, TS * TS, bwdkind, FFTW_MEASURE | FFTW_DESTROY_INPUT);
-    fftwf_free(Lbloxtmp);
-    fftwf_free(fLbloxtmp);
+    plan_forward_blox[0]  = FftwPlanCache::r2r2dMany(TS, TS, max_numblox_W, FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+    plan_backward_blox[0] = FftwPlanCache::r2r2dMany(TS, TS, max_numblox_W, FFTW_REDFT01, FFTW_REDFT01, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+    plan_forward_blox[1]  = FftwPlanCache::r2r2dMany(TS, TS, min_numblox_W, FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE | FFTW_DESTROY_INPUT);
+    plan_backward_blox[1] = FftwPlanCache::r2r2dMany(TS, TS, min_numblox_W, FFTW_REDFT01, FFTW_REDFT01, FFTW_MEASURE | FFTW_DESTROY_INPUT);
     const int border = rtengine::max(2, TS / 16);
 
     for (int i = 0; i < TS; ++i) {
@@ -11379,12 +11318,6 @@ void ImProcFunctions::fftw_denoise(int sk, int GW, int GH, int max_numblox_W, in
         fftwf_free(fLbloxArray[i]);
     }
 
-    fftwf_destroy_plan(plan_forward_blox[0]);
-    fftwf_destroy_plan(plan_backward_blox[0]);
-    fftwf_destroy_plan(plan_forward_blox[1]);
-    fftwf_destroy_plan(plan_backward_blox[1]);
-    fftwf_cleanup();
-
 
 }
 
@@ -11413,10 +11346,6 @@ void ImProcFunctions::DeNoise(int call, int aut,  bool noiscfactiv, const struct
 
         //StopWatch Stop1("locallab Denoise called");
 
-        if (aut == 0) {
-            MyMutex::MyLock lock(*fftwMutex);
-        }
-
         if (lp.noisecf >= 0.01f || lp.noisecc >= 0.01f || aut == 1 || aut == 2) {
             noiscfactiv = false;
             levred = 7;
@@ -13891,7 +13820,7 @@ void ImProcFunctions::Lab_Local(
     )
 {
     //general call of others functions : important return hueref, chromaref, lumaref
-    if (!params->locallab.enabled) {
+    if (!params->locallab.enabled || isCancelled()) {
         return;
     }
 
@@ -14981,7 +14910,7 @@ void ImProcFunctions::Lab_Local(
     }
 
 //local denoise
-    if (lp.activspot && lp.denoiena && (lp.noiself > 0.f || lp.noiself0 > 0.f || lp.noiself2 > 0.f || lp.wavcurvedenoi ||lp.nlstr > 0 || lp.noiselc > 0.f || lp.noisecf > 0.f || lp.noisecc > 0.f )) {//disable denoise if not used
+    if (lp.activspot && lp.denoiena && !isCancelled() && (lp.noiself > 0.f || lp.noiself0 > 0.f || lp.noiself2 > 0.f || lp.wavcurvedenoi ||lp.nlstr > 0 || lp.noiselc > 0.f || lp.noisecf > 0.f || lp.noisecc > 0.f )) {//disable denoise if not used
         constexpr int aut = 0;
         DeNoise(call, aut, noiscfactiv, lp, originalmaskbl.get(), bufmaskblurbl.get(), levred, huerefblur, lumarefblur, chromarefblur, original, transformed, cx, cy, sk, locwavCurvehue, locwavhueutili,
                 highresi, nresi, highresi46, nresi46, Lhighresi, Lnresi, Lhighresi46, Lnresi46);
@@ -15339,7 +15268,7 @@ void ImProcFunctions::Lab_Local(
 
     lp.invret = false;//always disabled inverse RETI   too complex todo !!
 
-    if (lp.str >= 0.2f && lp.retiena && call != 2) {
+    if (lp.str >= 0.2f && lp.retiena && call != 2 && !isCancelled()) {
         LabImage *bufreti = nullptr;
         LabImage *bufmask = nullptr;
         LabImage *buforig = nullptr;
@@ -15696,7 +15625,7 @@ void ImProcFunctions::Lab_Local(
 
 
 
-    if (lp.str >= 0.2f && lp.retiena && call == 2) {
+    if (lp.str >= 0.2f && lp.retiena && call == 2 && !isCancelled()) {
         int ystart = rtengine::max(static_cast<int>(lp.yc - lp.lyT) - cy, 0);
         int yend = rtengine::min(static_cast<int>(lp.yc + lp.ly) - cy, original->H);
         int xstart = rtengine::max(static_cast<int>(lp.xc - lp.lxL) - cx, 0);
@@ -16966,7 +16895,6 @@ void ImProcFunctions::Lab_Local(
                 }
 
                 const int showorig = lp.showmasksoftmet >= 5 ? 0 : lp.showmasksoftmet;
-                MyMutex::MyLock lock(*fftwMutex);
                 ImProcFunctions::retinex_pde(datain.get(), dataout.get(), bfwr, bfhr, 8.f * lp.strng, 1.f, dE.get(), showorig, 1, 1);
 #ifdef _OPENMP
                 #pragma omp parallel for schedule(dynamic,16) if (multiThread)
@@ -18111,7 +18039,6 @@ void ImProcFunctions::Lab_Local(
 
                         if (lp.laplacexp > 0.1f) {//don't use if an other spot use Dehaze.
                             //printf("EXEC ATTENUATOR\n");
-                            MyMutex::MyLock lock(*fftwMutex);
                             std::unique_ptr<float[]> datain(new float[bfwr * bfhr]);
                             std::unique_ptr<float[]> dataout(new float[bfwr * bfhr]);
                             const float gam = params->locallab.spots.at(sp).gamm;
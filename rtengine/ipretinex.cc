@@ -1265,7 +1265,7 @@ void ImProcFunctions::MSRLocal(int call, int sp, bool fftw, int lum, float** red
     float kr;//on FFTW
     float kg = 1.f;//on Gaussianblur
 
-    for (int scale = scal - 1; scale >= 0; --scale) {
+    for (int scale = scal - 1; scale >= 0 && !isCancelled(); --scale) {
         //    printf("retscale=%f scale=%i \n", mulradiusfftw * RetinexScales[scale], scale);
         //emprical adjustment between FFTW radius and Gaussainblur
         //under 50 ==> 10.f
@@ -883,6 +883,10 @@ void ImProcFunctions::ip_wavelet(LabImage * lab, LabImage * dst, int kall, const
 
         for (int tiletop = 0; tiletop < imheight; tiletop += tileHskip) {
             for (int tileleft = 0; tileleft < imwidth ; tileleft += tileWskip) {
+                if (isCancelled()) {
+                    continue;
+                }
+
                 int tileright = rtengine::min(imwidth, tileleft + tilewidth);
                 int tilebottom = rtengine::min(imheight, tiletop + tileheight);
                 int width  = tileright - tileleft;
@@ -1489,7 +1493,9 @@ void ImProcFunctions::ip_wavelet(LabImage * lab, LabImage * dst, int kall, const
                             Chutili = true;
                         }
 
-                        WaveletcontAllL(labco, varhue, varchro, *Ldecomp, wavblcurve, cp, skip, mean, sigma, MaxP, MaxN, wavCLVCcurve, waOpacityCurveW, waOpacityCurveSH, ChCurve, Chutili);
+                        if (!isCancelled()) {
+                            WaveletcontAllL(labco, varhue, varchro, *Ldecomp, wavblcurve, cp, skip, mean, sigma, MaxP, MaxN, wavCLVCcurve, waOpacityCurveW, waOpacityCurveSH, ChCurve, Chutili);
+                        }
 
                         if (cp.val > 0 || ref || contr  || cp.diagcurv) { //edge
                             Evaluate2(*Ldecomp, mean, meanN, sigma, sigmaN, MaxP, MaxN, wavNestedLevels);
@@ -1756,7 +1762,7 @@ void ImProcFunctions::ip_wavelet(LabImage * lab, LabImage * dst, int kall, const
                                 printf("Leval decomp a=%i\n", levwava);
                             }
 
-                            if (levwava > 0) {
+                            if (levwava > 0 && !isCancelled()) {
                                 const std::unique_ptr<wavelet_decomposition> adecomp(new wavelet_decomposition(labco->data + datalen, labco->W, labco->H, levwava, 1, skip, rtengine::max(1, wavNestedLevels), DaubLen));
                                 if (!adecomp->memory_allocation_failed()) {
                                     if(levwava == 6) {
@@ -1811,7 +1817,7 @@ void ImProcFunctions::ip_wavelet(LabImage * lab, LabImage * dst, int kall, const
                                 printf("Leval decomp b=%i\n", levwavb);
                             }
 
-                            if (levwavb > 0) {
+                            if (levwavb > 0 && !isCancelled()) {
                                 const std::unique_ptr<wavelet_decomposition> bdecomp(new wavelet_decomposition(labco->data + 2 * datalen, labco->W, labco->H, levwavb, 1, skip, rtengine::max(1, wavNestedLevels), DaubLen));
                                 if(levwavb == 6) {
                                     edge = 1;
@@ -0,0 +1,46 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with -mavx2, see rtengine/CMakeLists.txt
+#include <immintrin.h>
+
+#include "lut_wide.h"
+
+namespace rtengine
+{
+
+// Same operations, in the same order, as LUTf::operator[](vfloat): the indexes are clamped
+// with vclampf() (NaN gives 0), truncated, and the two neighbours are interpolated with vintpf()
+void lutLookupAvx2(const float* data, int maxs, int upperBound, const float* src, float* dst, int n)
+{
+    const __m256 zerov = _mm256_setzero_ps();
+    const __m256 maxsv = _mm256_set1_ps(maxs);
+    const __m256 sizev = _mm256_set1_ps(upperBound);
+
+    for (int i = 0; i < n; i += LUT_AVX2_LANES) {
+        const __m256 indexv = _mm256_loadu_ps(src + i);
+        const __m256i indexes = _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(maxsv, indexv), zerov));
+        const __m256 lowerVal = _mm256_i32gather_ps(data, indexes, 4);
+        const __m256 upperVal = _mm256_i32gather_ps(data + 1, indexes, 4);
+        const __m256 diff = _mm256_max_ps(_mm256_min_ps(sizev, indexv), zerov) - _mm256_cvtepi32_ps(indexes);
+        _mm256_storeu_ps(dst + i, diff * (upperVal - lowerVal) + lowerVal);
+    }
+}
+
+}
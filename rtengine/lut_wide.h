@@ -0,0 +1,33 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+namespace rtengine
+{
+
+// Wide vector variants of lookupRow() (see lutrow.h), compiled with -mavx2 resp. -mavx512f.
+// They must only be called if getSimdLevel() reports support for the instruction set.
+// n has to be a multiple of LUT_AVX2_LANES resp. LUT_AVX512_LANES.
+constexpr int LUT_AVX2_LANES = 8;
+constexpr int LUT_AVX512_LANES = 16;
+
+void lutLookupAvx2(const float* data, int maxs, int upperBound, const float* src, float* dst, int n);
+void lutLookupAvx512(const float* data, int maxs, int upperBound, const float* src, float* dst, int n);
+
+}
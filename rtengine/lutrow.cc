@@ -0,0 +1,67 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "lutrow.h"
+
+#include "cpudispatch.h"
+#include "lut_wide.h"
+#include "opthelper.h"
+
+namespace rtengine
+{
+
+void lookupRow(const LUTf& lut, const float* src, float* dst, int n)
+{
+    int i = 0;
+
+#ifdef RT_CPU_DISPATCH
+    const float* const data = &lut[0];
+    const int maxs = lut.getSize() - 2;
+    const int upperBound = lut.getUpperBound();
+
+    switch (getSimdLevel()) {
+        case SimdLevel::AVX512: {
+            i = n - n % LUT_AVX512_LANES;
+            lutLookupAvx512(data, maxs, upperBound, src, dst, i);
+            break;
+        }
+
+        case SimdLevel::AVX2: {
+            i = n - n % LUT_AVX2_LANES;
+            lutLookupAvx2(data, maxs, upperBound, src, dst, i);
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
+#endif
+
+#ifdef __SSE2__
+    for (; i < n - 3; i += 4) {
+        STVFU(dst[i], lut[LVFU(src[i])]);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+}
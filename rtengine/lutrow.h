@@ -0,0 +1,32 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "LUT.h"
+
+namespace rtengine
+{
+
+// Sets dst[i] = lut[src[i]] for i in [0, n), with the same results as the SSE2 loops over lut[LVFU(src[i])]
+// followed by the scalar lookups of the remainder. The lut has to clip at both bounds (the default).
+// Uses the gather instructions of AVX2 or AVX-512 if the processor supports them, see cpudispatch.h.
+// src and dst may be the same.
+void lookupRow(const LUTf& lut, const float* src, float* dst, int n);
+
+}
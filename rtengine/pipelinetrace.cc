@@ -0,0 +1,164 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cstdio>
+
+#include <glib/gstdio.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define RT_TRACE_HEAP
+#endif
+
+#include "pipelinetrace.h"
+#include "settings.h"
+#include "rtgui/threadutils.h"
+
+namespace
+{
+
+MyMutex traceMutex;
+FILE* traceFile = nullptr;
+bool firstEvent = true;
+
+std::int64_t now()
+{
+    // the time origin doesn't matter, the viewers display relative times
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Bytes currently allocated on the heap by the whole process, if the C library can tell.
+// mallinfo2() walks all the malloc arenas, so it is only called in verbose mode.
+std::int64_t heapInUse()
+{
+#ifdef RT_TRACE_HEAP
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Small sequential thread ids are easier to read in the viewers than the native ones
+int threadId()
+{
+    static std::atomic<int> nextId(1);
+    thread_local int id = nextId++;
+    return id;
+}
+
+}
+
+namespace rtengine
+{
+
+std::atomic<bool> PipelineTrace::enabled(false);
+
+bool PipelineTrace::open(const Glib::ustring& fname)
+{
+    close();
+
+    MyMutex::MyLock lock(traceMutex);
+
+    traceFile = g_fopen(fname.c_str(), "wb");
+
+    if (!traceFile) {
+        fprintf(stderr, "Could not open the trace file \"%s\"\n", fname.c_str());
+        return false;
+    }
+
+    fputs("[\n", traceFile);
+    firstEvent = true;
+    enabled = true;
+    return true;
+}
+
+void PipelineTrace::close()
+{
+    MyMutex::MyLock lock(traceMutex);
+
+    enabled = false;
+
+    if (traceFile) {
+        fputs("\n]\n", traceFile);
+        fclose(traceFile);
+        traceFile = nullptr;
+    }
+}
+
+void PipelineTrace::flush()
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    MyMutex::MyLock lock(traceMutex);
+
+    if (traceFile) {
+        fflush(traceFile);
+    }
+}
+
+PipelineTrace::Scope::Scope(const char* category, const char* name, int width, int height) :
+    category(category),
+    name(name),
+    width(width),
+    height(height),
+    active(isEnabled()),
+    sampleHeap(active && settings->verbose),
+    start(active ? now() : 0),
+    startHeap(sampleHeap ? heapInUse() : 0)
+{
+}
+
+PipelineTrace::Scope::~Scope()
+{
+    if (!active) {
+        return;
+    }
+
+    const std::int64_t end = now();
+    const std::int64_t heap = sampleHeap ? heapInUse() : 0;
+    const int tid = threadId();
+
+    MyMutex::MyLock lock(traceMutex);
+
+    if (!traceFile) {
+        return;
+    }
+
+    fprintf(traceFile,
+            "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"args\":{\"width\":%d,\"height\":%d",
+            firstEvent ? "" : ",\n", name, category, tid, static_cast<long long>(start), static_cast<long long>(end - start), width, height);
+
+    if (sampleHeap) {
+        fprintf(traceFile, ",\"process_heap_delta\":%lld", static_cast<long long>(heap - startHeap));
+    }
+
+    fputs("}}", traceFile);
+    firstEvent = false;
+}
+
+void PipelineTrace::Scope::setSize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <glibmm/ustring.h>
+
+namespace rtengine
+{
+
+/**
+ * Records the duration of the processing stages and writes them to a file in the Chrome trace event format,
+ * to be opened with chrome://tracing or https://ui.perfetto.dev
+ *
+ * Tracing is off until a trace file is opened, either with the PipelineTraceFile option or with the -T switch
+ * of the command line interface. A Scope costs a single atomic load when tracing is off.
+ *
+ * In verbose mode, the events also carry process_heap_delta: the change of the heap in use by the whole process
+ * during the scope. Other threads, e.g. the concurrent jobs of the batch queue, contribute to it, so it is only
+ * meaningful when a single job is running.
+ */
+class PipelineTrace
+{
+public:
+    /** Starts recording to the given file, replacing the trace being recorded if any.
+      * @return true on success */
+    static bool open(const Glib::ustring& fname);
+    /** Terminates the trace file and stops recording */
+    static void close();
+    /** Flushes the recorded events to the disk, e.g. at the end of a processing job */
+    static void flush();
+
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /** Records one complete event, from its construction to its destruction. The name and category
+      * must be string literals as they are only written at the end of the scope. */
+    class Scope
+    {
+    public:
+        Scope(const char* category, const char* name, int width = 0, int height = 0);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        /** Sets the image dimensions reported with the event, when they are only known later */
+        void setSize(int width, int height);
+
+    private:
+        const char* const category;
+        const char* const name;
+        int width;
+        int height;
+        const bool active;
+        const bool sampleHeap;
+        std::int64_t start;
+        std::int64_t startHeap;
+    };
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+}
@@ -6,6 +6,8 @@
  *  Created on: 20/nov/2010
  */
 
+#include <algorithm>
+#include <atomic>
 #include <strings.h>
 #ifdef _WIN32
 #include <winsock2.h>
@@ -15,6 +17,10 @@
 
 #include <libraw/libraw.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "image8.h"
 #include "rawimage.h"
 #include "settings.h"
@@ -22,11 +28,44 @@
 #include "utils.h"
 #include "rtengine.h"
 
-namespace rtengine
+namespace
 {
 
+#ifdef LIBRAW_USE_OPENMP
+// LibRaw instances don't share any mutable state (its memory manager uses an omp critical section), so several
+// raws can be decoded at the same time. Each concurrent decode gets an equal share of the cores for the OpenMP
+// regions of LibRaw, instead of every decode starting a full team and oversubscribing the machine.
+class LibrawThreadBudget
+{
+public:
+    LibrawThreadBudget() :
+        previous(omp_get_max_threads())
+    {
+        const int decodes = ++activeDecodes;
+        omp_set_num_threads(std::max(1, previous / decodes));
+    }
+
+    ~LibrawThreadBudget()
+    {
+        --activeDecodes;
+        omp_set_num_threads(previous);
+    }
+
+    LibrawThreadBudget(const LibrawThreadBudget&) = delete;
+    LibrawThreadBudget& operator =(const LibrawThreadBudget&) = delete;
 
-extern MyMutex *librawMutex;
+private:
+    const int previous;
+    static std::atomic<int> activeDecodes;
+};
+
+std::atomic<int> LibrawThreadBudget::activeDecodes{0};
+#endif
+
+}
+
+namespace rtengine
+{
 
 
 RawImage::RawImage(const Glib::ustring &name)
@@ -63,10 +102,7 @@ RawImage::~RawImage()
         allocation = nullptr;
     }
 
-    if (float_raw_image) {
-        delete [] float_raw_image;
-        float_raw_image = nullptr;
-    }
+    free_float_raw_image();
 
     if (data) {
         delete [] data;
@@ -494,6 +530,7 @@ int RawImage::loadRaw(bool loadData, unsigned int imageNum, bool closeFile, Prog
     shot_select = imageNum;
 
     if (settings->enableLibRaw) {
+        free_float_raw_image();
         libraw.reset(new LibRaw());
     }
     int libraw_error = [&]() -> int {
@@ -790,12 +827,10 @@ int RawImage::loadRaw(bool loadData, unsigned int imageNum, bool closeFile, Prog
             if (err) {
                 return err;
             }
-            {
 #ifdef LIBRAW_USE_OPENMP
-                MyMutex::MyLock lock(*librawMutex);
+            LibrawThreadBudget threadBudget;
 #endif
-                err = libraw->unpack();
-            }
+            err = libraw->unpack();
             if (err) {
                 return err;
             }
@@ -803,17 +838,10 @@ int RawImage::loadRaw(bool loadData, unsigned int imageNum, bool closeFile, Prog
             auto &rd = libraw->imgdata.rawdata;
             raw_image = rd.raw_image;
             if (rd.float_image) {
-                float_raw_image = new float[raw_width * raw_height];
-                for (int y = 0; y < raw_height; ++y) {
-                    for (int x = 0; x < raw_width; ++x) {
-                        size_t idx = y * raw_width + x;
-                        float_raw_image[idx] = rd.float_image[idx];
-                    }
-                }
+                // no copy, the buffer stays owned by LibRaw until compress_image() has read it
+                float_raw_image = rd.float_image;
+                float_raw_image_from_libraw = true;
             } else {
-#ifdef LIBRAW_USE_OPENMP
-                MyMutex::MyLock lock(*librawMutex);
-#endif
                 float_raw_image = nullptr;
                 err = libraw->raw2image();
                 if (err) {
@@ -1149,8 +1177,7 @@ float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
                 this->data[row][col] = float_raw_image[(row + top_margin) * raw_width + col + left_margin];
             }
 
-        delete [] float_raw_image;
-        float_raw_image = nullptr;
+        free_float_raw_image();
     } else if (merged_pixelshift.is_merged_pixelshift) {
         // Frame 0 is not shifted. Frame 1 is shifted down. Frame 2 is shifted
         // down and right. Frame 3 is shifted right.
@@ -1245,6 +1272,16 @@ float** RawImage::compress_image(unsigned int frameNum, bool freeImage)
     return data;
 }
 
+void RawImage::free_float_raw_image()
+{
+    if (!float_raw_image_from_libraw) {
+        delete [] float_raw_image;
+    }
+
+    float_raw_image = nullptr;
+    float_raw_image_from_libraw = false;
+}
+
 bool
 RawImage::is_supportedThumb() const
 {
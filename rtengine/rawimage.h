@@ -78,6 +78,8 @@ protected:
     int maximum_c4[4];
     Decoder decoder{Decoder::DCRAW};
     std::unique_ptr<LibRaw> libraw;
+    bool float_raw_image_from_libraw{false}; // float_raw_image is LibRaw's buffer, released by LibRaw::recycle()
+    void free_float_raw_image();
     bool isFoveon() const
     {
         return is_foveon;
@@ -6868,9 +6868,13 @@ void RawImageSource::ItcWB(bool extra, double &tempref, double &greenref, double
 
         float minstud = 100000.f;
         int goodref = 1;
+        std::vector<float> abstuds(N_t); // the temperatures are independent: the correlations are computed in parallel, then compared in order
 
 //calculate  x y z for each pixel with multiplier rmm gmm bmm
 
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
         for (int tt = ttbeg; tt < ttend; ++tt) {//N_t
             for (int i = 0; i < w; ++i) {
                 float unused;
@@ -6897,10 +6901,12 @@ void RawImageSource::ItcWB(bool extra, double &tempref, double &greenref, double
                 }
             }
 
-            const float abstud = std::fabs(studentXY(xxyycurr_reduc, reff_spect_xxyy, 2 * w, 2 * (kk + 1), tt));
+            abstuds[tt] = std::fabs(studentXY(xxyycurr_reduc, reff_spect_xxyy, 2 * w, 2 * (kk + 1), tt));
+        }
 
-            if (abstud < minstud) {  // find the minimum Student
-                minstud = abstud;
+        for (int tt = ttbeg; tt < ttend; ++tt) {
+            if (abstuds[tt] < minstud) {  // find the minimum Student
+                minstud = abstuds[tt];
                 goodref = tt;
             }
         }
@@ -6951,6 +6957,9 @@ void RawImageSource::ItcWB(bool extra, double &tempref, double &greenref, double
                 float minstudgr = 100000.f;
                 goodrefgr = 1;
 
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic)
+#endif
                 for (int tt = scantempbeg; tt < scantempend; ++tt) {
                     double r, g, b;
 
@@ -6975,10 +6984,7 @@ void RawImageSource::ItcWB(bool extra, double &tempref, double &greenref, double
                     rmm[tt] = rm / gm;
                     gmm[tt] = 1.f;
                     bmm[tt] = bm / gm;
-                }
-
 
-                for (int tt = scantempbeg; tt < scantempend; ++tt) {//N_t
                     for (int i = 0; i < w; ++i) {
                         float unused;
 
@@ -7007,10 +7013,12 @@ void RawImageSource::ItcWB(bool extra, double &tempref, double &greenref, double
 
                     //now we have good spectral data
                     //calculate student correlation
-                    const float abstudgr = std::fabs(studentXY(xxyycurr_reduc, reff_spect_xxyy, 2 * w, 2 * (kkg + 1), tt));
+                    abstuds[tt] = std::fabs(studentXY(xxyycurr_reduc, reff_spect_xxyy, 2 * w, 2 * (kkg + 1), tt));
+                }
 
-                    if (abstudgr < minstudgr) {  // find the minimum Student
-                        minstudgr = abstudgr;
+                for (int tt = scantempbeg; tt < scantempend; ++tt) {
+                    if (abstuds[tt] < minstudgr) {  // find the minimum Student
+                        minstudgr = abstuds[tt];
                         goodrefgr = tt;
                     }
 
@@ -24,6 +24,7 @@
 #include <ctime>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include <glibmm/ustring.h>
 
@@ -260,7 +261,9 @@ class DetailedCropListener
 public:
     virtual ~DetailedCropListener() = default;
     /** With this member function the staged processor notifies the listener that the detailed crop image has been updated.
-      * @param img is a pointer to the detailed crop image */
+      * @param img is a pointer to the detailed crop image
+      * @param skip can be larger than the one given by getWindow: the image is then a subsampled version of the window,
+      * shown while its full quality version is being computed */
     virtual void setDetailedCrop(
         IImage8* img,
         IImage8* imgtrue,
@@ -800,6 +803,15 @@ public:
    * @return the resulting image, with the output profile applied, exif and iptc data set. You have to save it or you can access the pixel data directly.  */
 IImagefloat* processImage (ProcessingJob* job, int& errorCode, ProgressListener* pl = nullptr, bool flush = false);
 
+/** This function performs the image processing steps of several ProcessingJobs created from the same InitialImage.
+   * The image is preprocessed and demosaiced only once as long as the raw related parameters of the jobs match, only the downstream steps run per job.
+   * The ProcessingJobs passed become invalid, you can not use them any more.
+   * @param jobs the ProcessingJobs to perform, all of them created from the same InitialImage
+   * @param errorCodes receives the error code of each job
+   * @param pl is an optional ProgressListener if you want to keep track of the progress
+   * @return the resulting images in the order of the jobs, nullptr for the jobs which failed */
+std::vector<IImagefloat*> processImages (const std::vector<ProcessingJob*>& jobs, std::vector<int>& errorCodes, ProgressListener* pl = nullptr, bool flush = false);
+
 /** This class is used to control the batch processing. The class implementing this interface will be called when the full processing of an
    * image is ready and the next job to process is needed. */
 class BatchProcessingListener : public ProgressListener
@@ -52,6 +52,17 @@ public:
     Glib::ustring   cameraProfilesPath;     ///< The default directory for camera profiles
     Glib::ustring   lensProfilesPath;       ///< The default directory for lens profiles
     bool            enableLibRaw;           ///< Use LibRaw to decode raw images.
+    Glib::ustring   pipelineTraceFile;      ///< When not empty, the processing stages are recorded to this file in the Chrome trace format
+    Glib::ustring   fftwWisdomFile;         ///< The FFTW wisdom is loaded from and saved to this file, in the cache directory
+    int             exportMemoryBudget;     ///< In MiB; when the end of the export pipeline does not fit, the pixel-wise tools run on strips. 0 = no limit
+    int             bufferPoolSize;         ///< In MiB; maximum amount of released image buffers kept for reuse, emptied when the batch queue stops. 0 = no pooling
+    bool            pyramidBlur;            ///< Local contrast blurs large radii on a downsampled copy. Faster, but deviates slightly from the exact blur
+    int             progressivePreview;     ///< In kilopixels; larger detail crops are first shown subsampled to this size. 0 = no progressive refinement
+    int             tiffCompression;        ///< Codec of the compressed TIFF files: 0 = deflate, 1 = LZW
+    bool            tiffPredictor;          ///< Apply the horizontal or floating point predictor before compressing TIFF files
+    int             pngFilter;              ///< Filter of the rows of PNG files: 0 = none, 1 = sub, 2 = up, 3 = average, 4 = Paeth, 5 = adaptive
+    int             pngCompression;         ///< zlib compression level of PNG files (0-9), only used by the default and filtered strategies
+    int             pngStrategy;            ///< zlib strategy of PNG files: 0 = default, 1 = filtered, 2 = Huffman only, 3 = RLE
 
     Glib::ustring   adobe;                  // filename of AdobeRGB1998 profile (default to the bundled one)
     Glib::ustring   prophoto;               // filename of Prophoto     profile (default to the bundled one)
@@ -17,6 +17,10 @@
  *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
 #include <glibmm/thread.h>
 #include <glibmm/ustring.h>
 
@@ -34,6 +38,7 @@
 #include "labimage.h"
 #include "metadata.h"
 #include "mytime.h"
+#include "pipelinetrace.h"
 #include "processingjob.h"
 #include "procparams.h"
 #include "rawimagesource.h"
@@ -59,6 +64,78 @@ void adjust_radius(const T &default_param, double scale_factor, T &param)
 }
 
 
+/* Describes which parameters produced the demosaiced data currently held by an image source,
+ * so that several jobs sharing the same InitialImage can skip preprocessing and demosaicing. */
+class DemosaicState
+{
+public:
+    DemosaicState() :
+        valid(false),
+        prepareDenoise(false),
+        rgbSourceModified(false)
+    {
+    }
+
+    bool matches(const procparams::ProcParams& params) const
+    {
+        if (!valid
+            || raw != params.raw
+            || lensProf != params.lensProf
+            || coarse != params.coarse
+            || pdsharpening != params.pdsharpening
+            || prepareDenoise != params.dirpyrDenoise.enabled) {
+            return false;
+        }
+
+        // Color propagation and inpaint opposed highlight reconstructions alter the demosaiced data in place,
+        // the latter depending on the white balance
+        return !rgbSourceModified
+            || (highlights.hrenabled == params.toneCurve.hrenabled
+                && highlights.method == params.toneCurve.method
+                && highlights.hlbl == params.toneCurve.hlbl
+                && highlights.hlth == params.toneCurve.hlth
+                && (highlights.method != "Coloropp" || highlightsWB == params.wb));
+    }
+
+    void set(const procparams::ProcParams& params)
+    {
+        valid = true;
+        raw = params.raw;
+        lensProf = params.lensProf;
+        coarse = params.coarse;
+        pdsharpening = params.pdsharpening;
+        prepareDenoise = params.dirpyrDenoise.enabled;
+        rgbSourceModified = false;
+    }
+
+    void setSourceModified(const procparams::ToneCurveParams& toneCurve, const procparams::WBParams& wb, bool modified)
+    {
+        if (modified && !rgbSourceModified) {
+            highlights = toneCurve;
+            highlightsWB = wb;
+        }
+
+        rgbSourceModified = modified;
+    }
+
+    void invalidate()
+    {
+        valid = false;
+    }
+
+private:
+    bool valid;
+    procparams::RAWParams raw;
+    procparams::LensProfParams lensProf;
+    procparams::CoarseTransformParams coarse;
+    procparams::CaptureSharpeningParams pdsharpening;
+    bool prepareDenoise;
+    bool rgbSourceModified;
+    procparams::ToneCurveParams highlights;
+    procparams::WBParams highlightsWB;
+};
+
+
 class ImageProcessor
 {
 public:
@@ -66,12 +143,16 @@ public:
         ProcessingJob* pjob,
         int& errorCode,
         ProgressListener* pl,
-        bool flush
+        bool flush,
+        DemosaicState* demosaicState = nullptr,
+        bool keepSource = false
     ) :
         job(static_cast<ProcessingJobImpl*>(pjob)),
         errorCode(errorCode),
         pl(pl),
         flush(flush),
+        demosaicState(demosaicState),
+        keepSource(keepSource),
         // internal state
         initialImage(nullptr),
         imgsrc(nullptr),
@@ -110,11 +191,14 @@ public:
 
     Imagefloat *operator()()
     {
-        if (!job->fast) {
-            return normal_pipeline();
-        } else {
-            return fast_pipeline();
+        PipelineTrace::Scope trace("export", "processImage");
+        Imagefloat* const result = job->fast ? fast_pipeline() : normal_pipeline();
+
+        if (result) {
+            trace.setSize(result->getWidth(), result->getHeight());
         }
+
+        return result;
     }
 
 private:
@@ -149,6 +233,7 @@ private:
 
     bool stage_init()
     {
+        PipelineTrace::Scope trace("export", "init");
         errorCode = 0;
 
         if (pl) {
@@ -159,6 +244,7 @@ private:
         initialImage = job->initialImage;
 
         if (!initialImage) {
+            PipelineTrace::Scope loadTrace("export", "load");
             initialImage = InitialImage::load(job->fname, job->isRaw, &errorCode);
 
             if (errorCode) {
@@ -185,6 +271,7 @@ private:
         }
 
         imgsrc->getFullSize(fw, fh, tr);
+        trace.setSize(fw, fh);
 
         // check the crop params
         if (params.crop.x > fw || params.crop.y > fh) {
@@ -222,22 +309,40 @@ private:
         ImProcFunctions &ipf = * (ipf_p.get());
 
         imgsrc->setCurrentFrame(params.raw.bayersensor.imageNum);
-        float reddeha = 0.f;
-        float greendeha = 0.f;
-        float bluedeha = 0.f;
-        imgsrc->preprocess(params.raw, params.lensProf, params.coarse, reddeha, greendeha, bluedeha, params.dirpyrDenoise.enabled);
 
-        if (pl) {
-            pl->setProgress(0.20);
-        }
+        if (demosaicState && demosaicState->matches(params)) {
+            if (settings->verbose) {
+                printf("Reusing preprocessed and demosaiced data\n");
+            }
+        } else {
+            float reddeha = 0.f;
+            float greendeha = 0.f;
+            float bluedeha = 0.f;
+            {
+                PipelineTrace::Scope stageTrace("export", "preprocess", fw, fh);
+                imgsrc->preprocess(params.raw, params.lensProf, params.coarse, reddeha, greendeha, bluedeha, params.dirpyrDenoise.enabled);
+            }
 
-        bool autoContrast = imgsrc->getSensorType() == ST_BAYER ? params.raw.bayersensor.dualDemosaicAutoContrast : params.raw.xtranssensor.dualDemosaicAutoContrast;
-        double contrastThreshold = imgsrc->getSensorType() == ST_BAYER ? params.raw.bayersensor.dualDemosaicContrast : params.raw.xtranssensor.dualDemosaicContrast;
+            if (pl) {
+                pl->setProgress(0.20);
+            }
+
+            bool autoContrast = imgsrc->getSensorType() == ST_BAYER ? params.raw.bayersensor.dualDemosaicAutoContrast : params.raw.xtranssensor.dualDemosaicAutoContrast;
+            double contrastThreshold = imgsrc->getSensorType() == ST_BAYER ? params.raw.bayersensor.dualDemosaicContrast : params.raw.xtranssensor.dualDemosaicContrast;
 
-        imgsrc->demosaic(params.raw, autoContrast, contrastThreshold, params.pdsharpening.enabled && pl);
+            {
+                PipelineTrace::Scope stageTrace("export", "demosaic", fw, fh);
+                imgsrc->demosaic(params.raw, autoContrast, contrastThreshold, params.pdsharpening.enabled && pl);
+            }
 
-        if (params.pdsharpening.enabled) {
-            imgsrc->captureSharpening(params.pdsharpening, false, params.pdsharpening.contrast, params.pdsharpening.deconvradius);
+            if (params.pdsharpening.enabled) {
+                PipelineTrace::Scope stageTrace("export", "captureSharpening", fw, fh);
+                imgsrc->captureSharpening(params.pdsharpening, false, params.pdsharpening.contrast, params.pdsharpening.deconvradius);
+            }
+
+            if (demosaicState) {
+                demosaicState->set(params);
+            }
         }
 
 
@@ -248,6 +353,7 @@ private:
         pp = PreviewProps(0, 0, fw, fh, 1);
 
         if (params.retinex.enabled) { //enabled Retinex
+            PipelineTrace::Scope stageTrace("export", "retinex", fw, fh);
             LUTf cdcurve(65536, 0);
             LUTf mapcurve(65536, 0);
             RetinextransmissionCurve dehatransmissionCurve;
@@ -260,6 +366,11 @@ private:
             imgsrc->retinexPrepareCurves(params.retinex, cdcurve, mapcurve, dehatransmissionCurve, dehagaintransmissionCurve, dehacontlutili, mapcontlutili, useHsl, dummy, dummy);
             float minCD, maxCD, mini, maxi, Tmean, Tsigma, Tmin, Tmax;
             imgsrc->retinex(params.icm, params.retinex, params.toneCurve, cdcurve, mapcurve, dehatransmissionCurve, dehagaintransmissionCurve, conversionBuffer, dehacontlutili, mapcontlutili, useHsl, minCD, maxCD, mini, maxi, Tmean, Tsigma, Tmin, Tmax, dummy);
+
+            if (demosaicState) {
+                // retinex works in place on the demosaiced data
+                demosaicState->invalidate();
+            }
         }
 
         if (pl) {
@@ -831,8 +942,11 @@ private:
             //end evaluate noise
         }
 
-        baseImg = new Imagefloat(fw, fh);
-        imgsrc->getImage(currWB, tr, baseImg, pp, params.toneCurve, params.raw);
+        {
+            PipelineTrace::Scope stageTrace("export", "getImage", fw, fh);
+            baseImg = new Imagefloat(fw, fh);
+            imgsrc->getImage(currWB, tr, baseImg, pp, params.toneCurve, params.raw);
+        }
 
         if (pl) {
             pl->setProgress(0.50);
@@ -874,13 +988,18 @@ private:
 
         // Spot Removal
         if (params.spot.enabled && !params.spot.entries.empty()) {
+            PipelineTrace::Scope stageTrace("export", "removeSpots", fw, fh);
             ipf.removeSpots(baseImg, imgsrc, params.spot.entries, pp, currWB, nullptr, tr);
         }
 
+        if (demosaicState) {
+            demosaicState->setSourceModified(params.toneCurve, params.wb, imgsrc->isRGBSourceModified());
+        }
+
         // at this stage, we can flush the raw data to free up quite an important amount of memory
         // commented out because it makes the application crash when batch processing...
         // TODO: find a better place to flush rawData and rawRGB
-        if (flush) {
+        if (flush && !keepSource) {
             imgsrc->flush();
         }
 
@@ -889,6 +1008,7 @@ private:
 
     void stage_denoise()
     {
+        PipelineTrace::Scope trace("export", "denoise", fw, fh);
         const procparams::ProcParams& params = job->pparams;
 
         DirPyrDenoiseParams denoiseParams = params.dirpyrDenoise;   // make a copy because we cheat here
@@ -944,6 +1064,7 @@ private:
 
     void stage_transform()
     {
+        PipelineTrace::Scope trace("export", "transform", fw, fh);
         const procparams::ProcParams& params = job->pparams;
         //ImProcFunctions ipf (&params, true);
         ImProcFunctions &ipf = * (ipf_p.get());
@@ -976,11 +1097,19 @@ private:
         ipf.firstAnalysis(baseImg, params, hist16);
 
 
-        ipf.dehaze(baseImg, params.dehaze);
-        ipf.ToneMapFattal02(baseImg, params.fattal, 3, 0, nullptr, 0, 0, 0, false);
+        if (params.dehaze.enabled) {
+            PipelineTrace::Scope stageTrace("export", "dehaze", fw, fh);
+            ipf.dehaze(baseImg, params.dehaze);
+        }
+
+        if (params.fattal.enabled) {
+            PipelineTrace::Scope stageTrace("export", "ToneMapFattal02", fw, fh);
+            ipf.ToneMapFattal02(baseImg, params.fattal, 3, 0, nullptr, 0, 0, 0, false);
+        }
 
         // perform transform (excepted resizing)
         if (ipf.needsTransform(fw, fh, imgsrc->getRotateDegree(), imgsrc->getMetaData())) {
+            PipelineTrace::Scope stageTrace("export", "geometry", fw, fh);
             Imagefloat* trImg = nullptr;
 
             if (ipf.needsLuminanceOnly()) {
@@ -1001,6 +1130,7 @@ private:
 
     Imagefloat *stage_finish()
     {
+        PipelineTrace::Scope trace("export", "finish", fw, fh);
         procparams::ProcParams& params = job->pparams;
         //ImProcFunctions ipf (&params, true);
         ImProcFunctions &ipf = * (ipf_p.get());
@@ -1038,9 +1168,9 @@ private:
 
         // RGB processing
 
-        labView = new LabImage(fw, fh);
-
         if (params.locallab.enabled && params.locallab.spots.size() > 0) {
+            PipelineTrace::Scope stageTrace("export", "locallab", fw, fh);
+            labView = new LabImage(fw, fh);
             ipf.rgb2lab(*baseImg, *labView, params.icm.workingProfile);
 
             MyTime t1, t2;
@@ -1444,16 +1574,30 @@ private:
         DCPProfileApplyState as;
         DCPProfile *dcpProf = imgsrc->getDCP(params.icm, as);
 
+        const int stripHeight = exportStripHeight();
+
+        if (stripHeight > 0) {
+            return stage_finish_strips(stripHeight, satLimit, satLimitOpacity, opautili, dcpProf, as);
+        }
+
+        if (!labView) {
+            labView = new LabImage(fw, fh);
+        }
+
         LUTu histToneCurve;
 
-        ipf.rgbProc(baseImg, labView, nullptr, curve1, curve2, curve, params.toneCurve.saturation, rCurve, gCurve, bCurve, satLimit, satLimitOpacity, ctColorCurve, ctOpacityCurve, opautili, clToningcurve, cl2Toningcurve, customToneCurve1, customToneCurve2, customToneCurvebw1, customToneCurvebw2, rrm, ggm, bbm, autor, autog, autob, expcomp, hlcompr, hlcomprthresh, dcpProf, as, histToneCurve, options.chunkSizeRGB, options.measure);
+        {
+            PipelineTrace::Scope stageTrace("export", "rgbProc", fw, fh);
+            ipf.rgbProc(baseImg, labView, nullptr, curve1, curve2, curve, params.toneCurve.saturation, rCurve, gCurve, bCurve, satLimit, satLimitOpacity, ctColorCurve, ctOpacityCurve, opautili, clToningcurve, cl2Toningcurve, customToneCurve1, customToneCurve2, customToneCurvebw1, customToneCurvebw2, rrm, ggm, bbm, autor, autog, autob, expcomp, hlcompr, hlcomprthresh, dcpProf, as, histToneCurve, options.chunkSizeRGB, options.measure);
+        }
 
         if (settings->verbose) {
             printf("Output image / Auto B&W coefs:   R=%.2f   G=%.2f   B=%.2f\n", static_cast<double>(autor), static_cast<double>(autog), static_cast<double>(autob));
         }
 
         // if clut was used and size of clut cache == 1 we free the memory used by the clutstore (default clut cache size = 1 for 32 bit OS)
-        if (params.filmSimulation.enabled && !params.filmSimulation.clutFilename.empty() && options.clutCacheSize == 1) {
+        // The batch queue preloads the CLUT of its jobs and clears the cache itself when it stops
+        if (params.filmSimulation.enabled && !params.filmSimulation.clutFilename.empty() && options.clutCacheSize == 1 && !CLUTStore::getInstance().isPreloaded(params.filmSimulation.clutFilename)) {
             CLUTStore::getInstance().clearCache();
         }
 
@@ -1507,14 +1651,8 @@ private:
             }
         }
 
-        bool utili;
-        CurveFactory::complexLCurve(params.labCurve.brightness, params.labCurve.contrast, params.labCurve.lcurve, hist16, lumacurve, dummy, 1, utili);
-
-        const bool clcutili = CurveFactory::diagonalCurve2Lut(params.labCurve.clcurve, clcurve, 1);
-
-        bool ccutili, cclutili;
-        CurveFactory::complexsgnCurve(autili, butili, ccutili, cclutili, params.labCurve.acurve, params.labCurve.bcurve, params.labCurve.cccurve,
-                                      params.labCurve.lccurve, curve1, curve2, satcurve, lhskcurve, 1);
+        bool utili, ccutili, cclutili, clcutili;
+        stage_lab_curves(curve1, curve2, utili, ccutili, cclutili, clcutili);
 
 
         if (params.colorToning.enabled && params.colorToning.method == "LabGrid") {
@@ -1578,6 +1716,7 @@ private:
 
         int savestr = params.wavelet.strength;//work around for abstract profile: time about = 0.1 second
         if ((params.wavelet.enabled)  || (params.icm.workingTRC != ColorManagementParams::WorkingTrc::NONE  && params.icm.trcExp)) {
+            PipelineTrace::Scope stageTrace("export", "wavelet", fw, fh);
             LabImage *unshar = nullptr;
             WaveletParams WaveParams = params.wavelet;
             WavCurve wavCLVCurve;
@@ -1853,6 +1992,7 @@ private:
             1);
 
         if (params.colorappearance.enabled) {
+            PipelineTrace::Scope stageTrace("export", "ciecam", fw, fh);
             double adap;
 
             const float fnum = imgsrc->getMetaData()->getFNumber();         // F number
@@ -1902,37 +2042,7 @@ private:
             ch = params.crop.h;
         }
 
-        ImProcFunctions::FramingArgs framingArgs;
-        framingArgs.params = &params;
-        framingArgs.cropWidth = cw;
-        framingArgs.cropHeight = ch;
-        {
-            int imw, imh;
-            double tmpScale = ipf.resizeScale(&params, fw, fh, imw, imh);
-            framingArgs.resizeWidth = imw;
-            framingArgs.resizeHeight = imh;
-            framingArgs.resizeScale = tmpScale;
-
-            // If upscaling is not permitted, keep original sizing
-            if ((cw < imw || ch < imh) && !params.resize.allowUpscaling) {
-                framingArgs.resizeWidth = cw;
-                framingArgs.resizeHeight = ch;
-                framingArgs.resizeScale = 1.0;
-            }
-        }
-
-        // If framing is not enabled, resize values simply pass through to output
-        ImProcFunctions::FramingData framingData = ipf.framing(framingArgs);
-        if (settings->verbose) {
-            printf("Framing Parameters (enabled=%s)\n", framingData.enabled ? "yes" : "no");
-            printf("  Crop: w=%d h=%d\n", cw, ch);
-            printf("  Original resize: w=%d h=%d s=%f\n",
-                   framingArgs.resizeWidth, framingArgs.resizeHeight, framingArgs.resizeScale);
-            printf("  Framed image size: w=%d h=%d s=%f\n",
-                   framingData.imgWidth, framingData.imgHeight, framingData.scale);
-            printf("  Total size: w=%d h=%d\n",
-                   framingData.framedWidth, framingData.framedHeight);
-        }
+        const ImProcFunctions::FramingData framingData = stage_framing(cw, ch);
 
         bool labResize = params.resize.enabled && params.resize.method != "Nearest" &&
             (framingData.scale != 1.0 || params.prsharpening.enabled || framingData.enabled);
@@ -1962,6 +2072,7 @@ private:
             int imh = framingData.imgHeight;
             if (labView->W != imw || labView->H != imh) {
                 // resize image
+                PipelineTrace::Scope stageTrace("export", "resize", imw, imh);
                 tmplab = new LabImage(imw, imh);
                 ipf.Lanczos(labView, tmplab, framingData.scale);
                 delete labView;
@@ -1991,7 +2102,11 @@ private:
         // if Default gamma mode: we use the profile selected in the "Output profile" combobox;
         // gamma come from the selected profile, otherwise it comes from "Free gamma" tool
 
-        Imagefloat* readyImg = ipf.lab2rgbOut(labView, cx, cy, cw, ch, params.icm);
+        Imagefloat* readyImg;
+        {
+            PipelineTrace::Scope stageTrace("export", "lab2rgbOut", cw, ch);
+            readyImg = ipf.lab2rgbOut(labView, cx, cy, cw, ch, params.icm);
+        }
 
         if (settings->verbose) {
             printf("Output profile_: \"%s\"\n", params.icm.outputProfile.c_str());
@@ -2000,13 +2115,238 @@ private:
         delete labView;
         labView = nullptr;
 
+        return stage_output(readyImg, framingData, bwonly);
+    }
+
+    void stage_lab_curves(LUTf &acurve, LUTf &bcurve, bool &utili, bool &ccutili, bool &cclutili, bool &clcutili)
+    {
+        procparams::ProcParams& params = job->pparams;
+
+        CurveFactory::complexLCurve(params.labCurve.brightness, params.labCurve.contrast, params.labCurve.lcurve, hist16, lumacurve, dummy, 1, utili);
+
+        clcutili = CurveFactory::diagonalCurve2Lut(params.labCurve.clcurve, clcurve, 1);
+
+        CurveFactory::complexsgnCurve(autili, butili, ccutili, cclutili, params.labCurve.acurve, params.labCurve.bcurve, params.labCurve.cccurve,
+                                      params.labCurve.lccurve, acurve, bcurve, satcurve, lhskcurve, 1);
+    }
+
+    /**
+     * Returns the height of the strips to use for the end of the pipeline to stay within Settings::exportMemoryBudget,
+     * or 0 to process the whole frame at once. Strips are only possible when every tool from rgbProc to lab2rgbOut
+     * works pixel by pixel: the tools which need the neighbourhood of the pixels or statistics of the whole image
+     * must be disabled, as well as the Lanczos resize which works on the Lab data.
+     */
+    int exportStripHeight() const
+    {
+        const procparams::ProcParams& params = job->pparams;
+
+        if (settings->exportMemoryBudget <= 0) {
+            return 0;
+        }
+
+        const bool tileSafe =
+            !params.toneEqualizer.enabled
+            && !(params.blackwhite.enabled && params.blackwhite.autoc)
+            && params.labCurve.contrast == 0
+            && !(params.colorToning.enabled && params.colorToning.method == "LabRegions")
+            && !params.sh.enabled
+            && !params.localContrast.enabled
+            && !params.epd.enabled
+            && !params.impulseDenoise.enabled
+            && !params.defringe.enabled
+            && !params.sharpenEdge.enabled
+            && !params.sharpenMicro.enabled
+            && !params.sharpening.enabled
+            && !(params.dirpyrequalizer.enabled && params.dirpyrequalizer.cbdlMethod == "aft")
+            && !params.wavelet.enabled
+            && !(params.icm.workingTRC != ColorManagementParams::WorkingTrc::NONE && params.icm.trcExp)
+            && !params.colorappearance.enabled
+            && !(params.resize.enabled && params.resize.method != "Nearest");
+
+        if (!tileSafe) {
+            return 0;
+        }
+
+        int cx, cy, cw, ch;
+        getStripCrop(cx, cy, cw, ch);
+
+        constexpr int minStripHeight = 64;
+        // baseImg stays allocated for the whole frame, the output image for the crop
+        const int64_t fixedBytes = (static_cast<int64_t>(fw) * fh + static_cast<int64_t>(cw) * ch) * 3 * sizeof(float);
+        // a strip holds a copy of the cropped baseImg rows, the temporary image of rgbProc, the Lab data and the converted output
+        const int64_t rowBytes = static_cast<int64_t>(cw) * 4 * 3 * sizeof(float);
+        const int64_t budget = static_cast<int64_t>(settings->exportMemoryBudget) << 20;
+        const int64_t height = std::max<int64_t>(minStripHeight, (budget - fixedBytes) / rowBytes);
+
+        return height < ch ? static_cast<int>(height) : 0;
+    }
+
+    // The crop rectangle processed by stage_finish_strips(), clamped to the frame
+    void getStripCrop(int& cx, int& cy, int& cw, int& ch) const
+    {
+        const procparams::ProcParams& params = job->pparams;
+
+        cx = 0;
+        cy = 0;
+        cw = fw;
+        ch = fh;
+
+        if (params.crop.enabled) {
+            cx = rtengine::LIM(params.crop.x, 0, fw - 1);
+            cy = rtengine::LIM(params.crop.y, 0, fh - 1);
+            cw = rtengine::LIM(params.crop.w, 1, fw - cx);
+            ch = rtengine::LIM(params.crop.h, 1, fh - cy);
+        }
+    }
+
+    /**
+     * End of stage_finish under a memory budget: rgbProc, the pixel-wise Lab tools and lab2rgbOut run on horizontal
+     * strips of baseImg, so that neither labView nor the temporary images of rgbProc exist for the whole frame.
+     */
+    Imagefloat *stage_finish_strips(int stripHeight, float satLimit, float satLimitOpacity, bool opautili, DCPProfile *dcpProf, const DCPProfileApplyState &as)
+    {
+        procparams::ProcParams& params = job->pparams;
+        ImProcFunctions &ipf = * (ipf_p.get());
+
+        // only allocated for the local adjustments, which work on the whole frame before
+        delete labView;
+        labView = nullptr;
+
+        LUTf acurve(65536);
+        LUTf bcurve(65536);
+        bool utili, ccutili, cclutili, clcutili;
+        stage_lab_curves(acurve, bcurve, utili, ccutili, cclutili, clcutili);
+
+        int cx, cy, cw, ch;
+        getStripCrop(cx, cy, cw, ch);
+
+        const ImProcFunctions::FramingData framingData = stage_framing(cw, ch);
+
+        if (settings->verbose) {
+            printf("Processing the output in strips of %d rows\n", stripHeight);
+        }
+
+        Imagefloat* const readyImg = new Imagefloat(cw, ch);
+
+        for (int y = cy; y < cy + ch; y += stripHeight) {
+            const int h = std::min(stripHeight, cy + ch - y);
+
+            std::unique_ptr<Imagefloat> strip(new Imagefloat(cw, h));
+
+#ifdef _OPENMP
+            #pragma omp parallel for
+#endif
+            for (int i = 0; i < h; ++i) {
+                std::copy_n(baseImg->r(y + i) + cx, cw, strip->r(i));
+                std::copy_n(baseImg->g(y + i) + cx, cw, strip->g(i));
+                std::copy_n(baseImg->b(y + i) + cx, cw, strip->b(i));
+            }
+
+            LabImage labStrip(cw, h);
+
+            {
+                PipelineTrace::Scope stageTrace("export", "rgbProc", cw, h);
+                double rrm, ggm, bbm;
+                float autor = -9000.f, autog, autob;
+                LUTu histToneCurve;
+                ipf.rgbProc(strip.get(), &labStrip, nullptr, curve1, curve2, curve, params.toneCurve.saturation, rCurve, gCurve, bCurve, satLimit, satLimitOpacity, ctColorCurve, ctOpacityCurve, opautili, clToningcurve, cl2Toningcurve, customToneCurve1, customToneCurve2, customToneCurvebw1, customToneCurvebw2, rrm, ggm, bbm, autor, autog, autob, expcomp, hlcompr, hlcomprthresh, dcpProf, as, histToneCurve, options.chunkSizeRGB, options.measure);
+            }
+
+            strip.reset();
+
+            if (params.colorToning.enabled && params.colorToning.method == "LabGrid") {
+                ipf.colorToningLabGrid(&labStrip, 0, labStrip.W, 0, labStrip.H, false);
+            }
+
+            ipf.chromiLuminanceCurve(nullptr, 1, &labStrip, &labStrip, acurve, bcurve, satcurve, lhskcurve, clcurve, lumacurve, utili, autili, butili, ccutili, cclutili, clcutili, dummy, dummy);
+            ipf.vibrance(&labStrip, params.vibrance, params.toneCurve.hrenabled, params.icm.workingProfile);
+            ipf.softLight(&labStrip, params.softlight);
+
+            {
+                PipelineTrace::Scope stageTrace("export", "lab2rgbOut", cw, h);
+                const std::unique_ptr<Imagefloat> out(ipf.lab2rgbOut(&labStrip, 0, 0, cw, h, params.icm));
+
+#ifdef _OPENMP
+                #pragma omp parallel for
+#endif
+                for (int i = 0; i < h; ++i) {
+                    std::copy_n(out->r(i), cw, readyImg->r(y - cy + i));
+                    std::copy_n(out->g(i), cw, readyImg->g(y - cy + i));
+                    std::copy_n(out->b(i), cw, readyImg->b(y - cy + i));
+                }
+            }
+
+            if (pl) {
+                pl->setProgress(0.55 + 0.15 * (y + h - cy) / ch);
+            }
+        }
+
+        // if clut was used and size of clut cache == 1 we free the memory used by the clutstore (default clut cache size = 1 for 32 bit OS)
+        // The batch queue preloads the CLUT of its jobs and clears the cache itself when it stops
+        if (params.filmSimulation.enabled && !params.filmSimulation.clutFilename.empty() && options.clutCacheSize == 1 && !CLUTStore::getInstance().isPreloaded(params.filmSimulation.clutFilename)) {
+            CLUTStore::getInstance().clearCache();
+        }
+
+        delete baseImg;
+        baseImg = nullptr;
+
+        const bool bwonly = params.blackwhite.enabled && !params.colorToning.enabled && !autili && !butili;
+
+        return stage_output(readyImg, framingData, bwonly);
+    }
+
+    ImProcFunctions::FramingData stage_framing(int cw, int ch)
+    {
+        procparams::ProcParams& params = job->pparams;
+        ImProcFunctions &ipf = * (ipf_p.get());
+
+        ImProcFunctions::FramingArgs framingArgs;
+        framingArgs.params = &params;
+        framingArgs.cropWidth = cw;
+        framingArgs.cropHeight = ch;
+        {
+            int imw, imh;
+            double tmpScale = ipf.resizeScale(&params, fw, fh, imw, imh);
+            framingArgs.resizeWidth = imw;
+            framingArgs.resizeHeight = imh;
+            framingArgs.resizeScale = tmpScale;
+
+            // If upscaling is not permitted, keep original sizing
+            if ((cw < imw || ch < imh) && !params.resize.allowUpscaling) {
+                framingArgs.resizeWidth = cw;
+                framingArgs.resizeHeight = ch;
+                framingArgs.resizeScale = 1.0;
+            }
+        }
+
+        // If framing is not enabled, resize values simply pass through to output
+        const ImProcFunctions::FramingData framingData = ipf.framing(framingArgs);
+        if (settings->verbose) {
+            printf("Framing Parameters (enabled=%s)\n", framingData.enabled ? "yes" : "no");
+            printf("  Crop: w=%d h=%d\n", cw, ch);
+            printf("  Original resize: w=%d h=%d s=%f\n",
+                   framingArgs.resizeWidth, framingArgs.resizeHeight, framingArgs.resizeScale);
+            printf("  Framed image size: w=%d h=%d s=%f\n",
+                   framingData.imgWidth, framingData.imgHeight, framingData.scale);
+            printf("  Total size: w=%d h=%d\n",
+                   framingData.framedWidth, framingData.framedHeight);
+        }
+
+        return framingData;
+    }
+
+    Imagefloat *stage_output(Imagefloat *readyImg, const ImProcFunctions::FramingData &framingData, bool bwonly)
+    {
+        procparams::ProcParams& params = job->pparams;
+        ImProcFunctions &ipf = * (ipf_p.get());
+
         if (bwonly) { //force BW r=g=b
             if (settings->verbose) {
                 printf("Force BW\n");
             }
 
-            for (int ccw = 0; ccw < cw; ccw++) {
-                for (int cch = 0; cch < ch; cch++) {
+            for (int ccw = 0; ccw < readyImg->getWidth(); ccw++) {
+                for (int cch = 0; cch < readyImg->getHeight(); cch++) {
                     readyImg->r(cch, ccw) = readyImg->g(cch, ccw);
                     readyImg->b(cch, ccw) = readyImg->g(cch, ccw);
                 }
@@ -2112,6 +2452,7 @@ private:
 
     void stage_early_resize()
     {
+        PipelineTrace::Scope trace("export", "earlyResize", fw, fh);
         procparams::ProcParams& params = job->pparams;
         //ImProcFunctions ipf (&params, true);
         ImProcFunctions &ipf = * (ipf_p.get());
@@ -2248,6 +2589,8 @@ private:
     int& errorCode;
     ProgressListener* pl;
     bool flush;
+    DemosaicState* demosaicState;
+    bool keepSource;
 
     // internal state
     std::unique_ptr<ImProcFunctions> ipf_p;
@@ -2323,7 +2666,27 @@ private:
 IImagefloat* processImage(ProcessingJob* pjob, int& errorCode, ProgressListener* pl, bool flush)
 {
     ImageProcessor proc(pjob, errorCode, pl, flush);
-    return proc();
+    IImagefloat* const result = proc();
+    PipelineTrace::flush();
+    return result;
+}
+
+std::vector<IImagefloat*> processImages(const std::vector<ProcessingJob*>& jobs, std::vector<int>& errorCodes, ProgressListener* pl, bool flush)
+{
+    std::vector<IImagefloat*> results;
+    results.reserve(jobs.size());
+    errorCodes.assign(jobs.size(), 0);
+
+    DemosaicState demosaicState;
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        // the image source is only flushed after the last job
+        ImageProcessor proc(jobs[i], errorCodes[i], pl, flush, &demosaicState, i + 1 < jobs.size());
+        results.push_back(proc());
+    }
+
+    PipelineTrace::flush();
+    return results;
 }
 
 void batchProcessingThread(ProcessingJob* job, BatchProcessingListener* bpl)
@@ -26,6 +26,7 @@
 #include <iostream>
 #include <set>
 #include <unordered_set>
+#include <utility>
 
 namespace rtengine
 {
@@ -415,6 +416,7 @@ void ImProcFunctions::removeSpots (Imagefloat* img, ImageSource* imgsrc, const s
 
     std::vector< std::shared_ptr<SpotBox> > srcSpotBoxs;
     std::vector< std::shared_ptr<SpotBox> > dstSpotBoxs;
+    std::vector<std::pair<SpotBox::Rectangle, SpotBox::Rectangle>> spotImgAreas;  // unscaled src & dst areas to get from imgsrc
     int fullImgWidth = 0;
     int fullImgHeight = 0;
     imgsrc->getFullSize(fullImgWidth, fullImgHeight, tr);
@@ -424,8 +426,9 @@ void ImProcFunctions::removeSpots (Imagefloat* img, ImageSource* imgsrc, const s
                     0, 0, img, SpotBox::Type::FINAL);
 
     std::set<int> visibleSpots;   // list of dest spots intersecting the preview's crop
-    int i = 0;
 
+    // The geometry of all the spots is needed to find the dependencies, but only the required spots are read from
+    // the image source
     for (auto entry : params->spot.entries) {
         std::shared_ptr<SpotBox> srcSpotBox(new SpotBox(entry,  SpotBox::Type::SOURCE));
         std::shared_ptr<SpotBox> dstSpotBox(new SpotBox(entry,  SpotBox::Type::TARGET));
@@ -436,21 +439,38 @@ void ImProcFunctions::removeSpots (Imagefloat* img, ImageSource* imgsrc, const s
             continue;
         }
 
-        // If spot intersect the preview image, add it to the visible spots
-        if (dstSpotBox->spotIntersects(cropBox)) {
-            visibleSpots.insert(i);
+        const bool visible = dstSpotBox->spotIntersects(cropBox);
+        const auto imgAreas = std::make_pair(srcSpotBox->imgArea, dstSpotBox->imgArea);
+        *srcSpotBox /= pp.getSkip();
+        *dstSpotBox /= pp.getSkip();
+
+        // Update the intersectionArea between src and dest
+        if (srcSpotBox->mutuallyClipImageArea(*dstSpotBox)) {
+            // If spot intersect the preview image, add it to the visible spots
+            if (visible) {
+                visibleSpots.insert(static_cast<int>(srcSpotBoxs.size()));
+            }
+
+            srcSpotBoxs.push_back(srcSpotBox);
+            dstSpotBoxs.push_back(dstSpotBox);
+            spotImgAreas.push_back(imgAreas);
         }
-        ++i;
+    }
+
+    // Construct list of upstream dependencies
 
+    std::unordered_set<int> requiredSpotsSet = calcSpotDependencies(visibleSpots, srcSpotBoxs, dstSpotBoxs);
+    std::vector<int> requiredSpots(requiredSpotsSet.size());
+    std::copy(requiredSpotsSet.begin(), requiredSpotsSet.end(), requiredSpots.begin());
+    std::sort(requiredSpots.begin(), requiredSpots.end());
+
+    for (const auto i : requiredSpots) {
         // Source area
-        PreviewProps spp(srcSpotBox->imgArea.x1, srcSpotBox->imgArea.y1,
-                         srcSpotBox->getImageWidth(), srcSpotBox->getImageHeight(), pp.getSkip());
-        int w = 0;
-        int h = 0;
-        imgsrc->getSize(spp, w, h);
-        *srcSpotBox /= pp.getSkip();
-        srcSpotBox->allocImage();
-        Imagefloat *srcImage = srcSpotBox->getImage();
+        const SpotBox::Rectangle &srcArea = spotImgAreas[i].first;
+        PreviewProps spp(srcArea.x1, srcArea.y1, srcArea.x2 - srcArea.x1 + 1, srcArea.y2 - srcArea.y1 + 1, pp.getSkip());
+        SpotBox &srcSpotBox = *srcSpotBoxs[i];
+        srcSpotBox.allocImage();
+        Imagefloat *srcImage = srcSpotBox.getImage();
         for (int y = 0; y < (int)srcImage->getHeight(); ++y) {
             for (int x = 0; x < (int)srcImage->getWidth(); ++x) {
                 srcImage->r(y, x) = 60000.f;
@@ -459,19 +479,19 @@ void ImProcFunctions::removeSpots (Imagefloat* img, ImageSource* imgsrc, const s
             }
         }
 
-        imgsrc->getImage(currWB, tr, srcSpotBox->getImage(), spp, params->toneCurve, params->raw);
+        imgsrc->getImage(currWB, tr, srcImage, spp, params->toneCurve, params->raw);
         if (cmp) {
             imgsrc->convertColorSpace(srcImage, *cmp, currWB);
         }
-        assert(srcSpotBox->checkImageSize());
+        assert(srcSpotBox.checkImageSize());
 
 
         // Destination area
-        spp.set(dstSpotBox->imgArea.x1, dstSpotBox->imgArea.y1, dstSpotBox->getImageWidth(),
-                dstSpotBox->getImageHeight(), pp.getSkip());
-        *dstSpotBox /= pp.getSkip();
-        dstSpotBox->allocImage();
-        Imagefloat *dstImage = dstSpotBox->getImage();
+        const SpotBox::Rectangle &dstArea = spotImgAreas[i].second;
+        spp.set(dstArea.x1, dstArea.y1, dstArea.x2 - dstArea.x1 + 1, dstArea.y2 - dstArea.y1 + 1, pp.getSkip());
+        SpotBox &dstSpotBox = *dstSpotBoxs[i];
+        dstSpotBox.allocImage();
+        Imagefloat *dstImage = dstSpotBox.getImage();
         for (int y = 0; y < (int)dstImage->getHeight(); ++y) {
             for (int x = 0; x < (int)dstImage->getWidth(); ++x) {
                 dstImage->r(y, x) = 500.f;
@@ -479,27 +499,13 @@ void ImProcFunctions::removeSpots (Imagefloat* img, ImageSource* imgsrc, const s
                 dstImage->b(y, x) = 60000.f;
             }
         }
-        imgsrc->getImage(currWB, tr, dstSpotBox->getImage(), spp, params->toneCurve, params->raw);
+        imgsrc->getImage(currWB, tr, dstImage, spp, params->toneCurve, params->raw);
         if (cmp) {
             imgsrc->convertColorSpace(dstImage, *cmp, currWB);
         }
-        assert(dstSpotBox->checkImageSize());
-
-        // Update the intersectionArea between src and dest
-        if (srcSpotBox->mutuallyClipImageArea(*dstSpotBox)) {
-            srcSpotBoxs.push_back(srcSpotBox);
-            dstSpotBoxs.push_back(dstSpotBox);
-        }
-
+        assert(dstSpotBox.checkImageSize());
     }
 
-    // Construct list of upstream dependencies
-
-    std::unordered_set<int> requiredSpotsSet = calcSpotDependencies(visibleSpots, srcSpotBoxs, dstSpotBoxs);
-    std::vector<int> requiredSpots(requiredSpotsSet.size());
-    std::copy(requiredSpotsSet.begin(), requiredSpotsSet.end(), requiredSpots.begin());
-    std::sort(requiredSpots.begin(), requiredSpots.end());
-
     // Process spots and copy them downstream
 
     for (auto i = requiredSpots.begin(); i != requiredSpots.end(); i++) {
@@ -534,6 +540,51 @@ void ImProcFunctions::removeSpots (Imagefloat* img, ImageSource* imgsrc, const s
     }
 }
 
+bool ImProcFunctions::getSpotsChangedArea(const std::vector<SpotEntry> &oldEntries, const std::vector<SpotEntry> &newEntries, int &x1, int &y1, int &x2, int &y2)
+{
+    SpotBox::Rectangle area;
+    bool changed = false;
+
+    const auto addTarget =
+        [&area, &changed](const SpotEntry &entry)
+        {
+            const SpotBox box(const_cast<SpotEntry&>(entry), SpotBox::Type::TARGET);
+
+            if (changed) {
+                area.x1 = rtengine::min(area.x1, box.spotArea.x1);
+                area.y1 = rtengine::min(area.y1, box.spotArea.y1);
+                area.x2 = rtengine::max(area.x2, box.spotArea.x2);
+                area.y2 = rtengine::max(area.y2, box.spotArea.y2);
+            } else {
+                area = box.spotArea;
+                changed = true;
+            }
+        };
+
+    for (size_t i = 0; i < rtengine::max(oldEntries.size(), newEntries.size()); ++i) {
+        if (i >= oldEntries.size() || i >= newEntries.size() || oldEntries[i] != newEntries[i]) {
+            // Both the old and the new place of the spot have to be redone
+            if (i < oldEntries.size()) {
+                addTarget(oldEntries[i]);
+            }
+
+            if (i < newEntries.size()) {
+                addTarget(newEntries[i]);
+            }
+        } else if (changed && SpotBox(const_cast<SpotEntry&>(newEntries[i]), SpotBox::Type::SOURCE).spotArea.intersects(area)) {
+            // Unchanged spot copying from a changed area
+            addTarget(newEntries[i]);
+        }
+    }
+
+    x1 = area.x1;
+    y1 = area.y1;
+    x2 = area.x2;
+    y2 = area.y2;
+
+    return changed;
+}
+
 }
 
 namespace
@@ -265,11 +265,16 @@ void StdImageSource::colorSpaceConversion (Imagefloat* im, const ColorManagement
         }
 
         lcmsMutex->lock ();
-        cmsHTRANSFORM hTransform = cmsCreateTransform (in, TYPE_RGB_FLT, out, TYPE_RGB_FLT, INTENT_RELATIVE_COLORIMETRIC,
+        const std::unique_ptr<MatrixShaperTransform> matrixTransform = ICCStore::createMatrixShaperTransform(in, out, INTENT_RELATIVE_COLORIMETRIC, false);
+        cmsHTRANSFORM hTransform = matrixTransform ? nullptr : cmsCreateTransform (in, TYPE_RGB_FLT, out, TYPE_RGB_FLT, INTENT_RELATIVE_COLORIMETRIC,
                                    cmsFLAGS_NOOPTIMIZE | cmsFLAGS_NOCACHE);
         lcmsMutex->unlock ();
 
-        if(hTransform) {
+        if (matrixTransform) {
+            im->normalizeFloatTo1();
+            im->ExecCMSTransform(*matrixTransform);
+            im->normalizeFloatTo65535();
+        } else if(hTransform) {
             // Convert to the [0.0 ; 1.0] range
             im->normalizeFloatTo1();
 
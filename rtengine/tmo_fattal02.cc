@@ -67,6 +67,7 @@
 
 #include "array2D.h"
 #include "color.h"
+#include "fftwplancache.h"
 #include "iccstore.h"
 #include "imagefloat.h"
 #include "improcfun.h"
@@ -84,7 +85,6 @@ namespace rtengine
 /******************************************************************************
  * RT code
  ******************************************************************************/
-extern MyMutex *fftwMutex;
 
 using namespace std;
 
@@ -651,10 +651,7 @@ void tmo_fattal02(size_t width,
     //delete Gx; // RT - reused as temp buffer in solve_pde_fft, deleted later
 
     // solve pde and exponentiate (ie recover compressed image)
-    {
-        MyMutex::MyLock lock(*fftwMutex);
-        solve_pde_fft(FI, &L, Gx, multithread, algo);
-    }
+    solve_pde_fft(FI, &L, Gx, multithread, algo);
     delete Gx;
     delete FI;
 
@@ -771,11 +768,9 @@ void transform_ev2normal(Array2Df *A, Array2Df *T, bool multithread)
     // fftwf_free(in);
 
     // executes 2d discrete cosine transform
-    fftwf_plan p;
-    p = fftwf_plan_r2r_2d(height, width, A->data(), T->data(),
-                          FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE);
-    fftwf_execute(p);
-    fftwf_destroy_plan(p);
+    const FftwPlanCache::Plan p = FftwPlanCache::r2r2d(height, width, A->data(), T->data(),
+                         FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE, multithread);
+    fftwf_execute_r2r(p, A->data(), T->data());
 }
 
 
@@ -787,11 +782,9 @@ void transform_normal2ev(Array2Df *A, Array2Df *T, bool multithread)
     assert((int)T->getCols() == width && (int)T->getRows() == height);
 
     // executes 2d discrete cosine transform
-    fftwf_plan p;
-    p = fftwf_plan_r2r_2d(height, width, A->data(), T->data(),
-                          FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE);
-    fftwf_execute(p);
-    fftwf_destroy_plan(p);
+    const FftwPlanCache::Plan p = FftwPlanCache::r2r2d(height, width, A->data(), T->data(),
+                         FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE, multithread);
+    fftwf_execute_r2r(p, A->data(), T->data());
 
     // need to scale the output matrix to get the right transform
     float factor = (1.0f / ((height - 1) * (width - 1)));
@@ -882,18 +875,6 @@ void solve_pde_fft(Array2Df *F, Array2Df *U, Array2Df *buf, bool multithread, in
     assert((int)U->getCols() == width && (int)U->getRows() == height);
     assert(buf->getCols() == width && buf->getRows() == height);
 
-    // activate parallel execution of fft routines
-#ifdef RT_FFTW3F_OMP
-
-    if (multithread) {
-        fftwf_init_threads();
-        fftwf_plan_with_nthreads(omp_get_num_procs());
-    }
-
-// #else
-//   fftwf_plan_with_nthreads( 2 );
-#endif
-
     // in general there might not be a solution to the Poisson pde
     // with Neumann boundary conditions unless the boundary satisfies
     // an integral condition, this function modifies the boundary so that
@@ -20,6 +20,8 @@
 #include <glib/gstdio.h>
 #include <cstring>
 #include <functional>
+#include "rtengine/bufferpool.h"
+#include "rtengine/clutstore.h"
 #include "rtengine/imagedata.h"
 #include "rtengine/rt_math.h"
 #include "rtengine/procparams.h"
@@ -112,7 +114,13 @@ namespace   // local helper functions
     }
 }
 
-BatchQueue::BatchQueue (FileCatalog* aFileCatalog) : processing(nullptr), fileCatalog(aFileCatalog), sequence(0), listener(nullptr)
+BatchQueue::BatchQueue (FileCatalog* aFileCatalog) :
+    processing(nullptr),
+    fileCatalog(aFileCatalog),
+    sequence(0),
+    listener(nullptr),
+    encoderPool(new Glib::ThreadPool(1, 0)),
+    encodingSize(0)
 {
 
     location = THLOC_BATCHQUEUE;
@@ -159,6 +167,9 @@ BatchQueue::BatchQueue (FileCatalog* aFileCatalog) : processing(nullptr), fileCa
 
 BatchQueue::~BatchQueue ()
 {
+    // Let the encoder save the pending images
+    encoderPool->shutdown(false);
+
     std::set<BatchQueueEntry*> removable_bqes;
 
     mutex_removable_batch_queue_entries.lock();
@@ -180,6 +191,10 @@ BatchQueue::~BatchQueue ()
     }
 
     fd.clear ();
+
+    if (!preloadedClut.empty()) {
+        rtengine::CLUTStore::getInstance().release(preloadedClut);
+    }
 }
 
 void BatchQueue::resizeLoadedQueue()
@@ -307,18 +322,30 @@ bool BatchQueue::saveBatchQueue ()
     {
         MYREADERLOCK(l, entryRW);
 
-        if (fd.empty ())
+        std::lock_guard<std::mutex> encoderLock(encoderMutex);
+
+        if (fd.empty () && encoding.empty ())
             return true;
 
         // The column's header is mandatory (the first line will be skipped when loaded)
         file << "input image full path|param file full path|output image full path|file format|jpeg quality|jpeg subsampling|"
-             << "png bit depth|png compression|tiff bit depth|tiff is float|uncompressed tiff|save output params|force format options|fast export|<end of line>"
+             << "png bit depth|png compression|tiff bit depth|tiff is float|uncompressed tiff|save output params|force format options|fast export|big tiff|"
+             << "jxl bit depth|jxl is float|lossless jxl|jxl distance|jxl effort|<end of line>"
              << std::endl;
 
+        // The images not saved yet by the encoder come first
+        std::vector<BatchQueueEntry*> entries;
+
+        for (const auto& job : encoding) {
+            entries.push_back (job.entry);
+        }
+
         // method is already running with entryLock, so no need to lock again
         for (const auto fdEntry : fd) {
+            entries.push_back (static_cast<BatchQueueEntry*> (fdEntry));
+        }
 
-            const auto entry = static_cast<BatchQueueEntry*> (fdEntry);
+        for (const auto entry : entries) {
             const auto& saveFormat = entry->saveFormat;
 
             // Warning: for code's simplicity in loadBatchQueue, each field must end by the '|' character, safer than ';' or ',' since it can't be used in paths
@@ -334,6 +361,8 @@ bool BatchQueue::saveBatchQueue ()
                  << saveFormat.saveParams << '|' << entry->forceFormatOpts << '|'
                  << entry->fast_pipeline << '|'
                  << saveFormat.bigTiff << '|'
+                 << saveFormat.jxlBits << '|' << (saveFormat.jxlFloat ? 1 : 0) << '|' << saveFormat.jxlLossless << '|'
+                 << saveFormat.jxlDistance << '|' << saveFormat.jxlEffort << '|'
                  << std::endl;
         }
     }
@@ -383,6 +412,15 @@ bool BatchQueue::loadBatchQueue ()
                     return defaultValue;
                 }
             };
+            const auto nextDoubleOr = [&] (double defaultValue) -> double
+            {
+                try {
+                    return value != values.end () ? std::stod(*value++) : defaultValue;
+                }
+                catch (std::exception&) {
+                    return defaultValue;
+                }
+            };
 
             const auto source = nextStringOr (Glib::ustring ());
             const auto paramsFile = nextStringOr (Glib::ustring ());
@@ -402,6 +440,11 @@ bool BatchQueue::loadBatchQueue ()
             const auto forceFormatOpts = nextIntOr (options.forceFormatOpts);
             const auto fast = nextIntOr(false);
             const auto bigTiff = nextIntOr (options.saveFormat.bigTiff);
+            const auto jxlBits = nextIntOr (options.saveFormat.jxlBits);
+            const auto jxlFloat = nextIntOr (options.saveFormat.jxlFloat);
+            const auto jxlLossless = nextIntOr (options.saveFormat.jxlLossless);
+            const auto jxlDistance = nextDoubleOr (options.saveFormat.jxlDistance);
+            const auto jxlEffort = nextIntOr (options.saveFormat.jxlEffort);
 
             rtengine::procparams::ProcParams pparams;
 
@@ -442,6 +485,11 @@ bool BatchQueue::loadBatchQueue ()
                 saveFormat.tiffFloat = tiffFloat == 1;
                 saveFormat.tiffUncompressed = tiffUncompressed != 0;
                 saveFormat.bigTiff = bigTiff != 0;
+                saveFormat.jxlBits = jxlBits;
+                saveFormat.jxlFloat = jxlFloat == 1;
+                saveFormat.jxlLossless = jxlLossless != 0;
+                saveFormat.jxlDistance = jxlDistance;
+                saveFormat.jxlEffort = jxlEffort;
                 saveFormat.saveParams = saveParams != 0;
                 entry->forceFormatOpts = forceFormatOpts != 0;
             } else {
@@ -693,6 +741,8 @@ void BatchQueue::startProcessing ()
             // remove button set
             next->removeButtonSet ();
 
+            updatePreloadedClut ();
+
             // start batch processing
             rtengine::startBatchProcessing (next->job, this);
             queue_draw ();
@@ -736,6 +786,8 @@ void BatchQueue::error(const Glib::ustring& descr)
         processing->processing = false;
         processing->job = rtengine::ProcessingJob::create(processing->filename, processing->thumbnail->getType() == FT_Raw, *processing->params);
         processing = nullptr;
+        updatePreloadedClut ();
+        trimBufferPool ();
         redraw ();
     }
 
@@ -777,40 +829,24 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
 
     //printf ("fname=%s, %s\n", fname.c_str(), removeExtension(fname).c_str());
 
-    if (img && !fname.empty()) {
-        int err = 0;
-
-        if (saveFormat.format == "tif") {
-            err = img->saveAsTIFF (
-                fname,
-                saveFormat.tiffBits,
-                saveFormat.tiffFloat,
-                saveFormat.tiffUncompressed,
-                saveFormat.bigTiff
-            );
-        } else if (saveFormat.format == "png") {
-            err = img->saveAsPNG (fname, saveFormat.pngBits);
-        } else if (saveFormat.format == "jpg") {
-            err = img->saveAsJPEG (fname, saveFormat.jpegQuality, saveFormat.jpegSubSamp);
-        }
+    const bool hasImage = img && !fname.empty();
+    const bool encodeAsync = hasImage && options.batchEncoderMemory > 0;
 
-        delete img;
+    if (hasImage && !encodeAsync) {
+        saveImage (processing, img, fname, saveFormat);
+    }
 
-        if (err) {
-            throw Glib::FileError(Glib::FileError::FAILED, M("MAIN_MSG_CANNOTSAVE") + "\n" + fname);
-        }
+    BatchQueueEntry* const processed = processing;
+    EncodeJobs::iterator encodeJob;
+    std::size_t size = 0;
 
-        if (saveFormat.saveParams) {
-            // We keep the extension to avoid overwriting the profile when we have
-            // the same output filename with different extension
-            //processing->params.save (removeExtension(fname) + paramFileExtension);
-            processing->params->save (fname + ".out" + paramFileExtension);
-        }
+    if (encodeAsync) {
+        // Wait until the encoder has room for the image, at least one image being always accepted
+        size = static_cast<std::size_t>(img->getWidth()) * img->getHeight() * 3 * sizeof(float);
+        const std::size_t budget = static_cast<std::size_t>(options.batchEncoderMemory) << 20;
 
-        if (processing->thumbnail) {
-            processing->thumbnail->imageDeveloped ();
-            processing->thumbnail->imageRemovedFromQueue ();
-        }
+        std::unique_lock<std::mutex> lock(encoderMutex);
+        encoderDone.wait(lock, [this, size, budget]() { return encoding.empty() || encodingSize + size <= budget; });
     }
 
     // save temporary params file name: delete as last thing
@@ -822,7 +858,15 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
     {
         MYWRITERLOCK(l, entryRW);
 
-        delete processing;
+        if (encodeAsync) {
+            // Registered before leaving fd, so that saveBatchQueue always sees the entry
+            std::lock_guard<std::mutex> lock(encoderMutex);
+            encodeJob = encoding.insert(encoding.end(), EncodeJob{processed, img, fname, saveFormat, size});
+            encodingSize += size;
+        } else {
+            delete processing;
+        }
+
         processing = nullptr;
 
         fd.erase (fd.begin());
@@ -857,6 +901,184 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
         processing->removeButtonSet ();
     }
 
+    if (encodeAsync) {
+        encoderPool->push([this, encodeJob]() { encode(encodeJob); });
+        saveBatchQueue ();
+    } else {
+        removeProcessedParams (processedParams);
+    }
+
+    updatePreloadedClut ();
+    trimBufferPool ();
+
+    redraw ();
+    notifyListener ();
+
+    return processing ? processing->job : nullptr;
+}
+
+// Consecutive images using the same film simulation share its CLUT instead of decoding it again, whatever the CLUT cache size.
+// The CLUT of a job is decoded here, before the job is dispatched.
+void BatchQueue::updatePreloadedClut ()
+{
+    Glib::ustring clut;
+
+    if (processing && processing->params->filmSimulation.enabled) {
+        clut = processing->params->filmSimulation.clutFilename;
+    }
+
+    if (clut == preloadedClut) {
+        return;
+    }
+
+    if (!clut.empty()) {
+        rtengine::CLUTStore::getInstance().preload(clut);
+    }
+
+    if (!preloadedClut.empty()) {
+        rtengine::CLUTStore::getInstance().release(preloadedClut);
+
+        // the exports don't clear the cache while their CLUT is preloaded, see simpleprocess.cc
+        if (!processing && options.clutCacheSize == 1) {
+            rtengine::CLUTStore::getInstance().clearCache();
+        }
+    }
+
+    preloadedClut = clut;
+}
+
+// Once the queue has stopped and the last image is written, the buffers kept for the next job are given back to the system
+void BatchQueue::trimBufferPool ()
+{
+    {
+        MYREADERLOCK(l, entryRW);
+
+        if (processing) {
+            return;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(encoderMutex);
+
+        if (!encoding.empty()) {
+            return;
+        }
+    }
+
+    rtengine::BufferPool::trim();
+}
+
+void BatchQueue::saveImage (BatchQueueEntry* entry, rtengine::IImagefloat* img, const Glib::ustring& fname, const SaveFormat& saveFormat)
+{
+    int err = 0;
+
+    if (saveFormat.format == "tif") {
+        err = img->saveAsTIFF (
+            fname,
+            saveFormat.tiffBits,
+            saveFormat.tiffFloat,
+            saveFormat.tiffUncompressed,
+            saveFormat.bigTiff
+        );
+    } else if (saveFormat.format == "png") {
+        err = img->saveAsPNG (fname, saveFormat.pngBits);
+    } else if (saveFormat.format == "jpg") {
+        err = img->saveAsJPEG (fname, saveFormat.jpegQuality, saveFormat.jpegSubSamp);
+#ifdef LIBJXL
+    } else if (saveFormat.format == "jxl") {
+        err = img->saveAsJXL (
+            fname,
+            saveFormat.jxlBits,
+            saveFormat.jxlFloat,
+            saveFormat.jxlLossless,
+            saveFormat.jxlDistance,
+            saveFormat.jxlEffort
+        );
+#endif
+    }
+
+    delete img;
+
+    if (err) {
+        throw Glib::FileError(Glib::FileError::FAILED, M("MAIN_MSG_CANNOTSAVE") + "\n" + fname);
+    }
+
+    if (saveFormat.saveParams) {
+        // We keep the extension to avoid overwriting the profile when we have
+        // the same output filename with different extension
+        //processing->params.save (removeExtension(fname) + paramFileExtension);
+        entry->params->save (fname + ".out" + paramFileExtension);
+    }
+
+    if (entry->thumbnail) {
+        entry->thumbnail->imageDeveloped ();
+        entry->thumbnail->imageRemovedFromQueue ();
+    }
+}
+
+// Runs in encoderPool: saves the image, then releases its entry or puts it back at the head of the queue if
+// the image couldn't be saved. The GUI is only updated through idle_register.
+void BatchQueue::encode (EncodeJobs::iterator job)
+{
+    BatchQueueEntry* const entry = job->entry;
+    Glib::ustring errorMessage;
+
+    try {
+        saveImage (entry, job->img, job->fname, job->saveFormat);
+    } catch (Glib::Exception& ex) {
+        errorMessage = ex.what();
+    }
+
+    const Glib::ustring processedParams = entry->savedParamsFile;
+
+    if (errorMessage.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(encoderMutex);
+            encodingSize -= job->size;
+            encoding.erase(job);
+        }
+
+        delete entry;
+        removeProcessedParams (processedParams);
+    } else {
+        // restore failed thumb, behind the image being processed
+        BatchQueueButtonSet* bqbs = new BatchQueueButtonSet (entry);
+        bqbs->setButtonListener (this);
+        entry->addButtonSet (bqbs);
+        entry->processing = false;
+        entry->job = rtengine::ProcessingJob::create(entry->filename, entry->thumbnail->getType() == FT_Raw, *entry->params);
+
+        {
+            MYWRITERLOCK(l, entryRW);
+
+            fd.insert (fd.begin() + (processing ? 1 : 0), entry);
+
+            std::lock_guard<std::mutex> lock(encoderMutex);
+            encodingSize -= job->size;
+            encoding.erase(job);
+        }
+
+        saveBatchQueue ();
+    }
+
+    encoderDone.notify_all();
+    trimBufferPool ();
+
+    idle_register.add(
+        [this]() -> bool
+        {
+            redraw ();
+            return false;
+        }
+    );
+
+    // The processing thread may still be running, report the real state of the queue along with the error
+    notifyListener (errorMessage);
+}
+
+void BatchQueue::removeProcessedParams (const Glib::ustring& processedParams)
+{
     if (saveBatchQueue ()) {
         ::g_remove (processedParams.c_str ());
 
@@ -865,7 +1087,8 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
 
         {
             MYREADERLOCK(l, entryRW);
-            isEmpty = fd.empty();
+            std::lock_guard<std::mutex> lock(encoderMutex);
+            isEmpty = fd.empty() && encoding.empty();
         }
 
         if (isEmpty) {
@@ -884,11 +1107,19 @@ rtengine::ProcessingJob* BatchQueue::imageReady(rtengine::IImagefloat* img)
             } catch (Glib::Exception&) {}
         }
     }
+}
 
-    redraw ();
-    notifyListener ();
+bool BatchQueue::isEncoding (const Glib::ustring& fname)
+{
+    std::lock_guard<std::mutex> lock(encoderMutex);
 
-    return processing ? processing->job : nullptr;
+    for (const auto& job : encoding) {
+        if (job.fname == fname) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 // Calculates automatic filename of processed batch entry, but just the base name
@@ -1094,7 +1325,8 @@ Glib::ustring BatchQueue::autoCompleteFileName (const Glib::ustring& fileName, c
             fname = Glib::ustring::compose ("%1-%2.%3", Glib::build_filename (dstdir,  dstfname), tries, format);
         }
 
-        int fileExists = Glib::file_test (fname, Glib::FILE_TEST_EXISTS);
+        // An image still waiting for the encoder takes its name, unless it is going to be overwritten anyway
+        int fileExists = Glib::file_test (fname, Glib::FILE_TEST_EXISTS) || (!inOverwriteMode && isEncoding (fname));
 
         if (inOverwriteMode && fileExists) {
             if (::g_remove (fname.c_str ()) != 0) {
@@ -1125,9 +1357,15 @@ void BatchQueue::buttonPressed (LWButton* button, int actionCode, void* actionDa
     }
 }
 
-void BatchQueue::notifyListener ()
+void BatchQueue::notifyListener (const Glib::ustring& errorMessage)
 {
-    const bool queueRunning = processing;
+    bool queueRunning = processing;
+
+    if (!queueRunning) {
+        std::lock_guard<std::mutex> lock(encoderMutex);
+        queueRunning = !encoding.empty();
+    }
+
     if (listener) {
         BatchQueueListener* const bql = listener;
 
@@ -1138,9 +1376,9 @@ void BatchQueue::notifyListener ()
         }
 
         idle_register.add(
-            [bql, qsize, queueRunning]() -> bool
+            [bql, qsize, queueRunning, errorMessage]() -> bool
             {
-                bql->queueSizeChanged(qsize, queueRunning, false, {});
+                bql->queueSizeChanged(qsize, queueRunning, !errorMessage.empty(), errorMessage);
                 return false;
             }
         );
@@ -17,12 +17,17 @@
  */
 #pragma once
 
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <set>
 
 #include <gtkmm.h>
 
 #include "lwbutton.h"
 #include "lwbuttonset.h"
+#include "options.h"
 #include "threadutils.h"
 #include "thumbbrowserbase.h"
 
@@ -102,13 +107,30 @@ private:
     Glib::ustring autoCompleteFileName (const Glib::ustring& fileName, const Glib::ustring& format);
     Glib::ustring getTempFilenameForParams( const Glib::ustring &filename );
     bool saveBatchQueue ();
-    void notifyListener ();
+    void notifyListener (const Glib::ustring& errorMessage = {});
+
+    struct EncodeJob {
+        BatchQueueEntry* entry;
+        rtengine::IImagefloat* img;
+        Glib::ustring fname;
+        SaveFormat saveFormat;
+        std::size_t size;
+    };
+    using EncodeJobs = std::list<EncodeJob>;
+
+    bool isEncoding (const Glib::ustring& fname);
+    void encode (EncodeJobs::iterator job);
+    void saveImage (BatchQueueEntry* entry, rtengine::IImagefloat* img, const Glib::ustring& fname, const SaveFormat& saveFormat);
+    void removeProcessedParams (const Glib::ustring& processedParams);
+    void updatePreloadedClut ();
+    void trimBufferPool ();
 
     using ThumbBrowserBase::redrawNeeded;
 
     BatchQueueEntry* processing;  // holds the currently processed image
     FileCatalog* fileCatalog;
     int sequence; // holds the current sequence index
+    Glib::ustring preloadedClut; // film simulation CLUT kept loaded for the processed image and the following ones
 
     Glib::ustring nameTemplate;
 
@@ -125,5 +147,14 @@ private:
     std::set<BatchQueueEntry*> removable_batch_queue_entries;
     MyMutex mutex_removable_batch_queue_entries;
 
+    // The processed images are saved by encoderPool while the next image is developed. The images waiting for
+    // or being saved are kept in encoding, their total size being bounded by options.batchEncoderMemory.
+    std::unique_ptr<Glib::ThreadPool> encoderPool;
+    // Need to be a std::mutex because used in a std::condition_variable object...
+    std::mutex encoderMutex;
+    std::condition_variable encoderDone;
+    EncodeJobs encoding;
+    std::size_t encodingSize;
+
     IdleRegister idle_register;
 };
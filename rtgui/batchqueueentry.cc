@@ -188,8 +188,9 @@ std::tuple<Glib::ustring, bool> BatchQueueEntry::getToolTip (int x, int y) const
         if (forceFormatOpts) {
             tooltip += Glib::ustring::compose("\n\n%1: %2 (%3-bits%4)", M("SAVEDLG_FILEFORMAT"), saveFormat.format,
                                               saveFormat.format == "png" ? saveFormat.pngBits :
-                                              saveFormat.format == "tif" ? saveFormat.tiffBits : 8,
-                                              saveFormat.format == "tif" && saveFormat.tiffFloat ? M("SAVEDLG_FILEFORMAT_FLOAT") : "");
+                                              saveFormat.format == "tif" ? saveFormat.tiffBits :
+                                              saveFormat.format == "jxl" ? saveFormat.jxlBits : 8,
+                                              (saveFormat.format == "tif" && saveFormat.tiffFloat) || (saveFormat.format == "jxl" && saveFormat.jxlFloat) ? M("SAVEDLG_FILEFORMAT_FLOAT") : "");
 
             if (saveFormat.format == "jpg") {
                 tooltip += Glib::ustring::compose("\n%1: %2\n%3: %4",
@@ -205,6 +206,13 @@ std::tuple<Glib::ustring, bool> BatchQueueEntry::getToolTip (int x, int y) const
                 if (saveFormat.bigTiff) {
                     tooltip += Glib::ustring::compose("\n%1", M("SAVEDLG_BIGTIFF"));
                 }
+            } else if (saveFormat.format == "jxl") {
+                if (saveFormat.jxlLossless) {
+                    tooltip += Glib::ustring::compose("\n%1", M("SAVEDLG_JXLLOSSLESS"));
+                } else {
+                    tooltip += Glib::ustring::compose("\n%1: %2", M("SAVEDLG_JXLDISTANCE"), saveFormat.jxlDistance);
+                }
+                tooltip += Glib::ustring::compose("\n%1: %2", M("SAVEDLG_JXLEFFORT"), saveFormat.jxlEffort);
             }
         }
     }
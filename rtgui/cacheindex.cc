@@ -0,0 +1,546 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <glib/gstdio.h>
+
+#include "cacheindex.h"
+
+#include "cacheimagedata.h"
+
+#include "rtengine/settings.h"
+
+namespace
+{
+
+// The file starts with the magic, the format version and a byte order mark, followed by the records:
+//   uint32 size of the rest of the record
+//   uint8  kind
+//   string image path
+// and, for RECORD_ENTRY only, the size and modification time of the image and the CacheImageData fields.
+// Integers are written in the native byte order, strings as an uint32 length followed by the bytes.
+constexpr char MAGIC[4] = {'R', 'T', 'C', 'I'};
+constexpr std::uint32_t FORMAT_VERSION = 1;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr std::size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(std::uint32_t);
+
+constexpr std::uint8_t RECORD_REMOVED = 0;
+constexpr std::uint8_t RECORD_ENTRY = 1;
+
+class Writer
+{
+public:
+    explicit Writer(std::string& buffer) : buffer(buffer) {}
+
+    template<typename T>
+    void put(T value)
+    {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void put(const std::string& value)
+    {
+        put<std::uint32_t>(value.size());
+        buffer.append(value);
+    }
+
+private:
+    std::string& buffer;
+};
+
+class Reader
+{
+public:
+    Reader(const char* begin, const char* end) : pos(begin), end(end), failed(false) {}
+
+    template<typename T>
+    T get()
+    {
+        T value{};
+
+        if (static_cast<std::size_t>(end - pos) < sizeof(T)) {
+            failed = true;
+        } else {
+            std::memcpy(&value, pos, sizeof(T));
+            pos += sizeof(T);
+        }
+
+        return value;
+    }
+
+    std::string getString()
+    {
+        const std::uint32_t size = get<std::uint32_t>();
+
+        if (failed || static_cast<std::size_t>(end - pos) < size) {
+            failed = true;
+            return {};
+        }
+
+        std::string value(pos, size);
+        pos += size;
+        return value;
+    }
+
+    const char* position() const
+    {
+        return pos;
+    }
+
+    bool ok() const
+    {
+        return !failed;
+    }
+
+private:
+    const char* pos;
+    const char* end;
+    bool failed;
+};
+
+std::string encodeEntry(std::int64_t size, std::int64_t mtime, const CacheImageData& d)
+{
+    std::string payload;
+    Writer w(payload);
+
+    w.put<std::int64_t>(size);
+    w.put<std::int64_t>(mtime);
+    w.put(std::string(d.md5));
+    w.put(std::string(d.version));
+    w.put(std::string(d.xmpSidecarMd5));
+    w.put<std::uint8_t>(d.supported);
+    w.put<std::int32_t>(d.format);
+    w.put<std::int8_t>(d.rankOld);
+    w.put<std::uint8_t>(d.inTrashOld);
+    w.put<std::uint8_t>(d.recentlySaved);
+    w.put<std::uint8_t>(d.timeValid);
+    w.put<std::int16_t>(d.year);
+    w.put<std::int8_t>(d.month);
+    w.put<std::int8_t>(d.day);
+    w.put<std::int8_t>(d.hour);
+    w.put<std::int8_t>(d.min);
+    w.put<std::int8_t>(d.sec);
+    w.put<std::uint8_t>(d.exifValid);
+    w.put<std::uint16_t>(d.frameCount);
+    w.put<double>(d.fnumber);
+    w.put<double>(d.shutter);
+    w.put<double>(d.focalLen);
+    w.put<double>(d.focalLen35mm);
+    w.put<float>(d.focusDist);
+    w.put<std::uint32_t>(d.iso);
+    w.put<std::int32_t>(d.rating);
+    w.put<std::uint8_t>(d.isHDR);
+    w.put<std::uint8_t>(d.isDNG);
+    w.put<std::uint8_t>(d.isPixelShift);
+    w.put<std::int32_t>(d.sensortype);
+    w.put<std::int32_t>(d.sampleFormat);
+    w.put(std::string(d.lens));
+    w.put(std::string(d.camMake));
+    w.put(std::string(d.camModel));
+    w.put(std::string(d.filetype));
+    w.put(std::string(d.expcomp));
+    w.put<std::int32_t>(d.rotate);
+    w.put<std::int32_t>(d.thumbImgType);
+    w.put<std::int32_t>(d.width);
+    w.put<std::int32_t>(d.height);
+
+    return payload;
+}
+
+bool decodeEntry(const char* begin, std::size_t length, std::int64_t size, std::int64_t mtime, CacheImageData& d)
+{
+    Reader r(begin, begin + length);
+
+    if (r.get<std::int64_t>() != size || r.get<std::int64_t>() != mtime) {
+        return false;
+    }
+
+    d.md5 = r.getString();
+    d.version = r.getString();
+    d.xmpSidecarMd5 = r.getString();
+    d.supported = r.get<std::uint8_t>();
+    d.format = static_cast<ThFileType>(r.get<std::int32_t>());
+    d.rankOld = r.get<std::int8_t>();
+    d.inTrashOld = r.get<std::uint8_t>();
+    d.recentlySaved = r.get<std::uint8_t>();
+    d.timeValid = r.get<std::uint8_t>();
+    d.year = r.get<std::int16_t>();
+    d.month = r.get<std::int8_t>();
+    d.day = r.get<std::int8_t>();
+    d.hour = r.get<std::int8_t>();
+    d.min = r.get<std::int8_t>();
+    d.sec = r.get<std::int8_t>();
+    d.exifValid = r.get<std::uint8_t>();
+    d.frameCount = r.get<std::uint16_t>();
+    d.fnumber = r.get<double>();
+    d.shutter = r.get<double>();
+    d.focalLen = r.get<double>();
+    d.focalLen35mm = r.get<double>();
+    d.focusDist = r.get<float>();
+    d.iso = r.get<std::uint32_t>();
+    d.rating = r.get<std::int32_t>();
+    d.isHDR = r.get<std::uint8_t>();
+    d.isDNG = r.get<std::uint8_t>();
+    d.isPixelShift = r.get<std::uint8_t>();
+    d.sensortype = r.get<std::int32_t>();
+    d.sampleFormat = static_cast<rtengine::IIO_Sample_Format>(r.get<std::int32_t>());
+    d.lens = r.getString();
+    d.camMake = r.getString();
+    d.camModel = r.getString();
+    d.filetype = r.getString();
+    d.expcomp = r.getString();
+    d.rotate = r.get<std::int32_t>();
+    d.thumbImgType = r.get<std::int32_t>();
+    d.width = r.get<std::int32_t>();
+    d.height = r.get<std::int32_t>();
+
+    return r.ok();
+}
+
+std::string makeRecord(std::uint8_t kind, const std::string& path, const std::string& payload)
+{
+    std::string record;
+    Writer w(record);
+
+    w.put<std::uint32_t>(sizeof(std::uint8_t) + sizeof(std::uint32_t) + path.size() + payload.size());
+    w.put<std::uint8_t>(kind);
+    w.put(path);
+    record.append(payload);
+
+    return record;
+}
+
+std::string makeHeader()
+{
+    std::string header(MAGIC, sizeof(MAGIC));
+    Writer w(header);
+
+    w.put<std::uint32_t>(FORMAT_VERSION);
+    w.put<std::uint32_t>(BYTE_ORDER_MARK);
+
+    return header;
+}
+
+}
+
+CacheIndex::CacheIndex () :
+    mappedFile(nullptr),
+    appendFile(nullptr),
+    deadRecords(0)
+{
+}
+
+CacheIndex::~CacheIndex ()
+{
+    close();
+}
+
+void CacheIndex::open (const Glib::ustring& fname)
+{
+    MyMutex::MyLock lock (mutex);
+
+    unmap();
+    entries.clear();
+    md5Paths.clear();
+    deadRecords = 0;
+    fileName = fname;
+
+    mappedFile = g_mapped_file_new(fileName.c_str(), FALSE, nullptr);
+
+    if (mappedFile) {
+        const char* const begin = g_mapped_file_get_contents(mappedFile);
+        const std::size_t length = g_mapped_file_get_length(mappedFile);
+
+        if (length >= HEADER_SIZE && std::string(begin, HEADER_SIZE) == makeHeader()) {
+            readRecords(begin + HEADER_SIZE, begin + length);
+        } else {
+            // Unknown format or foreign byte order, start over
+            g_mapped_file_unref(mappedFile);
+            mappedFile = nullptr;
+            g_remove(fileName.c_str());
+        }
+    }
+
+    appendFile = g_fopen(fileName.c_str(), "ab");
+
+    if (!appendFile) {
+        if (rtengine::settings->verbose) {
+            std::cerr << "Failed to open the cache index '" << fileName << "': " << g_strerror(errno) << std::endl;
+        }
+
+        return;
+    }
+
+    if (!mappedFile) {
+        const std::string header = makeHeader();
+        fwrite(header.data(), 1, header.size(), appendFile);
+        fflush(appendFile);
+    }
+}
+
+void CacheIndex::close ()
+{
+    MyMutex::MyLock lock (mutex);
+
+    if (appendFile && deadRecords > entries.size()) {
+        compact();
+    }
+
+    unmap();
+    entries.clear();
+    md5Paths.clear();
+    deadRecords = 0;
+}
+
+void CacheIndex::clear ()
+{
+    MyMutex::MyLock lock (mutex);
+
+    unmap();
+    entries.clear();
+    md5Paths.clear();
+    deadRecords = 0;
+
+    if (fileName.empty()) {
+        return;
+    }
+
+    appendFile = g_fopen(fileName.c_str(), "wb");
+
+    if (appendFile) {
+        const std::string header = makeHeader();
+        fwrite(header.data(), 1, header.size(), appendFile);
+        fflush(appendFile);
+    }
+}
+
+bool CacheIndex::find (const Glib::ustring& fname, CacheImageData& data) const
+{
+    std::int64_t size, mtime;
+
+    if (!getFileStat(fname, size, mtime)) {
+        return false;
+    }
+
+    MyMutex::MyLock lock (mutex);
+
+    const auto iterator = entries.find(fname);
+
+    if (iterator == entries.end()) {
+        return false;
+    }
+
+    const Entry& entry = iterator->second;
+    CacheImageData imageData;
+
+    if (!decodeEntry(entry.owned.empty() ? entry.data : entry.owned.data(), entry.size, size, mtime, imageData)) {
+        return false;
+    }
+
+    data = imageData;
+    return true;
+}
+
+void CacheIndex::store (const Glib::ustring& fname, const CacheImageData& data)
+{
+    std::int64_t size, mtime;
+
+    if (!getFileStat(fname, size, mtime)) {
+        return;
+    }
+
+    std::string payload = encodeEntry(size, mtime, data);
+    const std::string record = makeRecord(RECORD_ENTRY, fname, payload);
+
+    MyMutex::MyLock lock (mutex);
+
+    if (!appendFile) {
+        return;
+    }
+
+    auto& entry = entries[fname];
+
+    if (entry.size) {
+        ++deadRecords;
+        md5Paths.erase(entry.md5);
+    }
+
+    entry.size = payload.size();
+    entry.owned = std::move(payload);
+    entry.data = nullptr;
+    entry.md5 = data.md5;
+    md5Paths[entry.md5] = fname;
+
+    append(fname, record);
+}
+
+void CacheIndex::remove (const Glib::ustring& fname)
+{
+    MyMutex::MyLock lock (mutex);
+
+    const auto iterator = entries.find(fname);
+
+    if (iterator == entries.end() || !appendFile) {
+        return;
+    }
+
+    md5Paths.erase(iterator->second.md5);
+    entries.erase(iterator);
+    deadRecords += 2; // The entry and the removal record
+    append(fname, makeRecord(RECORD_REMOVED, fname, {}));
+}
+
+void CacheIndex::removeMD5 (const std::string& md5)
+{
+    Glib::ustring path;
+
+    {
+        MyMutex::MyLock lock (mutex);
+
+        const auto iterator = md5Paths.find(md5);
+
+        if (iterator == md5Paths.end()) {
+            return;
+        }
+
+        path = iterator->second;
+    }
+
+    remove(path);
+}
+
+void CacheIndex::readRecords (const char* begin, const char* end)
+{
+    const char* pos = begin;
+
+    while (pos < end) {
+        Reader r(pos, end);
+        const std::uint32_t recordSize = r.get<std::uint32_t>();
+        const char* const recordEnd = r.position() + recordSize;
+
+        if (!r.ok() || recordSize > static_cast<std::size_t>(end - r.position())) {
+            break; // Truncated record, e.g. after a crash
+        }
+
+        Reader record(r.position(), recordEnd);
+        const std::uint8_t kind = record.get<std::uint8_t>();
+        const std::string path = record.getString();
+
+        if (!record.ok()) {
+            break;
+        }
+
+        const auto iterator = entries.find(path);
+
+        if (iterator != entries.end()) {
+            md5Paths.erase(iterator->second.md5);
+            ++deadRecords;
+        }
+
+        if (kind == RECORD_ENTRY) {
+            Entry& entry = entries[path];
+            entry.data = record.position();
+            entry.size = recordEnd - record.position();
+            entry.owned.clear();
+
+            // The md5 directly follows the image size and modification time
+            Reader md5Reader(entry.data + 2 * sizeof(std::int64_t), recordEnd);
+            entry.md5 = md5Reader.getString();
+            md5Paths[entry.md5] = path;
+        } else {
+            if (iterator != entries.end()) {
+                entries.erase(iterator);
+            }
+
+            ++deadRecords;
+        }
+
+        pos = recordEnd;
+    }
+}
+
+void CacheIndex::append (const std::string& path, const std::string& record)
+{
+    if (fwrite(record.data(), 1, record.size(), appendFile) != record.size() || fflush(appendFile) != 0) {
+        if (rtengine::settings->verbose) {
+            std::cerr << "Failed to update the cache index for '" << path << "'" << std::endl;
+        }
+    }
+}
+
+void CacheIndex::compact ()
+{
+    const Glib::ustring tmpName = fileName + ".tmp";
+    FILE* const f = g_fopen(tmpName.c_str(), "wb");
+
+    if (!f) {
+        return;
+    }
+
+    std::string data = makeHeader();
+
+    for (const auto& entry : entries) {
+        const std::string payload = entry.second.owned.empty() ? std::string(entry.second.data, entry.second.size) : entry.second.owned;
+        data += makeRecord(RECORD_ENTRY, entry.first, payload);
+    }
+
+    const bool written = fwrite(data.data(), 1, data.size(), f) == data.size();
+
+    if (fclose(f) != 0 || !written) {
+        g_remove(tmpName.c_str());
+        return;
+    }
+
+    // The mapping must be released before the file can be replaced on Windows
+    unmap();
+    entries.clear();
+
+    if (g_rename(tmpName.c_str(), fileName.c_str()) != 0) {
+        g_remove(fileName.c_str());
+        g_rename(tmpName.c_str(), fileName.c_str());
+    }
+}
+
+void CacheIndex::unmap ()
+{
+    if (appendFile) {
+        fclose(appendFile);
+        appendFile = nullptr;
+    }
+
+    if (mappedFile) {
+        g_mapped_file_unref(mappedFile);
+        mappedFile = nullptr;
+    }
+}
+
+bool CacheIndex::getFileStat (const Glib::ustring& fname, std::int64_t& size, std::int64_t& mtime)
+{
+    GStatBuf st;
+
+    if (g_stat(fname.c_str(), &st) != 0) {
+        return false;
+    }
+
+    size = st.st_size;
+    mtime = st.st_mtime;
+    return true;
+}
@@ -0,0 +1,91 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <glib.h>
+#include <glibmm/ustring.h>
+
+#include "threadutils.h"
+
+#include "rtengine/noncopyable.h"
+
+class CacheImageData;
+
+/**
+ * Single binary file holding the CacheImageData of all the cached images, keyed by image path, size and
+ * modification time.
+ *
+ * The file is memory-mapped when opened and its records are only decoded on lookup, so that opening a folder
+ * doesn't need to compute the MD5 of each image nor to parse its data/<name>.<md5>.txt file. New and updated
+ * records are appended to the file; the superseded ones are dropped when the index is compacted on close.
+ * The text files are still written and are used as fallback when an image is not found in the index.
+ */
+class CacheIndex :
+    public rtengine::NonCopyable
+{
+public:
+    CacheIndex ();
+    ~CacheIndex ();
+
+    /** Maps the index file, creating it if needed. */
+    void open (const Glib::ustring& fileName);
+    /** Compacts the index file if it holds too many superseded records, and unmaps it. */
+    void close ();
+    /** Deletes all the records. */
+    void clear ();
+
+    /** Fills data with the record of the image, if its size and modification time still match.
+      * @return true on success */
+    bool find (const Glib::ustring& fname, CacheImageData& data) const;
+    /** Adds or replaces the record of the image. */
+    void store (const Glib::ustring& fname, const CacheImageData& data);
+    /** Removes the record of the image. */
+    void remove (const Glib::ustring& fname);
+    /** Removes the record of the image whose cache files use this MD5. */
+    void removeMD5 (const std::string& md5);
+
+private:
+    struct Entry {
+        const char* data;   // Points either into the mapped file or into owned
+        std::size_t size;
+        std::string owned;
+        std::string md5;
+    };
+
+    using Entries = std::unordered_map<std::string, Entry>;
+
+    Glib::ustring fileName;
+    GMappedFile* mappedFile;
+    FILE* appendFile;
+    Entries entries;
+    std::unordered_map<std::string, std::string> md5Paths;
+    std::size_t deadRecords;
+    mutable MyMutex mutex;
+
+    void readRecords (const char* begin, const char* end);
+    void append (const std::string& path, const std::string& record);
+    void compact ();
+    void unmap ();
+
+    static bool getFileStat (const Glib::ustring& fname, std::int64_t& size, std::int64_t& mtime);
+};
@@ -40,6 +40,7 @@ namespace
 
 constexpr int cacheDirMode = 0777;
 constexpr const char* cacheDirs[] = { "profiles", "images", "embprofiles", "data" };
+constexpr const char* cacheIndexFile = "cacheindex.bin";
 
 }
 
@@ -65,6 +66,8 @@ void CacheManager::init ()
     if (error != 0 && rtengine::settings->verbose) {
         std::cerr << "Failed to create all cache directories: " << g_strerror(errno) << std::endl;
     }
+
+    cacheIndex.open (Glib::build_filename (baseDir, cacheIndexFile));
 }
 
 Thumbnail* CacheManager::getEntry (const Glib::ustring& fname)
@@ -89,30 +92,20 @@ Thumbnail* CacheManager::getEntry (const Glib::ustring& fname)
         }
     }
 
-    // build path name
-    const auto md5 = getMD5 (fname);
-
-    if (md5.empty ()) {
-        return nullptr;
-    }
-
-    const auto cacheName = getCacheFileName ("data", fname, ".txt", md5);
     const auto xmpSidecarMd5 =
         rtengine::settings->metadata_xmp_sync != rtengine::Settings::MetadataXmpSync::NONE
         ? getMD5(Thumbnail::xmpSidecarPath(fname))
         : "";
 
-    // let's see if we have it in the cache
+    // look the file up in the cache index first, it avoids computing its md5 and parsing its data file
     {
         CacheImageData imageData;
 
-        const auto error = imageData.load (cacheName);
-
-        if (error == 0 && imageData.supported) {
+        if (cacheIndex.find (fname, imageData) && imageData.supported) {
 
             if (xmpSidecarMd5 != imageData.xmpSidecarMd5) {
                 updateImageInfo(fname, imageData, xmpSidecarMd5);
-                imageData.save(cacheName);
+                saveImageData(fname, imageData);
             }
 
             thumbnail.reset (new Thumbnail (this, fname, &imageData));
@@ -123,13 +116,47 @@ Thumbnail* CacheManager::getEntry (const Glib::ustring& fname)
         }
     }
 
-    // if not, create a new one
     if (!thumbnail) {
+        // build path name
+        const auto md5 = getMD5 (fname);
+
+        if (md5.empty ()) {
+            return nullptr;
+        }
+
+        const auto cacheName = getCacheFileName ("data", fname, ".txt", md5);
+
+        // let's see if we have it in the cache
+        {
+            CacheImageData imageData;
+
+            const auto error = imageData.load (cacheName);
+
+            if (error == 0 && imageData.supported) {
+
+                if (xmpSidecarMd5 != imageData.xmpSidecarMd5) {
+                    updateImageInfo(fname, imageData, xmpSidecarMd5);
+                    imageData.save(cacheName);
+                }
 
-        thumbnail.reset (new Thumbnail (this, fname, md5, xmpSidecarMd5));
+                cacheIndex.store (fname, imageData);
 
-        if (!thumbnail->isSupported ()) {
-            thumbnail.reset ();
+                thumbnail.reset (new Thumbnail (this, fname, &imageData));
+
+                if (!thumbnail->isSupported ()) {
+                    thumbnail.reset ();
+                }
+            }
+        }
+
+        // if not, create a new one
+        if (!thumbnail) {
+
+            thumbnail.reset (new Thumbnail (this, fname, md5, xmpSidecarMd5));
+
+            if (!thumbnail->isSupported ()) {
+                thumbnail.reset ();
+            }
         }
     }
 
@@ -207,6 +234,8 @@ void CacheManager::renameEntry (const std::string& oldfilename, const std::strin
         std::cerr << "Failed to rename all files for cache entry '" << oldfilename << "': " << g_strerror(errno) << std::endl;
     }
 
+    cacheIndex.remove (oldfilename);
+
     // check if it is opened
     // if it is open, update md5
     const auto iterator = openEntries.find (oldfilename);
@@ -224,6 +253,12 @@ void CacheManager::renameEntry (const std::string& oldfilename, const std::strin
     thumbnail->saveThumbnail ();
 }
 
+void CacheManager::saveImageData (const Glib::ustring& fname, CacheImageData& imageData)
+{
+    imageData.save (getCacheFileName ("data", fname, ".txt", imageData.md5));
+    cacheIndex.store (fname, imageData);
+}
+
 void CacheManager::closeThumbnail (Thumbnail* thumbnail)
 {
     MyMutex::MyLock lock (mutex);
@@ -237,6 +272,7 @@ void CacheManager::closeCache () const
     MyMutex::MyLock lock (mutex);
 
     applyCacheSizeLimitation ();
+    cacheIndex.close ();
 }
 
 void CacheManager::clearAll () const
@@ -246,6 +282,8 @@ void CacheManager::clearAll () const
     for (const auto& cacheDir : cacheDirs) {
         deleteDir (cacheDir);
     }
+
+    cacheIndex.clear ();
 }
 
 void CacheManager::clearImages () const
@@ -255,6 +293,7 @@ void CacheManager::clearImages () const
     deleteDir ("data");
     deleteDir ("images");
     deleteDir ("embprofiles");
+    cacheIndex.clear ();
 }
 
 void CacheManager::clearProfiles () const
@@ -296,6 +335,7 @@ void CacheManager::deleteFiles (const Glib::ustring& fname, const std::string& m
 
     if (purgeData) {
         error |= g_remove (getCacheFileName ("data", fname, ".txt", md5).c_str ());
+        cacheIndex.removeMD5 (md5);
     }
 
     if (purgeProfile) {
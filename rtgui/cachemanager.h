@@ -23,6 +23,7 @@
 
 #include <glibmm/ustring.h>
 
+#include "cacheindex.h"
 #include "threadutils.h"
 
 #include "rtengine/noncopyable.h"
@@ -37,6 +38,7 @@ private:
     using Entries = std::map<std::string, Thumbnail*>;
     Entries openEntries;
     Glib::ustring    baseDir;
+    mutable CacheIndex cacheIndex;
     mutable MyMutex  mutex;
 
     void deleteDir   (const Glib::ustring& dirName) const;
@@ -53,6 +55,7 @@ public:
     Thumbnail*  getEntry    (const Glib::ustring& fname);
     void        deleteEntry (const Glib::ustring& fname);
     void        renameEntry (const std::string& oldfilename, const std::string& oldmd5, const std::string& newfilename);
+    void        saveImageData (const Glib::ustring& fname, CacheImageData& imageData);
 
     void closeThumbnail (Thumbnail* thumbnail);
     void closeCache () const;
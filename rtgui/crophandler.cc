@@ -327,7 +327,8 @@ void CropHandler::setDetailedCrop(
         cropimgtrue.clear();
     }
 
-    if (ax == cropX && ay == cropY && aw == cropW && ah == cropH && askip == (zoom >= 1000 ? 1 : zoom / 10)) {
+    // A larger skip is the subsampled pass of a progressive update, scaled up to the window until the real one arrives
+    if (ax == cropX && ay == cropY && aw == cropW && ah == cropH && askip >= (zoom >= 1000 ? 1 : zoom / 10)) {
         cropimg_width = im->getWidth ();
         cropimg_height = im->getHeight ();
         const std::size_t cropimg_size = 3 * cropimg_width * cropimg_height;
@@ -358,11 +359,15 @@ void CropHandler::setDetailedCrop(
                         }
 
                         if (!cropimg.empty()) {
-                            if (cix == cropX && ciy == cropY && ciw == cropW && cih == cropH && cis == (zoom >= 1000 ? 1 : zoom / 10)) {
+                            const int skip = zoom >= 1000 ? 1 : zoom / 10;
+
+                            if (cix == cropX && ciy == cropY && ciw == cropW && cih == cropH && cis >= skip) {
                                 // calculate final image size
                                 float czoom = zoom >= 1000 ?
                                     zoom / 1000.f :
                                     float((zoom/10) * 10) / float(zoom);
+                                czoom *= float(cis) / float(skip);
+                                const Gdk::InterpType interp = cis > skip ? Gdk::INTERP_BILINEAR : Gdk::INTERP_TILES;
                                 int imw = cropimg_width * czoom;
                                 int imh = cropimg_height * czoom;
 
@@ -376,12 +381,12 @@ void CropHandler::setDetailedCrop(
 
                                 Glib::RefPtr<Gdk::Pixbuf> tmpPixbuf = Gdk::Pixbuf::create_from_data (cropimg.data(), Gdk::COLORSPACE_RGB, false, 8, cropimg_width, cropimg_height, 3 * cropimg_width);
                                 cropPixbuf = Gdk::Pixbuf::create (Gdk::COLORSPACE_RGB, false, 8, imw, imh);
-                                tmpPixbuf->scale (cropPixbuf, 0, 0, imw, imh, 0, 0, czoom, czoom, Gdk::INTERP_TILES);
+                                tmpPixbuf->scale (cropPixbuf, 0, 0, imw, imh, 0, 0, czoom, czoom, interp);
                                 tmpPixbuf.clear ();
 
                                 Glib::RefPtr<Gdk::Pixbuf> tmpPixbuftrue = Gdk::Pixbuf::create_from_data (cropimgtrue.data(), Gdk::COLORSPACE_RGB, false, 8, cropimg_width, cropimg_height, 3 * cropimg_width);
                                 cropPixbuftrue = Gdk::Pixbuf::create (Gdk::COLORSPACE_RGB, false, 8, imw, imh);
-                                tmpPixbuftrue->scale (cropPixbuftrue, 0, 0, imw, imh, 0, 0, czoom, czoom, Gdk::INTERP_TILES);
+                                tmpPixbuftrue->scale (cropPixbuftrue, 0, 0, imw, imh, 0, 0, czoom, czoom, interp);
                                 tmpPixbuftrue.clear ();
                             }
 
@@ -0,0 +1,833 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// rtengine-bench: times the heavy rtengine kernels on synthetic inputs and
+// reports the throughput per thread count as JSON. No image files are needed,
+// the raw inputs are generated as small uncompressed DNGs in the temp directory.
+
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <locale.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <giomm.h>
+#include <glib/gstdio.h>
+#include <tiffio.h>
+
+#include "options.h"
+#include "version.h"
+#include "rtengine/color.h"
+#include "rtengine/cpudispatch.h"
+#include "rtengine/curves.h"
+#include "rtengine/gauss.h"
+#include "rtengine/iccstore.h"
+#include "rtengine/imagefloat.h"
+#include "rtengine/improcfun.h"
+#include "rtengine/labimage.h"
+#include "rtengine/procparams.h"
+#include "rtengine/rawimagesource.h"
+#include "rtengine/rtengine.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+Glib::ustring argv0;
+Glib::ustring argv1;
+
+namespace
+{
+
+using namespace rtengine;
+using namespace rtengine::procparams;
+
+// Synthetic scene in [0;1]: colour gradients, a zone plate and a checkerboard of hard edges,
+// plus a little deterministic noise, so that the edge-directed and noise-adaptive paths are taken
+float sceneValue(int c, int row, int col, int W, int H)
+{
+    static constexpr float tint[3][2] = {{0.8f, 0.3f}, {0.6f, 0.7f}, {0.3f, 0.9f}};
+
+    const float fx = static_cast<float>(col) / W;
+    const float fy = static_cast<float>(row) / H;
+    const float dx = fx - 0.5f;
+    const float dy = fy - 0.5f;
+    const float zone = 0.5f + 0.5f * std::cos(400.f * (dx * dx + dy * dy));
+    const int tile = ((col >> 6) ^ (row >> 6)) & 1;
+    float val = 0.1f + 0.4f * (c == 0 ? fx : c == 1 ? 0.5f * (fx + fy) : fy) + 0.3f * zone * tint[c][tile];
+
+    uint32_t hash = (static_cast<uint32_t>(row) * 73856093u) ^ (static_cast<uint32_t>(col) * 19349663u) ^ (static_cast<uint32_t>(c) * 83492791u);
+    hash ^= hash >> 13;
+    hash *= 0x5bd1e995u;
+    hash ^= hash >> 15;
+    val += ((hash & 0xffff) / 65535.f - 0.5f) * 0.02f;
+
+    return std::max(0.f, std::min(val, 1.f));
+}
+
+// Minimal little-endian DNG writer for a single uncompressed CFA image
+class DngWriter
+{
+public:
+    void addShort(uint16_t tag, std::initializer_list<uint16_t> values)
+    {
+        Entry& entry = add(tag, 3, values.size());
+        for (auto v : values) {
+            put16(entry.data, v);
+        }
+    }
+
+    void addLong(uint16_t tag, std::initializer_list<uint32_t> values)
+    {
+        Entry& entry = add(tag, 4, values.size());
+        for (auto v : values) {
+            put32(entry.data, v);
+        }
+    }
+
+    void addBytes(uint16_t tag, const std::vector<uint8_t>& values)
+    {
+        add(tag, 1, values.size()).data = values;
+    }
+
+    void addAscii(uint16_t tag, const std::string& value)
+    {
+        Entry& entry = add(tag, 2, value.size() + 1);
+        entry.data.assign(value.begin(), value.end());
+        entry.data.push_back(0);
+    }
+
+    void addRational(uint16_t tag, uint16_t type, const std::vector<double>& values)
+    {
+        Entry& entry = add(tag, type, values.size());
+        for (auto v : values) {
+            put32(entry.data, static_cast<uint32_t>(static_cast<int32_t>(std::lround(v * 10000.0))));
+            put32(entry.data, 10000);
+        }
+    }
+
+    bool write(const std::string& fname, const std::vector<uint16_t>& pixels)
+    {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+
+        const uint32_t ifdSize = 2 + 12 * entries.size() + 4;
+        uint32_t extraSize = 0;
+        for (const auto& entry : entries) {
+            if (entry.data.size() > 4) {
+                extraSize += (entry.data.size() + 1) & ~1u;
+            }
+        }
+        const uint32_t pixelOffset = 8 + ifdSize + extraSize;
+
+        std::vector<uint8_t> file {'I', 'I', 42, 0};
+        put32(file, 8);
+        put16(file, entries.size());
+
+        uint32_t extraOffset = 8 + ifdSize;
+        std::vector<uint8_t> extra;
+        for (auto& entry : entries) {
+            if (entry.tag == 273) { // StripOffsets
+                entry.data.clear();
+                put32(entry.data, pixelOffset);
+            }
+            put16(file, entry.tag);
+            put16(file, entry.type);
+            put32(file, entry.count);
+            if (entry.data.size() > 4) {
+                put32(file, extraOffset + extra.size());
+                extra.insert(extra.end(), entry.data.begin(), entry.data.end());
+                if (extra.size() & 1) {
+                    extra.push_back(0);
+                }
+            } else {
+                std::vector<uint8_t> value = entry.data;
+                value.resize(4, 0);
+                file.insert(file.end(), value.begin(), value.end());
+            }
+        }
+        put32(file, 0);
+        file.insert(file.end(), extra.begin(), extra.end());
+
+        std::ofstream out(fname, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(file.data()), file.size());
+        for (auto v : pixels) {
+            const char le[2] = {static_cast<char>(v & 0xff), static_cast<char>(v >> 8)};
+            out.write(le, 2);
+        }
+        return static_cast<bool>(out);
+    }
+
+private:
+    struct Entry {
+        uint16_t tag;
+        uint16_t type;
+        uint32_t count;
+        std::vector<uint8_t> data;
+    };
+
+    Entry& add(uint16_t tag, uint16_t type, uint32_t count)
+    {
+        entries.push_back({tag, type, count, {}});
+        return entries.back();
+    }
+
+    static void put16(std::vector<uint8_t>& buf, uint16_t v)
+    {
+        buf.push_back(v & 0xff);
+        buf.push_back(v >> 8);
+    }
+
+    static void put32(std::vector<uint8_t>& buf, uint32_t v)
+    {
+        put16(buf, v & 0xffff);
+        put16(buf, v >> 16);
+    }
+
+    std::vector<Entry> entries;
+};
+
+// Writes the synthetic scene as a Bayer (RGGB) or X-Trans DNG, returns the file name or an empty string
+std::string writeSyntheticRaw(int W, int H, bool xtrans)
+{
+    static const uint8_t bayer[2][2] = {{0, 1}, {1, 2}};
+    static const uint8_t xtransPattern[6][6] = {
+        {1, 1, 0, 1, 1, 2},
+        {1, 1, 2, 1, 1, 0},
+        {2, 0, 1, 0, 2, 1},
+        {1, 1, 2, 1, 1, 0},
+        {1, 1, 0, 1, 1, 2},
+        {0, 2, 1, 2, 0, 1}
+    };
+
+    const int period = xtrans ? 6 : 2;
+    std::vector<uint8_t> cfa;
+    for (int row = 0; row < period; ++row) {
+        for (int col = 0; col < period; ++col) {
+            cfa.push_back(xtrans ? xtransPattern[row][col] : bayer[row][col]);
+        }
+    }
+
+    std::vector<uint16_t> pixels(static_cast<size_t>(W) * H);
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int row = 0; row < H; ++row) {
+        for (int col = 0; col < W; ++col) {
+            const int c = cfa[(row % period) * period + col % period];
+            pixels[static_cast<size_t>(row) * W + col] = 60000.f * sceneValue(c, row, col, W, H);
+        }
+    }
+
+    DngWriter dng;
+    dng.addLong(254, {0});                  // NewSubFileType
+    dng.addLong(256, {static_cast<uint32_t>(W)});
+    dng.addLong(257, {static_cast<uint32_t>(H)});
+    dng.addShort(258, {16});                // BitsPerSample
+    dng.addShort(259, {1});                 // Compression: none
+    dng.addShort(262, {32803});             // PhotometricInterpretation: CFA
+    dng.addAscii(271, "RawTherapee");
+    dng.addAscii(272, xtrans ? "Synthetic X-Trans" : "Synthetic Bayer");
+    dng.addLong(273, {0});                  // StripOffsets, patched by DngWriter::write
+    dng.addShort(277, {1});                 // SamplesPerPixel
+    dng.addLong(278, {static_cast<uint32_t>(H)});
+    dng.addLong(279, {static_cast<uint32_t>(pixels.size() * 2)});
+    dng.addShort(33421, {static_cast<uint16_t>(period), static_cast<uint16_t>(period)});
+    dng.addBytes(33422, cfa);
+    dng.addBytes(50706, {1, 4, 0, 0});      // DNGVersion
+    dng.addAscii(50708, xtrans ? "RawTherapee Synthetic X-Trans" : "RawTherapee Synthetic Bayer");
+    dng.addLong(50717, {65535});            // WhiteLevel
+    // ColorMatrix1: XYZ -> linear sRGB, the synthetic camera has sRGB primaries
+    dng.addRational(50721, 10, {3.2406, -1.5372, -0.4986, -0.9689, 1.8758, 0.0415, 0.0557, -0.2040, 1.0570});
+    dng.addRational(50728, 5, {1.0, 1.0, 1.0}); // AsShotNeutral
+
+    std::string fname;
+    const int fd = Glib::file_open_tmp(fname, xtrans ? "rtbench-xtrans" : "rtbench-bayer");
+    g_close(fd, nullptr);
+
+    if (!dng.write(fname, pixels)) {
+        g_remove(fname.c_str());
+        return {};
+    }
+
+    return fname;
+}
+
+void fillScene(Imagefloat& img)
+{
+    const int W = img.getWidth();
+    const int H = img.getHeight();
+
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int row = 0; row < H; ++row) {
+        for (int col = 0; col < W; ++col) {
+            img.r(row, col) = 65535.f * sceneValue(0, row, col, W, H);
+            img.g(row, col) = 65535.f * sceneValue(1, row, col, W, H);
+            img.b(row, col) = 65535.f * sceneValue(2, row, col, W, H);
+        }
+    }
+}
+
+struct Result {
+    std::string kernel;
+    int threads;
+    double seconds;
+    double mpixPerSec;
+};
+
+class Bench
+{
+public:
+    Bench(const std::vector<int>& threads, int repeats, const std::string& filter) :
+        threads(threads),
+        repeats(repeats),
+        filter(filter)
+    {
+    }
+
+    bool selected(const std::string& name) const
+    {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    bool anySelected(std::initializer_list<std::string> names) const
+    {
+        return std::any_of(names.begin(), names.end(), [this](const std::string& name) { return selected(name); });
+    }
+
+    // Times 'kernel' for every thread count and keeps the best of the repeats.
+    // 'setup' restores the input before each run and is not timed.
+    void run(const std::string& name, double mpix, const std::function<void()>& setup, const std::function<void()>& kernel)
+    {
+        if (!selected(name)) {
+            return;
+        }
+
+        for (auto numThreads : threads) {
+#ifdef _OPENMP
+            omp_set_num_threads(numThreads);
+#endif
+            double best = std::numeric_limits<double>::max();
+
+            for (int i = 0; i < repeats; ++i) {
+                if (setup) {
+                    setup();
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                kernel();
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count());
+            }
+
+            results.push_back({name, numThreads, best, mpix / best});
+            std::cerr << name << " @" << numThreads << " threads: " << mpix / best << " MPix/s" << std::endl;
+        }
+
+#ifdef _OPENMP
+        omp_set_num_threads(threads.back());
+#endif
+    }
+
+    void writeJson(std::ostream& out, int W, int H) const
+    {
+        out << "{\n"
+            << "  \"version\": \"" << RTVERSION << "\",\n"
+            << "  \"simd\": \"" << getSimdLevelName(getSimdLevel()) << "\",\n"
+            << "  \"width\": " << W << ",\n"
+            << "  \"height\": " << H << ",\n"
+            << "  \"repeats\": " << repeats << ",\n"
+            << "  \"results\": [";
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            out << (i ? ",\n" : "\n")
+                << "    {\"kernel\": \"" << results[i].kernel << "\", \"threads\": " << results[i].threads
+                << ", \"seconds\": " << results[i].seconds << ", \"mpix_per_s\": " << results[i].mpixPerSec << "}";
+        }
+
+        out << "\n  ]\n}" << std::endl;
+    }
+
+private:
+    const std::vector<int> threads;
+    const int repeats;
+    const std::string filter;
+    std::vector<Result> results;
+};
+
+void benchDemosaic(Bench& bench, int W, int H, bool xtrans)
+{
+    const std::string prefix = xtrans ? "demosaic/xtrans/" : "demosaic/bayer/";
+    const auto& methods = xtrans ? RAWParams::XTransSensor::getMethodStrings() : RAWParams::BayerSensor::getMethodStrings();
+
+    if (std::none_of(methods.begin(), methods.end(), [&](const char* method) { return bench.selected(prefix + method); })) {
+        return;
+    }
+
+    const std::string fname = writeSyntheticRaw(W, H, xtrans);
+
+    if (fname.empty()) {
+        std::cerr << "Could not write the synthetic raw file" << std::endl;
+        return;
+    }
+
+    std::unique_ptr<RawImageSource> source(new RawImageSource);
+
+    if (source->load(fname)) {
+        std::cerr << "Could not load the synthetic raw file " << fname << std::endl;
+        g_remove(fname.c_str());
+        return;
+    }
+
+    ProcParams params;
+
+    for (const auto method : methods) {
+        if (!xtrans && method == RAWParams::BayerSensor::getMethodString(RAWParams::BayerSensor::Method::PIXELSHIFT)) {
+            continue; // needs a multi-frame file
+        }
+
+        if (xtrans) {
+            params.raw.xtranssensor.method = method;
+        } else {
+            params.raw.bayersensor.method = method;
+        }
+
+        const auto setup = [&]() {
+            float reddeha, greendeha, bluedeha;
+            source->preprocess(params.raw, params.lensProf, params.coarse, reddeha, greendeha, bluedeha, false);
+        };
+        const auto kernel = [&]() {
+            double contrastThreshold = 0.0;
+            source->demosaic(params.raw, false, contrastThreshold);
+        };
+        bench.run(prefix + method, W * H / 1e6, setup, kernel);
+    }
+
+    source.reset();
+    g_remove(fname.c_str());
+}
+
+void benchPipeline(Bench& bench, int W, int H)
+{
+    if (!bench.anySelected({"pipeline/default", "pipeline/locallab"})) {
+        return;
+    }
+
+    const std::string fname = writeSyntheticRaw(W, H, false);
+
+    if (fname.empty()) {
+        return;
+    }
+
+    // Lab_Local has no self-contained entry point, it is measured through a full pipeline run
+    // with one local adjustment spot, to be compared with the run without it
+    ProcParams localParams;
+    localParams.locallab.enabled = true;
+    localParams.locallab.spots.emplace_back();
+    localParams.locallab.spots.back().expexpose = true;
+    localParams.locallab.spots.back().expcomp = 0.5;
+
+    const std::pair<const char*, ProcParams> variants[] = {
+        {"pipeline/default", ProcParams()},
+        {"pipeline/locallab", localParams}
+    };
+
+    for (const auto& variant : variants) {
+        const auto kernel = [&]() {
+            int errorCode = 0;
+            IImagefloat* img = processImage(ProcessingJob::create(fname, true, variant.second), errorCode, nullptr, true);
+            delete img;
+        };
+        bench.run(variant.first, W * H / 1e6, nullptr, kernel);
+    }
+
+    g_remove(fname.c_str());
+}
+
+void benchKernels(Bench& bench, int W, int H)
+{
+    const double mpix = W * H / 1e6;
+
+    Imagefloat source(W, H);
+    fillScene(source);
+    Imagefloat work(W, H);
+    const auto restore = [&]() {
+        source.copyData(&work);
+    };
+
+    ProcParams params;
+    ImProcFunctions ipf(&params);
+
+    bench.run("gaussianBlur/sigma2", mpix, nullptr, [&]() {
+        // gaussianBlur only contains orphaned omp for loops
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        gaussianBlur(source.r.ptrs, work.r.ptrs, W, H, 2.0);
+    });
+    bench.run("gaussianBlur/sigma30", mpix, nullptr, [&]() {
+        // gaussianBlur only contains orphaned omp for loops
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        gaussianBlur(source.r.ptrs, work.r.ptrs, W, H, 30.0);
+    });
+
+    Imagefloat resized(W / 2, H / 2);
+    bench.run("Lanczos/0.5", mpix, nullptr, [&]() {
+        ipf.Lanczos(&source, &resized, 0.5f);
+    });
+
+    params.dehaze.enabled = true;
+    params.dehaze.strength = 50;
+    bench.run("dehaze", mpix, restore, [&]() {
+        ipf.dehaze(&work, params.dehaze);
+    });
+
+    if (bench.selected("RGB_denoise")) {
+        DirPyrDenoiseParams denoiseParams = params.dirpyrDenoise;
+        denoiseParams.enabled = true;
+        denoiseParams.Cmethod = "MAN";
+        denoiseParams.C2method = "MANU";
+        denoiseParams.luma = 20.0;
+        NoiseCurve noiseLCurve;
+        NoiseCurve noiseCCurve;
+        int numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip;
+        ipf.Tile_calc(768, 96, 2, W, H, numtiles_W, numtiles_H, tilewidth, tileheight, tileWskip, tileHskip);
+        const int nbtl = std::max(9, numtiles_W * numtiles_H);
+        std::vector<float> ch_M(nbtl), max_r(nbtl), max_b(nbtl);
+
+        bench.run("RGB_denoise", mpix, restore, [&]() {
+            float nresi, highresi;
+            ipf.RGB_denoise(2, &work, &work, nullptr, ch_M.data(), max_r.data(), max_b.data(), true, denoiseParams, 0.0, noiseLCurve, noiseCCurve, nresi, highresi);
+        });
+    }
+
+    if (!bench.anySelected({"ip_wavelet", "lab2rgbOut/RTv4_sRGB", "lab2rgbOut/RTv4_Large"})) {
+        return;
+    }
+
+    LabImage lab(W, H);
+    ipf.rgb2lab(source, lab, params.icm.workingProfile);
+    LabImage labWork(W, H);
+
+    WaveletParams waveParams = params.wavelet;
+    waveParams.enabled = true;
+    waveParams.expcontrast = true;
+    for (int i = 0; i < 4; ++i) {
+        waveParams.c[i] = 20;
+    }
+    WavCurve wavCLVCurve, wavdenoise, wavdenoiseh;
+    Wavblcurve wavblcurve;
+    WavOpacityCurveRG waOpacityCurveRG;
+    WavOpacityCurveSH waOpacityCurveSH;
+    WavOpacityCurveBY waOpacityCurveBY;
+    WavOpacityCurveW waOpacityCurveW;
+    WavOpacityCurveWL waOpacityCurveWL;
+    LUTf wavclCurve(65536, 0);
+    waveParams.getCurves(wavCLVCurve, wavdenoise, wavdenoiseh, wavblcurve, waOpacityCurveRG, waOpacityCurveSH, waOpacityCurveBY, waOpacityCurveW, waOpacityCurveWL);
+    CurveFactory::diagonalCurve2Lut(waveParams.wavclCurve, wavclCurve, 1);
+    params.wavelet = waveParams;
+
+    bench.run("ip_wavelet", mpix, [&]() { labWork.CopyFrom(&lab); }, [&]() {
+        ipf.ip_wavelet(&labWork, &labWork, 2, waveParams, wavCLVCurve, wavdenoise, wavdenoiseh, wavblcurve, waOpacityCurveRG, waOpacityCurveSH, waOpacityCurveBY, waOpacityCurveW, waOpacityCurveWL, wavclCurve, 1);
+    });
+
+    for (const char* profile : {"RTv4_sRGB", "RTv4_Large"}) {
+        ColorManagementParams icm = params.icm;
+        icm.outputProfile = profile;
+        bench.run(std::string("lab2rgbOut/") + profile, mpix, nullptr, [&]() {
+            delete ipf.lab2rgbOut(&lab, 0, 0, W, H, icm);
+        });
+    }
+}
+
+// Compares the row conversions of Color with the per pixel ones over the whole input range, including
+// the values out of the range of the lookup tables. Returns the number of mismatching values.
+int checkColorRows()
+{
+    constexpr int width = (1 << 20) + 3; // not a multiple of the vector size, so that the row tails are checked too
+    constexpr float tolerance = 1e-4f; // relative, or absolute below 1
+
+    // fills a row with the whole [low;high] range, in a different order per channel to mix the channels
+    const auto sweep =
+        [](std::vector<float>& row, float low, float high, uint64_t stride)
+        {
+            for (size_t i = 0; i < row.size(); ++i) {
+                row[i] = low + (high - low) * static_cast<float>((i * stride) % row.size()) / (row.size() - 1);
+            }
+        };
+
+    int failures = 0;
+    const auto compare =
+        [&failures](const std::string& name, const std::vector<float>& row, const std::vector<float>& ref)
+        {
+            float maxError = 0.f;
+            int mismatches = 0;
+
+            for (size_t i = 0; i < row.size(); ++i) {
+                const float error = std::fabs(row[i] - ref[i]) / std::max(1.f, std::fabs(ref[i]));
+
+                if (!(error <= tolerance) && !(std::isnan(row[i]) && std::isnan(ref[i]))) {
+                    if (mismatches == 0) {
+                        std::cerr << name << ": " << row[i] << " instead of " << ref[i] << " at " << i << std::endl;
+                    }
+
+                    ++mismatches;
+                }
+
+                maxError = std::max(maxError, error);
+            }
+
+            std::cout << name << ": max relative error " << maxError << ", " << mismatches << " mismatches" << std::endl;
+            failures += mismatches;
+        };
+
+    std::vector<float> in0(width), in1(width), in2(width);
+    std::vector<float> out0(width), out1(width), out2(width);
+    std::vector<float> ref0(width), ref1(width), ref2(width);
+
+    // XYZ from below 0 to above the lookup tables of the cube root
+    sweep(in0, -20000.f, 150000.f, 1);
+    sweep(in1, -20000.f, 150000.f, 7919);
+    sweep(in2, -20000.f, 150000.f, 104729);
+    Color::XYZ2Lab(in0.data(), in1.data(), in2.data(), out0.data(), out1.data(), out2.data(), width);
+
+    for (int i = 0; i < width; ++i) {
+        Color::XYZ2Lab(in0[i], in1[i], in2[i], ref0[i], ref1[i], ref2[i]);
+    }
+
+    compare("XYZ2Lab/L", out0, ref0);
+    compare("XYZ2Lab/a", out1, ref1);
+    compare("XYZ2Lab/b", out2, ref2);
+
+    // Lab beyond the usual [0;32768] and [-42000;42000] ranges
+    sweep(in0, -5000.f, 50000.f, 1);
+    sweep(in1, -60000.f, 60000.f, 7919);
+    sweep(in2, -60000.f, 60000.f, 104729);
+    Color::Lab2XYZ(in0.data(), in1.data(), in2.data(), out0.data(), out1.data(), out2.data(), width);
+
+    for (int i = 0; i < width; ++i) {
+        Color::Lab2XYZ(in0[i], in1[i], in2[i], ref0[i], ref1[i], ref2[i]);
+    }
+
+    compare("Lab2XYZ/X", out0, ref0);
+    compare("Lab2XYZ/Y", out1, ref1);
+    compare("Lab2XYZ/Z", out2, ref2);
+
+    const TMatrix wiprof = ICCStore::getInstance()->workingSpaceInverseMatrix("ProPhoto");
+    float wip[3][3];
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            wip[i][j] = wiprof[i][j];
+        }
+    }
+
+    Color::Lab2RGB(in0.data(), in1.data(), in2.data(), out0.data(), out1.data(), out2.data(), wip, width);
+
+    for (int i = 0; i < width; ++i) {
+        float X, Y, Z;
+        Color::Lab2XYZ(in0[i], in1[i], in2[i], X, Y, Z);
+        Color::xyz2rgb(X, Y, Z, ref0[i], ref1[i], ref2[i], wip);
+    }
+
+    compare("Lab2RGB/R", out0, ref0);
+    compare("Lab2RGB/G", out1, ref1);
+    compare("Lab2RGB/B", out2, ref2);
+
+    return failures;
+}
+
+std::vector<int> defaultThreadCounts()
+{
+    std::vector<int> threads;
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+#else
+    const int maxThreads = 1;
+#endif
+
+    for (int n = 1; n < maxThreads; n *= 2) {
+        threads.push_back(n);
+    }
+
+    threads.push_back(maxThreads);
+    return threads;
+}
+
+void printUsage(const char* exe)
+{
+    std::cout << "Usage: " << exe << " [-s <width>x<height>] [-t <n>[,<n>...]] [-r <repeats>] [-k <kernel filter>] [-o <output.json>]" << std::endl
+              << "       " << exe << " -c" << std::endl
+              << std::endl
+              << "  -c  check the row color conversions against the per pixel ones instead of timing the kernels" << std::endl
+              << "  -s  size of the synthetic inputs (default 3000x2000)" << std::endl
+              << "  -t  comma separated list of thread counts (default: powers of two up to the number of cores)" << std::endl
+              << "  -r  number of runs per measurement, the fastest one is reported (default 3)" << std::endl
+              << "  -k  only run the kernels whose name contains the given string, e.g. \"demosaic/bayer\"" << std::endl
+              << "  -o  write the JSON report to a file instead of stdout" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    setlocale(LC_NUMERIC, "C"); // to set decimal point to "."
+
+    Gio::init();
+
+#ifdef BUILD_BUNDLE
+    // the bench is installed next to rawtherapee-cli, so relative data paths are resolved the same way
+    if (Glib::path_is_absolute(DATA_SEARCH_PATH)) {
+        argv0 = DATA_SEARCH_PATH;
+    } else {
+        const std::string exe = Glib::find_program_in_path(argv[0]);
+        argv0 = Glib::build_filename(Glib::path_get_dirname(exe.empty() ? argv[0] : exe), DATA_SEARCH_PATH);
+    }
+#else
+    argv0 = DATA_SEARCH_PATH;
+#endif
+    options.rtSettings.lensfunDbDirectory = LENSFUN_DB_PATH;
+    options.rtSettings.lensfunDbBundleDirectory = LENSFUN_DB_PATH;
+
+    int W = 3000;
+    int H = 2000;
+    int repeats = 3;
+    std::vector<int> threads = defaultThreadCounts();
+    std::string filter;
+    std::string outputFile;
+    bool check = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        if (arg == "-c") {
+            check = true;
+            continue;
+        }
+
+        if (arg.size() != 2 || arg[0] != '-' || i + 1 >= argc) {
+            printUsage(argv[0]);
+            return -1;
+        }
+
+        const std::string value = argv[++i];
+
+        switch (arg[1]) {
+            case 's':
+                if (sscanf(value.c_str(), "%dx%d", &W, &H) != 2 || W < 64 || H < 64) {
+                    std::cerr << "Invalid size: " << value << std::endl;
+                    return -1;
+                }
+                break;
+
+            case 't': {
+                threads.clear();
+                std::istringstream list(value);
+                std::string item;
+
+                while (std::getline(list, item, ',')) {
+                    const int n = atoi(item.c_str());
+
+                    if (n > 0) {
+                        threads.push_back(n);
+                    }
+                }
+
+                if (threads.empty()) {
+                    std::cerr << "Invalid thread list: " << value << std::endl;
+                    return -1;
+                }
+                break;
+            }
+
+            case 'r':
+                repeats = std::max(1, atoi(value.c_str()));
+                break;
+
+            case 'k':
+                filter = value;
+                break;
+
+            case 'o':
+                outputFile = value;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return -1;
+        }
+    }
+
+    try {
+        Options::load(true);
+    } catch (Options::Error &e) {
+        std::cerr << "FATAL ERROR:" << std::endl << e.get_msg() << std::endl;
+        return -2;
+    }
+
+    // Options::load() initialized the engine, its caches are flushed by rtengine::cleanup() on every path from here
+    int result = 0;
+
+    if (check) {
+        result = checkColorRows() == 0 ? 0 : 1;
+    } else {
+        TIFFSetWarningHandler(nullptr);
+
+        Bench bench(threads, repeats, filter);
+        benchDemosaic(bench, W, H, false);
+        benchDemosaic(bench, W, H, true);
+        benchKernels(bench, W, H);
+        benchPipeline(bench, W, H);
+
+        if (outputFile.empty()) {
+            bench.writeJson(std::cout, W, H);
+        } else {
+            std::ofstream out(outputFile);
+            bench.writeJson(out, W, H);
+
+            if (!out) {
+                std::cerr << "Could not write " << outputFile << std::endl;
+                result = -1;
+            }
+        }
+    }
+
+    rtengine::cleanup();
+
+    return result;
+}
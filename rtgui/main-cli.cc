@@ -26,11 +26,18 @@
 #include "config.h"
 #include <gtkmm.h>
 #include <giomm.h>
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <tiffio.h>
 #include <cstring>
 #include <cstdlib>
 #include <locale.h>
+#include "rtengine/bufferpool.h"
+#include "rtengine/fftwplancache.h"
+#include "rtengine/pipelinetrace.h"
 #include "rtengine/procparams.h"
 #include "rtengine/profilestore.h"
 #include "rtengine/rtengine.h"
@@ -41,6 +48,10 @@
 #include "extprog.h"
 #include "pathutils.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifndef _WIN32
 #include <glibmm/fileutils.h>
 #include <glib.h>
@@ -69,6 +80,52 @@ namespace
 
 bool fast_export = false;
 
+// Collects the console output of one processed file. When a mutex is given (concurrent jobs),
+// the messages are buffered and flushed at once on destruction so that jobs don't interleave.
+class JobLog
+{
+public:
+    explicit JobLog (std::mutex* mutex) :
+        mutex (mutex)
+    {
+    }
+
+    ~JobLog()
+    {
+        if (mutex) {
+            std::lock_guard<std::mutex> lock (*mutex);
+            std::cout << outBuffer.str() << std::flush;
+            std::cerr << errBuffer.str() << std::flush;
+        }
+    }
+
+    std::ostream& out()
+    {
+        return mutex ? static_cast<std::ostream&> (outBuffer) : std::cout;
+    }
+
+    std::ostream& err()
+    {
+        return mutex ? static_cast<std::ostream&> (errBuffer) : std::cerr;
+    }
+
+private:
+    std::mutex* const mutex;
+    std::ostringstream outBuffer;
+    std::ostringstream errBuffer;
+};
+
+// A processing profile rendered as a separate output of each input file (-P)
+struct VariantProfile {
+    Glib::ustring name;
+    rtengine::procparams::PartialProfile* profile;
+};
+
+struct OutputVariant {
+    Glib::ustring file;
+    const rtengine::procparams::PartialProfile* profile;
+};
+
 }
 
 /* Process line command options
@@ -204,6 +261,13 @@ int main (int argc, char **argv)
         std::cout << "Terminating without anything to do." << std::endl;
     }
 
+    rtengine::PipelineTrace::close();
+    rtengine::FftwPlanCache::saveWisdom();
+
+    if (options.rtSettings.verbose) {
+        rtengine::BufferPool::printStats();
+    }
+
     return ret;
 }
 
@@ -240,6 +304,7 @@ int processLineParams ( int argc, char **argv )
     std::vector<Glib::ustring> inputFiles;
     Glib::ustring outputPath;
     std::vector<rtengine::procparams::PartialProfile*> processingParams;
+    std::vector<VariantProfile> variants;
     bool outputDirectory = false;
     bool leaveUntouched = false;
     bool overwriteFiles = false;
@@ -253,8 +318,11 @@ int processLineParams ( int argc, char **argv )
     int subsampling = 3;
     int bits = -1;
     bool isFloat = false;
+    bool jxlLossless = true;
+    float jxlDistance = 1.f;
     std::string outputType;
-    unsigned errors = 0;
+    unsigned int numJobs = 1;
+    std::atomic<unsigned> errors (0);
 
     for ( int iArg = 1; iArg < argc; iArg++) {
         Glib::ustring currParam (argv[iArg]);
@@ -323,6 +391,53 @@ int processLineParams ( int argc, char **argv )
 
                     break;
 
+                case 'P': // processing parameters of an additional output variant for all inputs
+                    if ( iArg + 1 < argc ) {
+                        iArg++;
+                        Glib::ustring fname (fname_to_utf8 (argv[iArg]));
+#if ECLIPSE_ARGS
+                        fname = fname.substr (1, fname.length() - 2);
+#endif
+
+                        if (fname.at (0) == '-') {
+                            std::cerr << "Error: filename missing next to the -P switch." << std::endl;
+                            deleteProcParams (processingParams);
+                            return -3;
+                        }
+
+                        rtengine::procparams::PartialProfile* variantParams = new rtengine::procparams::PartialProfile (true);
+
+                        if (! (variantParams->load ( fname ))) {
+                            Glib::ustring name = Glib::path_get_basename (fname);
+                            variants.push_back ({name.substr (0, name.find_last_of ('.')), variantParams});
+                        } else {
+                            std::cerr << "Error: \"" << fname << "\" not found." << std::endl;
+                            variantParams->deleteInstance();
+                            delete variantParams;
+                            deleteProcParams (processingParams);
+                            return -3;
+                        }
+                    }
+
+                    break;
+
+                case 'T': // records the processing stages to a Chrome trace file
+                    if ( iArg + 1 < argc ) {
+                        iArg++;
+                        Glib::ustring fname (fname_to_utf8 (argv[iArg]));
+#if ECLIPSE_ARGS
+                        fname = fname.substr (1, fname.length() - 2);
+#endif
+
+                        if (fname.at (0) == '-' || !rtengine::PipelineTrace::open (fname)) {
+                            std::cerr << "Error: can't write the trace file next to the -T switch." << std::endl;
+                            deleteProcParams (processingParams);
+                            return -3;
+                        }
+                    }
+
+                    break;
+
                 case 'S':
                     skipIfNoSidecar = true;
                     // fall through
@@ -413,10 +528,45 @@ int processLineParams ( int argc, char **argv )
                     compression = -1;
                     break;
 
+#ifdef LIBJXL
+                case 'x':
+                    outputType = "jxl";
+                    jxlLossless = currParam.size() < 3;
+
+                    if (!jxlLossless) {
+                        jxlDistance = atof (currParam.substr (2).c_str());
+
+                        if (jxlDistance < 0.1f || jxlDistance > 25.f) {
+                            std::cerr << "Error: the value accompanying the -x switch has to be in the [0.1-25] range!" << std::endl;
+                            deleteProcParams (processingParams);
+                            return -3;
+                        }
+                    }
+
+                    break;
+#endif
+
                 case 'f':
                     fast_export = true;
                     break;
 
+                case 'J':
+                    if (currParam.length() == 2) {
+                        std::cerr << "Error: the -J switch requires a mandatory value!" << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                    numJobs = atoi (currParam.substr (2).c_str());
+
+                    if (numJobs < 1 || numJobs > 64) {
+                        std::cerr << "Error: the value accompanying the -J switch has to be in the [1-64] range!" << std::endl;
+                        deleteProcParams (processingParams);
+                        return -3;
+                    }
+
+                    break;
+
                 case 'c': // MUST be last option
                     while (iArg + 1 < argc) {
                         iArg++;
@@ -523,7 +673,7 @@ int processLineParams ( int argc, char **argv )
                     std::cout << "  " << Glib::path_get_basename (argv[0]) << " <other options> -c <dir>|<files>   Convert files in batch with your own settings." << std::endl;
                     std::cout << std::endl;
                     std::cout << "Options:" << std::endl;
-                    std::cout << "  " << Glib::path_get_basename (argv[0]) << "[-o <output>|-O <output>] [-q] [-a] [-s|-S] [-p <one.pp3> [-p <two.pp3> ...] ] [-d] [ -j[1-100] -js<1-3> | -t[z] -b<8|16|16f|32> | -n -b<8|16> ] [-Y] [-f] -c <input>" << std::endl;
+                    std::cout << "  " << Glib::path_get_basename (argv[0]) << "[-o <output>|-O <output>] [-q] [-a] [-s|-S] [-p <one.pp3> [-p <two.pp3> ...] ] [-P <variant.pp3> ...] [-d] [ -j[1-100] -js<1-3> | -t[z] -b<8|16|16f|32> | -n -b<8|16> | -x[0.1-25] -b<8|16|16f|32> ] [-Y] [-f] [-J<1-64>] [-T <trace.json>] -c <input>" << std::endl;
                     std::cout << std::endl;
                     std::cout << "  -c <files>       Specify one or more input files or folders." << std::endl;
                     std::cout << "                   When specifying folders, Rawtherapee will look for image file types which comply" << std::endl;
@@ -543,6 +693,10 @@ int processLineParams ( int argc, char **argv )
                     std::cout << "  -p <file.pp3>    Specify processing profile to be used for all conversions." << std::endl;
                     std::cout << "                   You can specify as many sets of \"-p <file.pp3>\" options as you like," << std::endl;
                     std::cout << "                   each will be built on top of the previous one, as explained below." << std::endl;
+                    std::cout << "  -P <file.pp3>    Render an additional output variant with this processing profile applied on top" << std::endl;
+                    std::cout << "                   of all the others. Each \"-P <file.pp3>\" option produces one output file, suffixed" << std::endl;
+                    std::cout << "                   with the name of the profile. The image is decoded and demosaiced only once" << std::endl;
+                    std::cout << "                   for all the variants which share the same raw settings." << std::endl;
                     std::cout << "  -d               Use the default raw or non-raw processing profile as set in" << std::endl;
                     std::cout << "                   Preferences > Image Processing > Default Processing Profile" << std::endl;
                     std::cout << "  -j[1-100]        Specify output to be JPEG (default, if -t and -n are not set)." << std::endl;
@@ -555,16 +709,26 @@ int processLineParams ( int argc, char **argv )
                     std::cout << "                   3 = Best quality:       1x1, 1x1, 1x1 (4:4:4)" << std::endl;
                     std::cout << "                       No chroma subsampling." << std::endl;
                     std::cout << "  -b<8|16|16f|32>  Specify bit depth per channel." << std::endl;
-                    std::cout << "                   8   = 8-bit integer.  Applies to JPEG, PNG and TIFF. Default for JPEG and PNG." << std::endl;
-                    std::cout << "                   16  = 16-bit integer. Applies to TIFF and PNG. Default for TIFF." << std::endl;
-                    std::cout << "                   16f = 16-bit float.   Applies to TIFF." << std::endl;
-                    std::cout << "                   32  = 32-bit float.   Applies to TIFF." << std::endl;
+                    std::cout << "                   8   = 8-bit integer.  Applies to JPEG, PNG, TIFF and JPEG XL. Default for JPEG and PNG." << std::endl;
+                    std::cout << "                   16  = 16-bit integer. Applies to TIFF, PNG and JPEG XL. Default for TIFF and JPEG XL." << std::endl;
+                    std::cout << "                   16f = 16-bit float.   Applies to TIFF and JPEG XL." << std::endl;
+                    std::cout << "                   32  = 32-bit float.   Applies to TIFF and JPEG XL." << std::endl;
                     std::cout << "  -t[z]            Specify output to be TIFF." << std::endl;
                     std::cout << "                   Uncompressed by default, or deflate compression with 'z'." << std::endl;
                     std::cout << "  -n               Specify output to be compressed PNG." << std::endl;
-                    std::cout << "                   Compression is hard-coded to PNG_FILTER_PAETH, Z_RLE." << std::endl;
+                    std::cout << "                   Compression defaults to the Paeth filter and Z_RLE, see PngFilter, PngStrategy" << std::endl;
+                    std::cout << "                   and PngCompression (the zlib level of the default and filtered strategies)" << std::endl;
+                    std::cout << "                   in the [Output] section of the options file." << std::endl;
+#ifdef LIBJXL
+                    std::cout << "  -x[0.1-25]       Specify output to be JPEG XL." << std::endl;
+                    std::cout << "                   Lossless by default, or lossy with the given distance (1.0 = visually lossless)." << std::endl;
+#endif
                     std::cout << "  -Y               Overwrite output if present." << std::endl;
                     std::cout << "  -f               Use the custom fast-export processing pipeline." << std::endl;
+                    std::cout << "  -J<1-64>         Number of images processed concurrently (default: 1)." << std::endl;
+                    std::cout << "                   The available processing threads are split between the jobs." << std::endl;
+                    std::cout << "  -T <file.json>   Record the duration of each processing stage to a Chrome trace file," << std::endl;
+                    std::cout << "                   to be opened with chrome://tracing or https://ui.perfetto.dev" << std::endl;
                     std::cout << std::endl;
                     std::cout << "Your " << pparamsExt << " files can be incomplete, RawTherapee will build the final values as follows:" << std::endl;
                     std::cout << "  1- A new processing profile is created using neutral values," << std::endl;
@@ -574,6 +738,8 @@ int processLineParams ( int argc, char **argv )
                     std::cout << "     found in these processing profiles." << std::endl;
                     std::cout << "  4- If the \"-s\" or \"-S\" options are set, the values are finally overridden by those" << std::endl;
                     std::cout << "     found in the sidecar files." << std::endl;
+                    std::cout << "  5- If one or more \"-P\" options are set, one output is rendered for each of them," << std::endl;
+                    std::cout << "     with the values of its processing profile applied last." << std::endl;
                     std::cout << "  The processing profiles are processed in the order specified on the command line." << std::endl;
                     return -1;
                 }
@@ -605,6 +771,10 @@ int processLineParams ( int argc, char **argv )
                 options.saveFormat.format = outputType;
             } else if (outputType == "png") {
                 options.saveFormat.format = outputType;
+            } else if (outputType == "jxl") {
+                options.saveFormat.format = outputType;
+                options.saveFormat.jxlLossless = jxlLossless;
+                options.saveFormat.jxlDistance = jxlDistance;
             }
 
             break;
@@ -616,7 +786,7 @@ int processLineParams ( int argc, char **argv )
             bits = 8;
         } else if (outputType == "png") {
             bits = 8;
-        } else if (outputType == "tif") {
+        } else if (outputType == "tif" || outputType == "jxl") {
             bits = 16;
         } else {
             bits = 8;
@@ -657,167 +827,273 @@ int processLineParams ( int argc, char **argv )
         }
     }
 
-    for ( size_t iFile = 0; iFile < inputFiles.size(); iFile++) {
+    if ( outputType.empty() ) {
+        outputType = "jpg";
+    }
 
-        // Has to be reinstanciated at each profile to have a ProcParams object with default values
-        rtengine::procparams::ProcParams currentParams;
+    if (numJobs > inputFiles.size()) {
+        numJobs = inputFiles.size();
+    }
 
-        Glib::ustring inputFile = inputFiles[iFile];
-        std::cout << "Output is " << bits << "-bit " << (isFloat ? "floating-point" : "integer") << "." << std::endl;
-        std::cout << "Processing: " << inputFile << std::endl;
+    // Serializes the console output of concurrent jobs and the (lazily initialized) profile store
+    std::mutex outputMutex;
+    std::mutex profileMutex;
 
-        rtengine::InitialImage* ii = nullptr;
-        rtengine::ProcessingJob* job = nullptr;
-        int errorCode;
-        bool isRaw = false;
+    const auto processFile =
+        [&] (const Glib::ustring& inputFile)
+        {
+            JobLog log (numJobs > 1 ? &outputMutex : nullptr);
 
-        Glib::ustring outputFile;
+            // Has to be reinstanciated at each profile to have a ProcParams object with default values
+            rtengine::procparams::ProcParams currentParams;
 
-        if ( outputType.empty() ) {
-            outputType = "jpg";
-        }
+            log.out() << "Output is " << bits << "-bit " << (isFloat ? "floating-point" : "integer") << "." << std::endl;
+            log.out() << "Processing: " << inputFile << std::endl;
 
-        if ( outputPath.empty() ) {
-            Glib::ustring s = inputFile;
-            Glib::ustring::size_type ext = s.find_last_of ('.');
-            outputFile = s.substr (0, ext) + "." + outputType;
-        } else if ( outputDirectory ) {
-            Glib::ustring s = Glib::path_get_basename ( inputFile );
-            Glib::ustring::size_type ext = s.find_last_of ('.');
-            outputFile = Glib::build_filename (outputPath, s.substr (0, ext) + "." + outputType);
-        } else {
-            if (leaveUntouched) {
-                outputFile = outputPath;
-            } else {
-                Glib::ustring s = outputPath;
+            rtengine::InitialImage* ii = nullptr;
+            rtengine::ProcessingJob* job = nullptr;
+            int errorCode;
+            bool isRaw = false;
+
+            Glib::ustring outputFile;
+
+            if ( outputPath.empty() ) {
+                Glib::ustring s = inputFile;
                 Glib::ustring::size_type ext = s.find_last_of ('.');
                 outputFile = s.substr (0, ext) + "." + outputType;
+            } else if ( outputDirectory ) {
+                Glib::ustring s = Glib::path_get_basename ( inputFile );
+                Glib::ustring::size_type ext = s.find_last_of ('.');
+                outputFile = Glib::build_filename (outputPath, s.substr (0, ext) + "." + outputType);
+            } else {
+                if (leaveUntouched) {
+                    outputFile = outputPath;
+                } else {
+                    Glib::ustring s = outputPath;
+                    Glib::ustring::size_type ext = s.find_last_of ('.');
+                    outputFile = s.substr (0, ext) + "." + outputType;
+                }
             }
-        }
 
-        if ( inputFile == outputFile) {
-            std::cerr << "Cannot overwrite: " << inputFile << std::endl;
-            continue;
-        }
+            // One output per variant profile, or a single one if there are none
+            std::vector<OutputVariant> outputs;
 
-        if ( !overwriteFiles && Glib::file_test ( outputFile, Glib::FILE_TEST_EXISTS ) ) {
-            std::cerr << outputFile  << " already exists: use -Y option to overwrite. This image has been skipped." << std::endl;
-            continue;
-        }
+            if (variants.empty()) {
+                outputs.push_back ({outputFile, nullptr});
+            } else {
+                for (const auto& variant : variants) {
+                    Glib::ustring variantFile = outputFile;
+
+                    if (!leaveUntouched) {
+                        Glib::ustring::size_type ext = variantFile.find_last_of ('.');
+                        variantFile = variantFile.substr (0, ext) + "_" + variant.name + "." + outputType;
+                    }
 
-        // Load the image
-        isRaw = true;
-        Glib::ustring ext = getExtension (inputFile);
+                    outputs.push_back ({variantFile, variant.profile});
+                }
+            }
 
-        if (ext.lowercase() == "jpg" || ext.lowercase() == "jpeg" || ext.lowercase() == "tif" || ext.lowercase() == "tiff" || ext.lowercase() == "png") {
-            isRaw = false;
-        }
+            for (auto it = outputs.begin(); it != outputs.end();) {
+                if ( inputFile == it->file) {
+                    log.err() << "Cannot overwrite: " << inputFile << std::endl;
+                    it = outputs.erase (it);
+                } else if ( !overwriteFiles && Glib::file_test ( it->file, Glib::FILE_TEST_EXISTS ) ) {
+                    log.err() << it->file  << " already exists: use -Y option to overwrite. This image has been skipped." << std::endl;
+                    it = outputs.erase (it);
+                } else {
+                    ++it;
+                }
+            }
 
-        ii = rtengine::InitialImage::load ( inputFile, isRaw, &errorCode, nullptr );
+            if (outputs.empty()) {
+                return;
+            }
 
-        if (!ii) {
-            errors++;
-            std::cerr << "Error loading file: " << inputFile << std::endl;
-            continue;
-        }
+            // Load the image
+            isRaw = true;
+            Glib::ustring ext = getExtension (inputFile);
+
+            if (ext.lowercase() == "jpg" || ext.lowercase() == "jpeg" || ext.lowercase() == "tif" || ext.lowercase() == "tiff" || ext.lowercase() == "png") {
+                isRaw = false;
+            }
+
+            ii = rtengine::InitialImage::load ( inputFile, isRaw, &errorCode, nullptr );
+
+            if (!ii) {
+                errors++;
+                log.err() << "Error loading file: " << inputFile << std::endl;
+                return;
+            }
 
-        if (useDefault) {
-            if (isRaw) {
-                if (options.defProfRaw == DEFPROFILE_DYNAMIC) {
-                    rawParams->deleteInstance();
-                    delete rawParams;
-                    rawParams = ProfileStore::getInstance()->loadDynamicProfile (ii->getMetaData(), inputFile);
+            if (useDefault) {
+                const bool isDynamic = isRaw ? options.defProfRaw == DEFPROFILE_DYNAMIC : options.defProfImg == DEFPROFILE_DYNAMIC;
+
+                if (isDynamic) {
+                    rtengine::procparams::PartialProfile* dynamicParams;
+                    {
+                        std::lock_guard<std::mutex> lock (profileMutex);
+                        dynamicParams = ProfileStore::getInstance()->loadDynamicProfile (ii->getMetaData(), inputFile);
+                    }
+                    log.out() << "  Merging default " << (isRaw ? "raw" : "non-raw") << " processing profile." << std::endl;
+                    dynamicParams->applyTo (&currentParams);
+                    dynamicParams->deleteInstance();
+                    delete dynamicParams;
+                } else if (isRaw) {
+                    log.out() << "  Merging default raw processing profile." << std::endl;
+                    rawParams->applyTo (&currentParams);
+                } else {
+                    log.out() << "  Merging default non-raw processing profile." << std::endl;
+                    imgParams->applyTo (&currentParams);
                 }
+            }
 
-                std::cout << "  Merging default raw processing profile." << std::endl;
-                rawParams->applyTo (&currentParams);
-            } else {
-                if (options.defProfImg == DEFPROFILE_DYNAMIC) {
-                    imgParams->deleteInstance();
-                    delete imgParams;
-                    imgParams = ProfileStore::getInstance()->loadDynamicProfile (ii->getMetaData(), inputFile);
+            bool sideCarFound = false;
+            unsigned int i = 0;
+
+            // Iterate the procparams file list in order to build the final ProcParams
+            do {
+                if (sideProcParams && i == sideCarFilePos) {
+                    // using the sidecar file
+                    Glib::ustring sideProcessingParams = inputFile + paramFileExtension;
+
+                    // the "load" method don't reset the procparams values anymore, so values found in the procparam file override the one of currentParams
+                    if ( !Glib::file_test ( sideProcessingParams, Glib::FILE_TEST_EXISTS ) || currentParams.load ( sideProcessingParams )) {
+                        log.err() << "Warning: sidecar file requested but not found for: " << sideProcessingParams << std::endl;
+                    } else {
+                        sideCarFound = true;
+                        log.out() << "  Merging sidecar procparams." << std::endl;
+                    }
                 }
 
-                std::cout << "  Merging default non-raw processing profile." << std::endl;
-                imgParams->applyTo (&currentParams);
+                if ( processingParams.size() > i  ) {
+                    log.out() << "  Merging procparams #" << i << std::endl;
+                    processingParams[i]->applyTo (&currentParams);
+                }
+
+                i++;
+            } while (i < processingParams.size() + (sideProcParams ? 1 : 0));
+
+            if ( sideProcParams && !sideCarFound && skipIfNoSidecar ) {
+                delete ii;
+                errors++;
+                log.err() << "Error: no sidecar procparams found for: " << inputFile << std::endl;
+                return;
             }
-        }
 
-        bool sideCarFound = false;
-        unsigned int i = 0;
+            const auto saveImage =
+                [&] (rtengine::IImagefloat* resultImage, const Glib::ustring& outputFile, rtengine::procparams::ProcParams& imageParams)
+                {
+                    // save image to disk
+                    if ( outputType == "jpg" ) {
+                        errorCode = resultImage->saveAsJPEG ( outputFile, compression, subsampling );
+                    } else if ( outputType == "tif" ) {
+                        errorCode = resultImage->saveAsTIFF ( outputFile, bits, isFloat, compression == 0  );
+                    } else if ( outputType == "png" ) {
+                        errorCode = resultImage->saveAsPNG ( outputFile, bits );
+#ifdef LIBJXL
+                    } else if ( outputType == "jxl" ) {
+                        errorCode = resultImage->saveAsJXL ( outputFile, bits, isFloat, jxlLossless, jxlDistance );
+#endif
+                    } else {
+                        errorCode = resultImage->saveToFile (outputFile);
+                    }
+
+                    if (errorCode) {
+                        errors++;
+                        log.err() << "Error saving to: " << outputFile << std::endl;
+                    } else {
+                        if ( copyParamsFile ) {
+                            Glib::ustring outputProcessingParams = outputFile + paramFileExtension;
+                            imageParams.save ( outputProcessingParams );
+                        }
+                    }
+
+                    delete resultImage;
+                };
 
-        // Iterate the procparams file list in order to build the final ProcParams
-        do {
-            if (sideProcParams && i == sideCarFilePos) {
-                // using the sidecar file
-                Glib::ustring sideProcessingParams = inputFile + paramFileExtension;
+            if (!variants.empty()) {
+                // Decode and demosaic once, then render every variant from the shared image source
+                std::vector<rtengine::procparams::ProcParams> variantParams (outputs.size(), currentParams);
+                std::vector<rtengine::ProcessingJob*> jobs;
 
-                // the "load" method don't reset the procparams values anymore, so values found in the procparam file override the one of currentParams
-                if ( !Glib::file_test ( sideProcessingParams, Glib::FILE_TEST_EXISTS ) || currentParams.load ( sideProcessingParams )) {
-                    std::cerr << "Warning: sidecar file requested but not found for: " << sideProcessingParams << std::endl;
-                } else {
-                    sideCarFound = true;
-                    std::cout << "  Merging sidecar procparams." << std::endl;
+                for (size_t v = 0; v < outputs.size(); ++v) {
+                    log.out() << "  Merging variant procparams for " << outputs[v].file << std::endl;
+                    outputs[v].profile->applyTo (&variantParams[v]);
+                    jobs.push_back (rtengine::ProcessingJob::create (ii, variantParams[v], fast_export));
+                }
+
+                std::vector<int> errorCodes;
+                const std::vector<rtengine::IImagefloat*> resultImages = rtengine::processImages (jobs, errorCodes, nullptr);
+
+                for (size_t v = 0; v < outputs.size(); ++v) {
+                    if ( !resultImages[v] ) {
+                        errors++;
+                        log.err() << "Error processing: " << inputFile << " for " << outputs[v].file << std::endl;
+                    } else {
+                        saveImage (resultImages[v], outputs[v].file, variantParams[v]);
+                    }
                 }
+
+                ii->decreaseRef();
+                return;
             }
 
-            if ( processingParams.size() > i  ) {
-                std::cout << "  Merging procparams #" << i << std::endl;
-                processingParams[i]->applyTo (&currentParams);
+            job = rtengine::ProcessingJob::create (ii, currentParams, fast_export);
+
+            if ( !job ) {
+                errors++;
+                log.err() << "Error creating processing for: " << inputFile << std::endl;
+                ii->decreaseRef();
+                return;
             }
 
-            i++;
-        } while (i < processingParams.size() + (sideProcParams ? 1 : 0));
+            // Process image
+            rtengine::IImagefloat* resultImage = rtengine::processImage (job, errorCode, nullptr);
 
-        if ( sideProcParams && !sideCarFound && skipIfNoSidecar ) {
-            delete ii;
-            errors++;
-            std::cerr << "Error: no sidecar procparams found for: " << inputFile << std::endl;
-            continue;
-        }
+            if ( !resultImage ) {
+                errors++;
+                log.err() << "Error processing: " << inputFile << std::endl;
+                rtengine::ProcessingJob::destroy ( job );
+                return;
+            }
 
-        job = rtengine::ProcessingJob::create (ii, currentParams, fast_export);
+            saveImage (resultImage, outputs.front().file, currentParams);
 
-        if ( !job ) {
-            errors++;
-            std::cerr << "Error creating processing for: " << inputFile << std::endl;
             ii->decreaseRef();
-            continue;
+        };
+
+    if (numJobs <= 1) {
+        for (const auto& inputFile : inputFiles) {
+            processFile (inputFile);
         }
+    } else {
+        // Keep several images in flight, splitting the OpenMP thread budget between them
+#ifdef _OPENMP
+        const int threadsPerJob = std::max (1, omp_get_max_threads() / static_cast<int> (numJobs));
+#endif
+        std::cout << "Processing " << inputFiles.size() << " files with " << numJobs << " concurrent jobs." << std::endl;
 
-        // Process image
-        rtengine::IImagefloat* resultImage = rtengine::processImage (job, errorCode, nullptr);
+        std::atomic<size_t> nextFile (0);
+        std::vector<std::thread> workers;
 
-        if ( !resultImage ) {
-            errors++;
-            std::cerr << "Error processing: " << inputFile << std::endl;
-            rtengine::ProcessingJob::destroy ( job );
-            continue;
-        }
+        for (unsigned int j = 0; j < numJobs; ++j) {
+            workers.emplace_back (
+                [&]()
+                {
+#ifdef _OPENMP
+                    omp_set_num_threads (threadsPerJob);
+#endif
 
-        // save image to disk
-        if ( outputType == "jpg" ) {
-            errorCode = resultImage->saveAsJPEG ( outputFile, compression, subsampling );
-        } else if ( outputType == "tif" ) {
-            errorCode = resultImage->saveAsTIFF ( outputFile, bits, isFloat, compression == 0  );
-        } else if ( outputType == "png" ) {
-            errorCode = resultImage->saveAsPNG ( outputFile, bits );
-        } else {
-            errorCode = resultImage->saveToFile (outputFile);
+                    for (size_t iFile = nextFile++; iFile < inputFiles.size(); iFile = nextFile++) {
+                        processFile (inputFiles[iFile]);
+                    }
+                }
+            );
         }
 
-        if (errorCode) {
-            errors++;
-            std::cerr << "Error saving to: " << outputFile << std::endl;
-        } else {
-            if ( copyParamsFile ) {
-                Glib::ustring outputProcessingParams = outputFile + paramFileExtension;
-                currentParams.save ( outputProcessingParams );
-            }
+        for (auto& worker : workers) {
+            worker.join();
         }
-
-        ii->decreaseRef();
-        delete resultImage;
     }
 
     if (imgParams) {
@@ -832,5 +1108,10 @@ int processLineParams ( int argc, char **argv )
 
     deleteProcParams (processingParams);
 
+    for (auto& variant : variants) {
+        variant.profile->deleteInstance();
+        delete variant.profile;
+    }
+
     return errors > 0 ? -2 : 0;
 }
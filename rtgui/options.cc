@@ -318,6 +318,11 @@ void Options::setDefaults()
     saveFormat.tiffFloat = false;
     saveFormat.tiffUncompressed = true;
     saveFormat.bigTiff = false;
+    saveFormat.jxlBits = 16;
+    saveFormat.jxlFloat = false;
+    saveFormat.jxlLossless = true;
+    saveFormat.jxlDistance = 1.0;
+    saveFormat.jxlEffort = 7;
     saveFormat.saveParams = true;
 
     saveFormatBatch.format = "jpg";
@@ -327,6 +332,11 @@ void Options::setDefaults()
     saveFormatBatch.tiffBits = 16;
     saveFormatBatch.tiffFloat = false;
     saveFormatBatch.tiffUncompressed = true;
+    saveFormatBatch.jxlBits = 16;
+    saveFormatBatch.jxlFloat = false;
+    saveFormatBatch.jxlLossless = true;
+    saveFormatBatch.jxlDistance = 1.0;
+    saveFormatBatch.jxlEffort = 7;
     saveFormatBatch.saveParams = true;
 
     savePathTemplate = "%p1/converted/%f";
@@ -484,6 +494,7 @@ void Options::setDefaults()
 #endif
     filledProfile = false;
     maxInspectorBuffers = 2; //  a rather conservative value for low specced systems...
+    batchEncoderMemory = 1024;
     inspectorDelay = 0;
     serializeTiffRead = true;
     measure = false;
@@ -622,6 +633,16 @@ void Options::setDefaults()
     rtSettings.ACESp0 = "RTv2_ACES-AP0";
     rtSettings.ACESp1 = "RTv2_ACES-AP1";
     rtSettings.verbose = false;
+    rtSettings.pipelineTraceFile = "";
+    rtSettings.exportMemoryBudget = 0;
+    rtSettings.bufferPoolSize = 256;
+    rtSettings.pyramidBlur = false;
+    rtSettings.progressivePreview = 256;
+    rtSettings.tiffCompression = 0;
+    rtSettings.tiffPredictor = true;
+    rtSettings.pngFilter = 4;
+    rtSettings.pngCompression = 6;
+    rtSettings.pngStrategy = 3;
     rtSettings.gamutICC = true;
     rtSettings.gamutLch = true;
     rtSettings.amchroma = 40;//between 20 and 140   low values increase effect..and also artifacts, high values reduces
@@ -1080,6 +1101,26 @@ void Options::readFromFile(Glib::ustring fname)
                     saveFormat.bigTiff = keyFile.get_boolean("Output", "BigTiff");
                 }
 
+                if (keyFile.has_key("Output", "JxlBps")) {
+                    saveFormat.jxlBits = keyFile.get_integer("Output", "JxlBps");
+                }
+
+                if (keyFile.has_key("Output", "JxlFloat")) {
+                    saveFormat.jxlFloat = keyFile.get_boolean("Output", "JxlFloat");
+                }
+
+                if (keyFile.has_key("Output", "JxlLossless")) {
+                    saveFormat.jxlLossless = keyFile.get_boolean("Output", "JxlLossless");
+                }
+
+                if (keyFile.has_key("Output", "JxlDistance")) {
+                    saveFormat.jxlDistance = keyFile.get_double("Output", "JxlDistance");
+                }
+
+                if (keyFile.has_key("Output", "JxlEffort")) {
+                    saveFormat.jxlEffort = keyFile.get_integer("Output", "JxlEffort");
+                }
+
                 if (keyFile.has_key("Output", "SaveProcParams")) {
                     saveFormat.saveParams = keyFile.get_boolean("Output", "SaveProcParams");
                 }
@@ -1113,10 +1154,50 @@ void Options::readFromFile(Glib::ustring fname)
                     saveFormatBatch.tiffUncompressed = keyFile.get_boolean("Output", "TiffUncompressedBatch");
                 }
 
+                if (keyFile.has_key("Output", "JxlBpsBatch")) {
+                    saveFormatBatch.jxlBits = keyFile.get_integer("Output", "JxlBpsBatch");
+                }
+
+                if (keyFile.has_key("Output", "JxlFloatBatch")) {
+                    saveFormatBatch.jxlFloat = keyFile.get_boolean("Output", "JxlFloatBatch");
+                }
+
+                if (keyFile.has_key("Output", "JxlLosslessBatch")) {
+                    saveFormatBatch.jxlLossless = keyFile.get_boolean("Output", "JxlLosslessBatch");
+                }
+
+                if (keyFile.has_key("Output", "JxlDistanceBatch")) {
+                    saveFormatBatch.jxlDistance = keyFile.get_double("Output", "JxlDistanceBatch");
+                }
+
+                if (keyFile.has_key("Output", "JxlEffortBatch")) {
+                    saveFormatBatch.jxlEffort = keyFile.get_integer("Output", "JxlEffortBatch");
+                }
+
                 if (keyFile.has_key("Output", "SaveProcParamsBatch")) {
                     saveFormatBatch.saveParams = keyFile.get_boolean("Output", "SaveProcParamsBatch");
                 }
 
+                if (keyFile.has_key("Output", "TiffCompression")) {
+                    rtSettings.tiffCompression = std::min(1, std::max(0, keyFile.get_integer("Output", "TiffCompression")));
+                }
+
+                if (keyFile.has_key("Output", "TiffPredictor")) {
+                    rtSettings.tiffPredictor = keyFile.get_boolean("Output", "TiffPredictor");
+                }
+
+                if (keyFile.has_key("Output", "PngFilter")) {
+                    rtSettings.pngFilter = std::min(5, std::max(0, keyFile.get_integer("Output", "PngFilter")));
+                }
+
+                if (keyFile.has_key("Output", "PngCompression")) {
+                    rtSettings.pngCompression = std::min(9, std::max(0, keyFile.get_integer("Output", "PngCompression")));
+                }
+
+                if (keyFile.has_key("Output", "PngStrategy")) {
+                    rtSettings.pngStrategy = std::min(3, std::max(0, keyFile.get_integer("Output", "PngStrategy")));
+                }
+
                 if (keyFile.has_key("Output", "Path")) {
                     savePathTemplate = keyFile.get_string("Output", "Path");
                 }
@@ -1468,6 +1549,30 @@ void Options::readFromFile(Glib::ustring fname)
                     chunkSizeXT = std::min(16, std::max(1, keyFile.get_integer("Performance", "ChunkSizeXT")));
                 }
 
+                if (keyFile.has_key("Performance", "PipelineTraceFile")) {
+                    rtSettings.pipelineTraceFile = keyFile.get_string("Performance", "PipelineTraceFile");
+                }
+
+                if (keyFile.has_key("Performance", "ExportMemoryBudget")) {
+                    rtSettings.exportMemoryBudget = std::max(0, keyFile.get_integer("Performance", "ExportMemoryBudget"));
+                }
+
+                if (keyFile.has_key("Performance", "PyramidBlur")) {
+                    rtSettings.pyramidBlur = keyFile.get_boolean("Performance", "PyramidBlur");
+                }
+
+                if (keyFile.has_key("Performance", "ProgressivePreview")) {
+                    rtSettings.progressivePreview = std::max(0, keyFile.get_integer("Performance", "ProgressivePreview"));
+                }
+
+                if (keyFile.has_key("Performance", "BatchEncoderMemory")) {
+                    batchEncoderMemory = std::max(0, keyFile.get_integer("Performance", "BatchEncoderMemory"));
+                }
+
+                if (keyFile.has_key("Performance", "BufferPoolSize")) {
+                    rtSettings.bufferPoolSize = std::max(0, keyFile.get_integer("Performance", "BufferPoolSize"));
+                }
+
                 if (keyFile.has_key("Performance", "ThumbnailInspectorMode")) {
                     rtSettings.thumbnail_inspector_mode = static_cast<rtengine::Settings::ThumbnailInspectorMode>(keyFile.get_integer("Performance", "ThumbnailInspectorMode"));
                 }
@@ -2546,6 +2651,12 @@ void Options::saveToFile(Glib::ustring fname)
         keyFile.set_integer("Performance", "ChunkSizeXT", chunkSizeXT);
         keyFile.set_integer("Performance", "ChunkSizeCA", chunkSizeCA);
         keyFile.set_integer("Performance", "ThumbnailInspectorMode", int(rtSettings.thumbnail_inspector_mode));
+        keyFile.set_string("Performance", "PipelineTraceFile", rtSettings.pipelineTraceFile);
+        keyFile.set_integer("Performance", "ExportMemoryBudget", rtSettings.exportMemoryBudget);
+        keyFile.set_integer("Performance", "BufferPoolSize", rtSettings.bufferPoolSize);
+        keyFile.set_boolean("Performance", "PyramidBlur", rtSettings.pyramidBlur);
+        keyFile.set_integer("Performance", "ProgressivePreview", rtSettings.progressivePreview);
+        keyFile.set_integer("Performance", "BatchEncoderMemory", batchEncoderMemory);
 
 
         keyFile.set_string("Output", "Format", saveFormat.format);
@@ -2556,6 +2667,11 @@ void Options::saveToFile(Glib::ustring fname)
         keyFile.set_boolean("Output", "TiffFloat", saveFormat.tiffFloat);
         keyFile.set_boolean("Output", "TiffUncompressed", saveFormat.tiffUncompressed);
         keyFile.set_boolean("Output", "BigTiff", saveFormat.bigTiff);
+        keyFile.set_integer("Output", "JxlBps", saveFormat.jxlBits);
+        keyFile.set_boolean("Output", "JxlFloat", saveFormat.jxlFloat);
+        keyFile.set_boolean("Output", "JxlLossless", saveFormat.jxlLossless);
+        keyFile.set_double("Output", "JxlDistance", saveFormat.jxlDistance);
+        keyFile.set_integer("Output", "JxlEffort", saveFormat.jxlEffort);
         keyFile.set_boolean("Output", "SaveProcParams", saveFormat.saveParams);
 
         keyFile.set_string("Output", "FormatBatch", saveFormatBatch.format);
@@ -2565,7 +2681,17 @@ void Options::saveToFile(Glib::ustring fname)
         keyFile.set_integer("Output", "TiffBpsBatch", saveFormatBatch.tiffBits);
         keyFile.set_boolean("Output", "TiffFloatBatch", saveFormatBatch.tiffFloat);
         keyFile.set_boolean("Output", "TiffUncompressedBatch", saveFormatBatch.tiffUncompressed);
+        keyFile.set_integer("Output", "JxlBpsBatch", saveFormatBatch.jxlBits);
+        keyFile.set_boolean("Output", "JxlFloatBatch", saveFormatBatch.jxlFloat);
+        keyFile.set_boolean("Output", "JxlLosslessBatch", saveFormatBatch.jxlLossless);
+        keyFile.set_double("Output", "JxlDistanceBatch", saveFormatBatch.jxlDistance);
+        keyFile.set_integer("Output", "JxlEffortBatch", saveFormatBatch.jxlEffort);
         keyFile.set_boolean("Output", "SaveProcParamsBatch", saveFormatBatch.saveParams);
+        keyFile.set_integer("Output", "TiffCompression", rtSettings.tiffCompression);
+        keyFile.set_boolean("Output", "TiffPredictor", rtSettings.tiffPredictor);
+        keyFile.set_integer("Output", "PngFilter", rtSettings.pngFilter);
+        keyFile.set_integer("Output", "PngCompression", rtSettings.pngCompression);
+        keyFile.set_integer("Output", "PngStrategy", rtSettings.pngStrategy);
 
         keyFile.set_string("Output", "PathTemplate", savePathTemplate);
         keyFile.set_string("Output", "PathFolder", savePathFolder);
@@ -3047,6 +3173,8 @@ void Options::load(bool lightweight)
 
     langMgr.load(options.language, {localeTranslation, languageTranslation, defaultTranslation});
 
+    options.rtSettings.fftwWisdomFile = Glib::build_filename(cacheBaseDir, "fftw-wisdom");
+
     rtengine::init(&options.rtSettings, argv0, rtdir, !lightweight);
 }
 
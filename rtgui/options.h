@@ -84,6 +84,11 @@ struct SaveFormat {
         tiffFloat(_tiff_float),
         tiffUncompressed(_tiff_uncompressed),
         bigTiff(_big_tiff),
+        jxlBits(16),
+        jxlFloat(false),
+        jxlLossless(true),
+        jxlDistance(1.0),
+        jxlEffort(7),
         saveParams(_save_params)
     {
     }
@@ -119,6 +124,11 @@ struct SaveFormat {
     bool tiffFloat;
     bool tiffUncompressed;
     bool bigTiff;
+    int jxlBits;
+    bool jxlFloat;
+    bool jxlLossless;
+    double jxlDistance; // Butteraugli distance of the lossy mode
+    int jxlEffort;      // 1=fastest, 9=smallest file
     bool saveParams;
 };
 
@@ -402,6 +412,7 @@ public:
     int maxInspectorBuffers;   // maximum number of buffers (i.e. images) for the Inspector feature
     int inspectorDelay;
     int clutCacheSize;
+    int batchEncoderMemory;    // MiB of processed images the batch queue may keep waiting for their encoder ; 0 = save in the processing thread
     bool filledProfile;  // Used as reminder for the ProfilePanel "mode"
     prevdemo_t prevdemo; // Demosaicing method used for the <100% preview
     bool serializeTiffRead;
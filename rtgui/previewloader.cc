@@ -19,10 +19,12 @@
 
 #include <memory>
 #include <set>
+#include <utility>
 #include "cachemanager.h"
 #include "filebrowserentry.h"
 #include "previewloader.h"
 #include "guiutils.h"
+#include "priorityjobqueue.h"
 #include "threadutils.h"
 
 #ifdef _OPENMP
@@ -61,18 +63,8 @@ public:
             FileBrowserEntry* fdn;
         };
     */
-    struct JobCompare {
-        bool operator()(const Job& lhs, const Job& rhs) const
-        {
-            if ( lhs.dir_id_ == rhs.dir_id_ ) {
-                return lhs.dir_entry_ < rhs.dir_entry_;
-            }
-
-            return lhs.dir_id_ < rhs.dir_id_;
-        }
-    };
-
-    typedef std::set<Job, JobCompare> JobSet;
+    // Jobs are tagged with their listener and run in the order they were added
+    typedef PriorityJobQueue<Job, 1> JobQueue;
 
     Impl(): nConcurrentThreads(0)
     {
@@ -87,7 +79,8 @@ public:
 
     std::unique_ptr<Glib::ThreadPool> threadPool_;
     MyMutex mutex_;
-    JobSet jobs_;
+    JobQueue jobs_;
+    std::set<std::pair<int, Glib::ustring>> queued_;
     gint nConcurrentThreads;
 // Issue 2406   std::vector<OutputJob *> output_;
 
@@ -99,14 +92,13 @@ public:
             MyMutex::MyLock lock(mutex_);
 
             // nothing to do; could be jobs have been removed
-            if ( jobs_.empty() ) {
+            if ( !jobs_.pop(j) ) {
                 DEBUG("processing: nothing to do");
                 return;
             }
 
-            // copy and remove front job
-            j = *jobs_.begin();
-            jobs_.erase(jobs_.begin());
+            queued_.erase(std::make_pair(j.dir_id_, j.dir_entry_));
+
             DEBUG("processing %s", j.dir_entry_.c_str());
             DEBUG("%d job(s) remaining", jobs_.size());
             /* Issue 2406
@@ -188,9 +180,14 @@ void PreviewLoader::add(int dir_id, const Glib::ustring& dir_entry, PreviewLoade
         {
             MyMutex::MyLock lock(impl_->mutex_);
 
+            // the entry may already be queued
+            if (!impl_->queued_.emplace(dir_id, dir_entry).second) {
+                return;
+            }
+
             // create a new job and append to queue
             DEBUG("saving job %s", dir_entry.c_str());
-            impl_->jobs_.insert(Impl::Job(dir_id, dir_entry, l));
+            impl_->jobs_.push(l, 0, Impl::Job(dir_id, dir_entry, l));
         }
 
         // queue a run request
@@ -204,6 +201,7 @@ void PreviewLoader::removeAllJobs()
     DEBUG("stop %d", impl_->nConcurrentThreads);
     MyMutex::MyLock lock(impl_->mutex_);
     impl_->jobs_.clear();
+    impl_->queued_.clear();
 }
 
 
@@ -0,0 +1,242 @@
+/*
+ *  This file is part of RawTherapee.
+ *
+ *  Copyright (c) 2026 Rawtherapee developers
+ *
+ *  RawTherapee is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  RawTherapee is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rtengine/noncopyable.h"
+
+/**
+ * @brief Job queue with a fixed number of priority levels, used by the thumbnail schedulers.
+ *
+ * Jobs are taken from the lowest non-empty level first, in insertion order within a level. Every job has a tag
+ * (e.g. the browser entry it is for): all the jobs of a tag can be found, moved to another level or cancelled
+ * without scanning the whole queue. Moved and cancelled jobs leave a stale slot behind them, which is skipped
+ * when it reaches the front of its level or dropped when the stale slots outnumber the jobs.
+ *
+ * The queue is not thread safe, the caller has to protect it.
+ */
+template<typename Job, std::size_t LEVELS>
+class PriorityJobQueue :
+    public rtengine::NonCopyable
+{
+public:
+    PriorityJobQueue() : count(0) {}
+
+    /** Adds a job at the end of the given level. */
+    void push(const void* tag, std::size_t level, const Job& job)
+    {
+        const auto item = std::make_shared<Item>(Item{job, tag, level, 0, false});
+        levels[level].emplace_back(item, 0);
+        tags[tag].push_back(item);
+        ++count;
+    }
+
+    /** Removes the first job of the highest priority level.
+      * @return false if the queue is empty */
+    bool pop(Job& job)
+    {
+        for (std::size_t level = 0; level < LEVELS; ++level) {
+            auto& queue = levels[level];
+
+            while (!queue.empty()) {
+                const auto item = queue.front().first;
+                const bool stale = item->cancelled || item->slot != queue.front().second;
+                queue.pop_front();
+
+                if (stale) {
+                    continue;
+                }
+
+                job = item->job;
+                erase(item);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /** @return the first queued job of the tag satisfying the predicate, or nullptr */
+    template<typename Predicate>
+    Job* find(const void* tag, Predicate predicate)
+    {
+        const auto iterator = tags.find(tag);
+
+        if (iterator != tags.end()) {
+            for (const auto& item : iterator->second) {
+                if (predicate(item->job)) {
+                    return &item->job;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    /** Moves the jobs of the tag to the level returned by getLevel(job), at the end of it. */
+    template<typename GetLevel>
+    void setLevel(const void* tag, GetLevel getLevel)
+    {
+        const auto iterator = tags.find(tag);
+
+        if (iterator == tags.end()) {
+            return;
+        }
+
+        for (const auto& item : iterator->second) {
+            const std::size_t level = getLevel(item->job);
+
+            if (level != item->level) {
+                item->level = level;
+                levels[level].emplace_back(item, ++item->slot);
+            }
+        }
+
+        compactIfNeeded();
+    }
+
+    /** Cancels all the jobs of the tag. */
+    void remove(const void* tag)
+    {
+        const auto iterator = tags.find(tag);
+
+        if (iterator == tags.end()) {
+            return;
+        }
+
+        for (const auto& item : iterator->second) {
+            item->cancelled = true;
+        }
+
+        count -= iterator->second.size();
+        tags.erase(iterator);
+        compactIfNeeded();
+    }
+
+    /** Cancels the jobs satisfying the predicate, whatever their tag. */
+    template<typename Predicate>
+    void removeIf(Predicate predicate)
+    {
+        for (auto iterator = tags.begin(); iterator != tags.end();) {
+            auto& items = iterator->second;
+
+            for (auto item = items.begin(); item != items.end();) {
+                if (predicate((*item)->job)) {
+                    (*item)->cancelled = true;
+                    item = items.erase(item);
+                    --count;
+                } else {
+                    ++item;
+                }
+            }
+
+            iterator = items.empty() ? tags.erase(iterator) : std::next(iterator);
+        }
+
+        compactIfNeeded();
+    }
+
+    void clear()
+    {
+        for (auto& queue : levels) {
+            queue.clear();
+        }
+
+        tags.clear();
+        count = 0;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+
+private:
+    struct Item {
+        Job job;
+        const void* tag;
+        std::size_t level;
+        unsigned int slot; // Only the last slot given to the job in the levels is valid
+        bool cancelled;
+    };
+
+    using ItemPtr = std::shared_ptr<Item>;
+    using Slot = std::pair<ItemPtr, unsigned int>;
+
+    std::array<std::deque<Slot>, LEVELS> levels;
+    std::unordered_map<const void*, std::vector<ItemPtr>> tags;
+    std::size_t count;
+
+    void erase(const ItemPtr& item)
+    {
+        auto& items = tags[item->tag];
+
+        for (auto iterator = items.begin(); iterator != items.end(); ++iterator) {
+            if (*iterator == item) {
+                items.erase(iterator);
+                break;
+            }
+        }
+
+        if (items.empty()) {
+            tags.erase(item->tag);
+        }
+
+        --count;
+    }
+
+    // Drops the stale slots once they outnumber the live jobs
+    void compactIfNeeded()
+    {
+        std::size_t slots = 0;
+
+        for (const auto& queue : levels) {
+            slots += queue.size();
+        }
+
+        if (slots <= 2 * count + 64) {
+            return;
+        }
+
+        for (auto& queue : levels) {
+            std::deque<Slot> live;
+
+            for (const auto& slot : queue) {
+                if (!slot.first->cancelled && slot.first->slot == slot.second) {
+                    live.push_back(slot);
+                }
+            }
+
+            queue.swap(live);
+        }
+    }
+};
@@ -75,6 +75,13 @@ SaveAsDialog::SaveAsDialog (const Glib::ustring &initialDir, Gtk::Window* parent
     filter_png->add_pattern("*.png");
     filter_png->add_pattern("*.PNG");
 
+#ifdef LIBJXL
+    filter_jxl = Gtk::FileFilter::create();
+    filter_jxl->set_name(M("SAVEDLG_JXLFILTER"));
+    filter_jxl->add_pattern("*.jxl");
+    filter_jxl->add_pattern("*.JXL");
+#endif
+
     formatChanged (options.saveFormat.format);
 
 // Output Options
@@ -272,6 +279,12 @@ void SaveAsDialog::okPressed ()
             formatOpts->getFormat().format == "png"
             && !rtengine::hasPngExtension(fname)
         )
+#ifdef LIBJXL
+        || (
+            formatOpts->getFormat().format == "jxl"
+            && !rtengine::hasJxlExtension(fname)
+        )
+#endif
     ) {
         // Create dialog to warn user that the filename may have two extensions on the end
         Gtk::MessageDialog msgd(
@@ -342,6 +355,16 @@ void SaveAsDialog::formatChanged(const Glib::ustring& format)
                 return rtengine::hasTiffExtension(filename);
             }
         );
+#ifdef LIBJXL
+    } else if (format == "jxl") {
+        fchooser->set_filter (filter_jxl);
+        sanitize_suffix(
+            [](const Glib::ustring& filename)
+            {
+                return rtengine::hasJxlExtension(filename);
+            }
+        );
+#endif
     }
 }
 
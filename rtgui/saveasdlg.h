@@ -36,6 +36,9 @@ protected:
     Glib::RefPtr<Gtk::FileFilter> filter_jpg;
     Glib::RefPtr<Gtk::FileFilter> filter_tif;
     Glib::RefPtr<Gtk::FileFilter> filter_png;
+#ifdef LIBJXL
+    Glib::RefPtr<Gtk::FileFilter> filter_jxl;
+#endif
     Gtk::RadioButton* saveMethod[3]; /*  0 -> immediately
                                       *  1 -> putToQueueHead
                                       *  2 -> putToQueueTail
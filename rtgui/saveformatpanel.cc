@@ -16,8 +16,8 @@
  *  You should have received a copy of the GNU General Public License
  *  along with RawTherapee.  If not, see <https://www.gnu.org/licenses/>.
  */
-#include <array>
 #include <utility>
+#include <vector>
 
 #include "saveformatpanel.h"
 #include "multilangmgr.h"
@@ -26,15 +26,31 @@
 namespace
 {
 
-const std::array<std::pair<const char*, SaveFormat>, 7> sf_templates = {{
+#ifdef LIBJXL
+SaveFormat jxlFormat(int bits, bool isFloat)
+{
+    SaveFormat sf("jxl", 8, 8, false);
+    sf.jxlBits = bits;
+    sf.jxlFloat = isFloat;
+    return sf;
+}
+#endif
+
+const std::vector<std::pair<const char*, SaveFormat>> sf_templates = {
      {"JPEG (8-bit)", SaveFormat("jpg", 8, 8, false)},
      {"TIFF (8-bit)", SaveFormat("tif", 8, 8, false)},
      {"TIFF (16-bit)", SaveFormat("tif", 8, 16, false)},
      {"TIFF (16-bit float)", SaveFormat("tif", 8, 16, true)},
      {"TIFF (32-bit float)", SaveFormat("tif", 8, 32, true)},
      {"PNG (8-bit)", SaveFormat("png", 8, 8, false)},
-     {"PNG (16-bit)", SaveFormat("png", 16, 8, false)}
-}};
+     {"PNG (16-bit)", SaveFormat("png", 16, 8, false)},
+#ifdef LIBJXL
+     {"JPEG XL (8-bit)", jxlFormat(8, false)},
+     {"JPEG XL (16-bit)", jxlFormat(16, false)},
+     {"JPEG XL (16-bit float)", jxlFormat(16, true)},
+     {"JPEG XL (32-bit float)", jxlFormat(32, true)},
+#endif
+};
 
 }
 
@@ -105,6 +121,32 @@ SaveFormatPanel::SaveFormatPanel () : listener (nullptr)
     bigTiff->signal_toggled().connect( sigc::mem_fun(*this, &SaveFormatPanel::formatChanged));
     bigTiff->show_all();
 
+    // ---------------------  JPEG XL OPTIONS
+
+
+    jxlOpts = Gtk::manage (new Gtk::Grid ());
+    jxlOpts->set_column_spacing(15);
+    jxlOpts->set_row_spacing(5);
+    setExpandAlignProperties(jxlOpts, true, false, Gtk::ALIGN_FILL, Gtk::ALIGN_CENTER);
+
+    jxlLossless = Gtk::manage (new Gtk::CheckButton (M("SAVEDLG_JXLLOSSLESS")) );
+    setExpandAlignProperties(jxlLossless, true, false, Gtk::ALIGN_FILL, Gtk::ALIGN_CENTER);
+    jxlLossless->signal_toggled().connect( sigc::mem_fun(*this, &SaveFormatPanel::formatChanged));
+
+    jxlDistance = Gtk::manage (new Adjuster (M("SAVEDLG_JXLDISTANCE"), 0.1, 25.0, 0.1, 1.0) );
+    setExpandAlignProperties(jxlDistance, true, false, Gtk::ALIGN_FILL, Gtk::ALIGN_CENTER);
+    jxlDistance->set_tooltip_text (M("SAVEDLG_JXLDISTANCE_TOOLTIP"));
+    jxlDistance->setAdjusterListener (this);
+
+    jxlEffort = Gtk::manage (new Adjuster (M("SAVEDLG_JXLEFFORT"), 1, 9, 1, 7) );
+    setExpandAlignProperties(jxlEffort, true, false, Gtk::ALIGN_FILL, Gtk::ALIGN_CENTER);
+    jxlEffort->setAdjusterListener (this);
+
+    jxlOpts->attach(*jxlLossless, 0, 0, 1, 1);
+    jxlOpts->attach(*jxlDistance, 0, 1, 1, 1);
+    jxlOpts->attach(*jxlEffort, 0, 2, 1, 1);
+    jxlOpts->show_all ();
+
 
     // ---------------------  MAIN BOX
 
@@ -120,7 +162,8 @@ SaveFormatPanel::SaveFormatPanel () : listener (nullptr)
     attach (*jpegOpts, 0, 1, 1, 1);
     attach (*tiffUncompressed, 0, 2, 1, 1);
     attach (*bigTiff, 0, 3, 1, 1);
-    attach (*savesPP, 0, 4, 1, 2);
+    attach (*jxlOpts, 0, 4, 1, 1);
+    attach (*savesPP, 0, 5, 1, 2);
 }
 
 SaveFormatPanel::~SaveFormatPanel () = default;
@@ -138,7 +181,8 @@ void SaveFormatPanel::init (SaveFormat &sf)
         // way is computing a weight for fitting the input
         // to one of the sf_templates.
         // The format field must match exactly, tiffBits,
-        // tiffFloat, and pngBits fields all weigh the same.
+        // tiffFloat, pngBits, jxlBits and jxlFloat fields all
+        // weigh the same.
         // By providing sane sets of parameters in getFormat()
         // we have perfect matches. If the parameters were
         // tampered with, some entry within SaveFormat::format
@@ -148,7 +192,9 @@ void SaveFormatPanel::init (SaveFormat &sf)
             10 * (sf.format == sf_templates[i].second.format)
             + (sf.tiffBits == sf_templates[i].second.tiffBits)
             + (sf.tiffFloat == sf_templates[i].second.tiffFloat)
-            + (sf.pngBits == sf_templates[i].second.pngBits);
+            + (sf.pngBits == sf_templates[i].second.pngBits)
+            + (sf.jxlBits == sf_templates[i].second.jxlBits)
+            + (sf.jxlFloat == sf_templates[i].second.jxlFloat);
 
         if (weight > index.first) {
             index = {weight, i};
@@ -162,6 +208,10 @@ void SaveFormatPanel::init (SaveFormat &sf)
     savesPP->set_active(sf.saveParams);
     tiffUncompressed->set_active(sf.tiffUncompressed);
     bigTiff->set_active(sf.bigTiff);
+    jxlLossless->set_active(sf.jxlLossless);
+    jxlDistance->setValue(sf.jxlDistance);
+    jxlDistance->set_sensitive(!sf.jxlLossless);
+    jxlEffort->setValue(sf.jxlEffort);
 
     listener = tmp;
 }
@@ -180,6 +230,9 @@ SaveFormat SaveFormatPanel::getFormat ()
     sf.jpegSubSamp = jpegSubSamp->get_active_row_number() + 1;
     sf.tiffUncompressed = tiffUncompressed->get_active();
     sf.bigTiff = bigTiff->get_active();
+    sf.jxlLossless = jxlLossless->get_active();
+    sf.jxlDistance = jxlDistance->getValue();
+    sf.jxlEffort = jxlEffort->getIntValue();
     sf.saveParams = savesPP->get_active();
 
     return sf;
@@ -199,14 +252,23 @@ void SaveFormatPanel::formatChanged ()
         jpegOpts->show_all();
         tiffUncompressed->hide();
         bigTiff->hide();
+        jxlOpts->hide();
     } else if (fr == "png") {
         jpegOpts->hide();
         tiffUncompressed->hide();
         bigTiff->hide();
+        jxlOpts->hide();
     } else if (fr == "tif") {
         jpegOpts->hide();
         tiffUncompressed->show_all();
         bigTiff->show_all();
+        jxlOpts->hide();
+    } else if (fr == "jxl") {
+        jpegOpts->hide();
+        tiffUncompressed->hide();
+        bigTiff->hide();
+        jxlOpts->show_all();
+        jxlDistance->set_sensitive(!jxlLossless->get_active());
     }
 
     if (listener) {
@@ -40,6 +40,10 @@ protected:
     Adjuster*           jpegQual;
     Gtk::CheckButton*   tiffUncompressed;
     Gtk::CheckButton*   bigTiff;
+    Gtk::CheckButton*   jxlLossless;
+    Adjuster*           jxlDistance;
+    Adjuster*           jxlEffort;
+    Gtk::Grid*          jxlOpts;
     MyComboBoxText*     format;
     MyComboBoxText*     jpegSubSamp;
     Gtk::Grid*          formatOpts;
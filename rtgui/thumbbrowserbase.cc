@@ -24,6 +24,7 @@
 #include "rtscalable.h"
 #include "thumbbrowserbase.h"
 #include "thumbbrowserentrybase.h"
+#include "thumbimageupdater.h"
 
 #include "rtengine/rt_math.h"
 
@@ -1011,10 +1012,15 @@ bool ThumbBrowserBase::Internal::on_draw(const ::Cairo::RefPtr< Cairo::Context>
         MYWRITERLOCK(l, parent->entryRW);
 
         for (size_t i = 0; i < parent->fd.size() && !dirty; i++) { // if dirty meanwhile, cancel and wait for next redraw
-            if (!parent->fd[i]->drawable || !parent->fd[i]->insideWindow (0, 0, w, h)) {
-                parent->fd[i]->updatepriority = false;
-            } else {
-                parent->fd[i]->updatepriority = true;
+            const bool visible = parent->fd[i]->drawable && parent->fd[i]->insideWindow (0, 0, w, h);
+
+            if (parent->fd[i]->updatepriority != visible) {
+                // the pending thumbnail jobs of the entries that scrolled in (out) of view are moved up (down) the queue
+                parent->fd[i]->updatepriority = visible;
+                thumbImageUpdater->updatePriority (parent->fd[i]);
+            }
+
+            if (visible) {
                 parent->fd[i]->draw (cr);
             }
         }
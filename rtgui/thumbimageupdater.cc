@@ -27,6 +27,7 @@
 #include "thumbbrowserentrybase.h"
 
 #include "guiutils.h"
+#include "priorityjobqueue.h"
 #include "threadutils.h"
 #include "thumbnail.h"
 
@@ -73,7 +74,24 @@ public:
         ThumbImageUpdateListener* listener_;
     };
 
-    typedef std::list<Job> JobList;
+    // Jobs of the visible entries first, then the initial thumbnails, then the upgrades
+    enum Level {
+        VISIBLE,
+        NORMAL,
+        UPGRADE,
+        LEVEL_COUNT
+    };
+
+    typedef PriorityJobQueue<Job, LEVEL_COUNT> JobQueue;
+
+    static std::size_t getLevel(const Job& job)
+    {
+        if (*job.priority_) {
+            return VISIBLE;
+        }
+
+        return job.upgrade_ ? UPGRADE : NORMAL;
+    }
 
     Impl():
         active_(0),
@@ -93,7 +111,7 @@ public:
     // This is the only exceptions along with GThreadMutex (guiutils.cc), MyMutex is used everywhere else
     std::mutex mutex_;
 
-    JobList jobs_;
+    JobQueue jobs_;
 
     std::atomic<unsigned int> active_;
 
@@ -110,42 +128,12 @@ public:
             std::lock_guard<std::mutex> lock(mutex_);
 
             // nothing to do; could be jobs have been removed
-            if ( jobs_.empty() ) {
-                DEBUG("processing: nothing to do (%d)", jobs_.empty());
+            if ( !jobs_.pop(j) ) {
+                DEBUG("processing: nothing to do");
                 return;
             }
 
-            JobList::iterator i;
-
-            // see if any priority jobs exist
-            for ( i = jobs_.begin(); i != jobs_.end(); ++i) {
-                if ( *(i->priority_) ) {
-                    DEBUG("processing(priority) %s", i->tbe_->thumbnail->getFileName().c_str());
-                    break;
-                }
-            }
-
-            // see if any none upgrade jobs exist
-            if ( i == jobs_.end() ) {
-                for ( i = jobs_.begin(); i != jobs_.end(); ++i) {
-                    if ( !i->upgrade_ ) {
-                        DEBUG("processing(not-upgrade) %s", i->tbe_->thumbnail->getFileName().c_str());
-                        break;
-                    }
-                }
-            }
-
-            // if none, then use first
-            if ( i == jobs_.end() ) {
-                i = jobs_.begin();
-                DEBUG("processing(first) %s", i->tbe_->thumbnail->getFileName().c_str());
-            }
-
-            // copy found job
-            j = *i;
-
-            // remove so not run again
-            jobs_.erase(i);
+            DEBUG("processing %s", j.tbe_->thumbnail->getFileName().c_str());
             DEBUG("%d job(s) remaining", int(jobs_.size()) );
 
             ++active_;
@@ -205,31 +193,35 @@ void ThumbImageUpdater::add(ThumbBrowserEntryBase* tbe, bool* priority, bool upg
     std::lock_guard<std::mutex> lock(impl_->mutex_);
 
     // look up if an older version is in the queue
-    Impl::JobList::iterator i(impl_->jobs_.begin());
-
-    for ( ; i != impl_->jobs_.end(); ++i ) {
-        if ( i->tbe_ == tbe &&
-                i->listener_ == l &&
-                i->upgrade_ == upgrade &&
-                i->force_upgrade_ == forceUpgrade) {
-            DEBUG("updating job %s", tbe->shortname.c_str());
-            // we have one, update queue entry, will be picked up by thread when processed
-            /*i->pparams_ = params;
-            i->height_ = height; */
-            i->priority_ = priority;
-            return;
-        }
+    Impl::Job* job = impl_->jobs_.find(tbe, [=](const Impl::Job& j) {
+        return j.listener_ == l && j.upgrade_ == upgrade && j.force_upgrade_ == forceUpgrade;
+    });
+
+    if (job) {
+        DEBUG("updating job %s", tbe->shortname.c_str());
+        // we have one, update queue entry, will be picked up by thread when processed
+        job->priority_ = priority;
+        impl_->jobs_.setLevel(tbe, &Impl::getLevel);
+        return;
     }
 
     // create a new job and append to queue
     DEBUG("queueing job %s", tbe->shortname.c_str());
-    impl_->jobs_.push_back(Impl::Job(tbe, priority, upgrade, forceUpgrade, l));
+    const Impl::Job newJob(tbe, priority, upgrade, forceUpgrade, l);
+    impl_->jobs_.push(tbe, Impl::getLevel(newJob), newJob);
 
     DEBUG("adding run request %s", tbe->shortname.c_str());
     impl_->threadPool_->push(sigc::mem_fun(*impl_, &ThumbImageUpdater::Impl::processNextJob));
 }
 
 
+void ThumbImageUpdater::updatePriority(ThumbBrowserEntryBase* tbe)
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+
+    impl_->jobs_.setLevel(tbe, &Impl::getLevel);
+}
+
 void ThumbImageUpdater::removeJobs(ThumbImageUpdateListener* listener)
 {
     DEBUG("removeJobs(%p)", listener);
@@ -237,15 +229,9 @@ void ThumbImageUpdater::removeJobs(ThumbImageUpdateListener* listener)
     {
         std::lock_guard<std::mutex> lock(impl_->mutex_);
 
-        for( Impl::JobList::iterator i(impl_->jobs_.begin()); i != impl_->jobs_.end(); ) {
-            if (i->listener_ == listener) {
-                DEBUG("erasing specific job");
-                Impl::JobList::iterator e(i++);
-                impl_->jobs_.erase(e);
-            } else {
-                ++i;
-            }
-        }
+        impl_->jobs_.removeIf([listener](const Impl::Job& j) {
+            return j.listener_ == listener;
+        });
     }
 
     while ( impl_->active_ != 0 ) {
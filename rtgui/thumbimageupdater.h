@@ -80,6 +80,16 @@ public:
      */
     void add(ThumbBrowserEntryBase* tbe, bool* priority, bool upgrade, bool forceUpgrade, ThumbImageUpdateListener* l);
 
+    /**
+     * @brief Move the queued jobs of the entry according to its priority flag.
+     *
+     * To be called when the entry scrolls in or out of view: the jobs of the
+     * visible entries run first, the others wait until no visible job is left.
+     *
+     * @param tbe entry whose priority changed
+     */
+    void updatePriority(ThumbBrowserEntryBase* tbe);
+
     /**
      * @brief Remove jobs associated with listener \c l.
      *
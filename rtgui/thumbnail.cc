@@ -294,7 +294,7 @@ void Thumbnail::_generateThumbnailImage()
         _saveThumbnail();
         cfs.supported = true;
 
-        cfs.save(getCacheFileName("data", ".txt"));
+        cachemgr->saveImageData(fname, cfs);
 
         generateExifDateTimeStrings();
     }
@@ -618,7 +618,7 @@ void Thumbnail::imageDeveloped ()
 {
 
     cfs.recentlySaved = true;
-    cfs.save (getCacheFileName ("data", ".txt"));
+    cachemgr->saveImageData (fname, cfs);
 
     if (options.saveParamsCache) {
         pparams->save (getCacheFileName ("profiles", paramFileExtension));
@@ -1075,7 +1075,7 @@ void Thumbnail::updateCache (bool updatePParams, bool updateCacheImageData)
     }
 
     if (updateCacheImageData) {
-        cfs.save (getCacheFileName ("data", ".txt"));
+        cachemgr->saveImageData (fname, cfs);
     }
 
     if (updatePParams && pparamsValid) {